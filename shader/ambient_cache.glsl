@@ -0,0 +1,115 @@
+// World-space ambient occlusion cache, shared by every pixel and bounce which sees a voxel face.
+// Faces are stored in an open-addressed hash table, and the first lookup of a face in a frame traces a few more samples into it,
+// so occlusion converges over frames while costing rays per visible face rather than per pixel.
+// The including shader must include voxel_tracing.glsl, and declare the table as a coherent aoCache buffer of AoCacheEntry.
+
+// Must match AO_CACHE_CAPACITY in parameters.hpp
+const uint AO_CACHE_CAPACITY = 1u << 20;
+// Slots searched for a face before giving up on caching it
+const uint AO_CACHE_PROBES = 8;
+// Samples are halved beyond this, so faces keep adapting to changes in the scene
+const uint AO_CACHE_MAX_SAMPLES = 256;
+// Faces not seen for this many frames give up their slot to new ones
+const uint AO_CACHE_STALE_FRAMES = 600;
+
+// Identifies the face of a surface hit, wrapping around for volumes of more than 2^32 / 6 voxels
+uint aoCacheKey(vec3 pos, vec3 normal)
+{
+    uvec3 voxel = uvec3(clamp(ivec3(floor(pos - normal * 0.5)), ivec3(0), ivec3(pushConstants.volumeBounds) - 1));
+    uint index = (voxel.z * pushConstants.volumeBounds.y + voxel.y) * pushConstants.volumeBounds.x + voxel.x;
+    uint face = uint(round(encodeNormal(normal) * 255.0)) - 1;
+    return index * 6 + face + 1;
+}
+
+// Integer hash from https://nullprogram.com/blog/2018/07/31/
+uint aoCacheHash(uint key)
+{
+    key ^= key >> 16;
+    key *= 0x7feb352du;
+    key ^= key >> 15;
+    key *= 0x846ca68bu;
+    key ^= key >> 16;
+    return key;
+}
+
+// Finds or inserts the slot of a face, returning AO_CACHE_CAPACITY if every probed slot is taken
+uint aoCacheFind(uint key)
+{
+    uint home = aoCacheHash(key);
+    for (uint i = 0; i < AO_CACHE_PROBES; i++)
+    {
+        uint slot = (home + i) & (AO_CACHE_CAPACITY - 1);
+        uint current = atomicCompSwap(aoCache[slot].key, 0, key);
+        if (current == 0 || current == key)
+            return slot;
+    }
+
+    // Slots are never freed, so the face can't be further along once every slot was taken
+    for (uint i = 0; i < AO_CACHE_PROBES; i++)
+    {
+        uint slot = (home + i) & (AO_CACHE_CAPACITY - 1);
+        if (aoCache[slot].lastFrame + AO_CACHE_STALE_FRAMES > pushConstants.frame + 1)
+            continue;
+
+        uint current = aoCache[slot].key;
+        if (atomicCompSwap(aoCache[slot].key, current, key) == current)
+        {
+            aoCache[slot].hits = 0;
+            aoCache[slot].samples = 0;
+            return slot;
+        }
+    }
+    return AO_CACHE_CAPACITY;
+}
+
+// Traces samples from random points on a face, returning how many hit geometry
+uint traceFaceSamples(vec3 pos, vec3 normal, uint key, uint first, uint count)
+{
+    // Seeding the noise from the face keeps its samples well spread across frames
+    vec2 noisePixel = vec2(key % NOISE_SIZE.x, (key / NOISE_SIZE.x) % NOISE_SIZE.y) + 0.5;
+    vec3 faceCenter = floor(pos - normal * 0.5) + 0.5 + normal * 0.5;
+    vec3 tangents = vec3(1.0) - abs(normal);
+
+    uint hits = 0;
+    for (uint i = 0; i < count; i++)
+    {
+        uint sampleIndex = (first + i) * 2;
+        vec3 origin = faceCenter + (noiseSeq(noisePixel, sampleIndex) - 0.5) * 0.98 * tangents;
+        vec3 dir = normal + randomDir(noisePixel, sampleIndex + 1);
+        if (traceRayHit(origin + dir * 0.01, dir, 64, KERNEL_AMBIENT))
+            hits++;
+    }
+    return hits;
+}
+
+// Looks up the fraction of ambient samples from a face which hit geometry, adding sampleCount samples on its first lookup this frame.
+// Returns false while the face has no samples, or can't be cached.
+bool cachedOcclusion(vec3 pos, vec3 normal, uint sampleCount, out float occlusion)
+{
+    occlusion = 0.0;
+    uint key = aoCacheKey(pos, normal);
+    uint slot = aoCacheFind(key);
+    if (slot == AO_CACHE_CAPACITY)
+        return false;
+
+    uint hits = aoCache[slot].hits;
+    uint samples = aoCache[slot].samples;
+    if (atomicExchange(aoCache[slot].lastFrame, pushConstants.frame + 1) != pushConstants.frame + 1)
+    {
+        // Only one invocation updates each face per frame, so its counts can be written without atomics
+        hits += traceFaceSamples(pos, normal, key, samples, sampleCount);
+        samples += sampleCount;
+        if (samples > AO_CACHE_MAX_SAMPLES)
+        {
+            hits /= 2;
+            samples /= 2;
+        }
+        aoCache[slot].hits = hits;
+        aoCache[slot].samples = samples;
+    }
+
+    if (samples == 0)
+        return false;
+    occlusion = min(float(hits) / float(samples), 1.0);
+    return true;
+}
@@ -0,0 +1,44 @@
+// Cone traced ambient occlusion, marching a few cones through the mips of the scene's occupancy.
+// Each mip averages 2x2x2 blocks of the one before, so a cone's footprint is covered by one trilinear fetch per step,
+// giving smooth occlusion at a fixed cost without noise to denoise.
+// The including shader must declare the mips as an occupancy sampler, and pushConstants with the ScreenQuadPush fields.
+
+// Tangent of the cones' half angle, wide enough for five cones to cover the hemisphere
+const float AO_CONE_APERTURE = 0.577;
+// Roughly the reach of the 64 step ambient rays
+const float AO_CONE_MAX_DISTANCE = 32.0;
+
+// Fraction of a cone blocked by geometry, accumulated front to back
+float traceCone(vec3 origin, vec3 dir)
+{
+    float occlusion = 0.0;
+    // Starting a voxel out keeps the surface's own voxel out of the first, finest fetches
+    float dist = 1.0;
+    while (dist < AO_CONE_MAX_DISTANCE && occlusion < 0.99)
+    {
+        float diameter = max(2.0 * AO_CONE_APERTURE * dist, 1.0);
+        vec3 samplePos = origin + dir * dist;
+        float solid = textureLod(occupancy, samplePos / vec3(pushConstants.volumeBounds), log2(diameter)).r;
+        // Steps of half the diameter see each block about twice, so each fetch only counts for half
+        occlusion += (1.0 - occlusion) * (1.0 - sqrt(1.0 - solid));
+        dist += diameter * 0.5;
+    }
+    return occlusion;
+}
+
+// Cosine weighted occlusion of the hemisphere around an axis-aligned surface normal
+float coneOcclusion(vec3 pos, vec3 normal)
+{
+    vec3 tangent = abs(normal.x) > 0.5 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 bitangent = cross(normal, tangent);
+    vec3 origin = pos + normal * 0.5;
+
+    // One cone along the normal, and four tilted 45 degrees towards each side
+    float occlusion = traceCone(origin, normal);
+    float sideOcclusion = traceCone(origin, normalize(normal + tangent))
+        + traceCone(origin, normalize(normal - tangent))
+        + traceCone(origin, normalize(normal + bitangent))
+        + traceCone(origin, normalize(normal - bitangent));
+    const float sideWeight = 0.70710678;
+    return (occlusion + sideOcclusion * sideWeight) / (1.0 + 4.0 * sideWeight);
+}
@@ -0,0 +1,23 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "gbuffer.glsl"
+
+layout (push_constant) uniform constants
+{
+    vec4 camPos;
+    vec4 camDir;
+    vec4 camRight;
+    vec4 camUp;
+    uvec3 volumeBounds;
+    uint frame;
+    ivec2 screenSize;
+    vec2 cameraJitter;
+} pushConstants;
+
+// Marks this frame's half of the checkerboard in the stencil, so the tracer's early stencil test skips the other half
+void main()
+{
+    if (!checkerboardTraced(ivec2(gl_FragCoord.xy), pushConstants.frame))
+        discard;
+}
@@ -1,4 +1,11 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "gbuffer.glsl"
+#include "denoiser.glsl"
+
+// Matches DENOISER_KERNEL_SIZE in denoiser_kernel.hpp
+#define KERNEL_SIZE 9
 
 layout (location = 0) in vec2 vScreenPos;
 
@@ -6,20 +13,25 @@ layout (location = 0) out vec4 outColor;
 
 layout (set = 0, binding = 0) uniform sampler2D inputColor;
 layout (set = 0, binding = 1) uniform sampler2D inputNormal;
-layout (set = 0, binding = 2) uniform sampler2D inputPos;
+layout (set = 0, binding = 2) uniform sampler2D inputDepth;
 layout (set = 0, binding = 3) uniform denoiserParams
 {
     float phiColor;
     float phiNormal;
     float phiPos;
     float stepWidth;
+    float phiLuminance;
+    uint varianceGuided;
+    uint iteration;
 } params;
 layout (set = 0, binding = 4) uniform Kernel {
-    float kernel[9];
+    float kernel[KERNEL_SIZE];
 };
 layout (set = 0, binding = 5) uniform Offsets {
-    vec2 offset[9];
+    vec2 offset[KERNEL_SIZE];
 };
+// Temporal luminance moments, holding the input's variance in z
+layout (set = 0, binding = 6) uniform sampler2D inputMoments;
 
 layout (push_constant) uniform constants
 {
@@ -33,41 +45,77 @@ layout (push_constant) uniform constants
     vec2 cameraJitter;
 } pushConstants;
 
+// Position of the surface seen through a texel, reconstructed from its depth
+vec3 texelPosition(ivec2 texel)
+{
+    return reconstructPosition(pushConstants.camPos.xyz, pushConstants.camDir.xyz, pushConstants.camRight.xyz, pushConstants.camUp.xyz,
+                               vec2(pushConstants.screenSize), pushConstants.cameraJitter, texel, texelFetch(inputDepth, texel, 0).r);
+}
+
 // Edge-avoiding A-Trous filter [Dammertz et al. 2010]
 // https://jo.dreggn.org/home/2010_atrous.pdf
 void main(void)
 {
     vec4 sum = vec4(0.0);
-    vec2 step = vec2(1.0 / pushConstants.screenSize.x, 1.0 / pushConstants.screenSize.y);
-    
-    vec4 sampleColor = texture(inputColor, vScreenPos);
-    vec4 sampleNormal = texture(inputNormal, vScreenPos);
-    vec4 samplePos = texture(inputPos, vScreenPos);
-    
+    vec2 textureRes = vec2(textureSize(inputColor, 0));
+    vec2 step = 1.0 / textureRes;
+
+    // Targets are allocated at the maximum render resolution, but only screenSize is rendered to
+    vec2 centerUV = vScreenPos * vec2(pushConstants.screenSize) / textureRes;
+    vec2 maxUV = (vec2(pushConstants.screenSize) - 0.5) / textureRes;
+    ivec2 centerTexel = ivec2(gl_FragCoord.xy);
+    ivec2 maxTexel = pushConstants.screenSize - 1;
+
+    vec3 sampleNormal = decodeNormal(texelFetch(inputNormal, centerTexel, 0).r);
+    vec3 samplePos = texelPosition(centerTexel);
+
+    // Taps are fetched up front, as the variance guiding them is prefiltered over the same footprint
+    // The first iteration takes its variance from the moments, later ones from the previous iteration's alpha
+    vec4 taps[KERNEL_SIZE];
+    ivec2 tapTexels[KERNEL_SIZE];
+    float deviation = 0.0;
+    float kernelSum = 0.0;
+    for (int i = 0; i < KERNEL_SIZE; i++)
+    {
+        vec2 uv = min(centerUV + offset[i] * step * params.stepWidth, maxUV);
+        // Normals and depths can't be interpolated, so they're read from the nearest texel
+        tapTexels[i] = clamp(ivec2(uv * textureRes), ivec2(0), maxTexel);
+        taps[i] = texture(inputColor, uv);
+        if (params.iteration == 0)
+            taps[i].a = texelFetch(inputMoments, tapTexels[i], 0).z;
+
+        deviation += taps[i].a * kernel[i];
+        kernelSum += kernel[i];
+    }
+    deviation = sqrt(max(deviation / kernelSum, 0.0));
+
+    // The center is the kernel's middle tap
+    vec4 sampleColor = taps[KERNEL_SIZE / 2];
+
     float totalWeight = 0.0;
-    for (int i = 0; i < 25; i++)
+    float variance = 0.0;
+    for (int i = 0; i < KERNEL_SIZE; i++)
     {
-        vec2 uv = vScreenPos + offset[i] * step * params.stepWidth;
-        
-        vec4 offsetColor = texture(inputColor, uv);
-        vec4 t = sampleColor - offsetColor;
-        float dist2 = dot(t, t);
-        float colorWeight = min(exp(-(dist2) / params.phiColor), 1.0);
-        
-        vec4 offsetNormal = texture(inputNormal, uv);
-        t = sampleNormal - offsetNormal;
-        dist2 = max(dot(t, t) / (params.stepWidth * params.stepWidth), 0.0);
+        vec4 offsetColor = taps[i];
+        ivec2 texel = tapTexels[i];
+
+        float edgeWeight = params.varianceGuided != 0 ? luminanceWeight(sampleColor.rgb, offsetColor.rgb, deviation, params.phiLuminance)
+                                                       : colorWeight(sampleColor.rgb, offsetColor.rgb, params.phiColor);
+
+        vec3 n = sampleNormal - decodeNormal(texelFetch(inputNormal, texel, 0).r);
+        float dist2 = max(dot(n, n) / (params.stepWidth * params.stepWidth), 0.0);
         float normalWeight = min(exp(-(dist2) / params.phiNormal), 1.0);
-        
-        vec4 offsetPos = texture(inputPos, uv);
-        t = samplePos - offsetPos;
-        dist2 = dot(t, t);
+
+        vec3 p = samplePos - texelPosition(texel);
+        dist2 = dot(p, p);
         float posWeight = min(exp(-(dist2) / params.phiPos), 1.0);
-        
-        float weight = colorWeight * normalWeight * posWeight;
+
+        float weight = edgeWeight * normalWeight * posWeight;
         sum += offsetColor * weight * kernel[i];
         totalWeight += weight * kernel[i];
+        // Variance of a weighted sum scales with the squared weights
+        variance += offsetColor.a * weight * weight * kernel[i] * kernel[i];
     }
-    
-    outColor = sum / totalWeight;
+
+    outColor = vec4(sum.rgb / totalWeight, variance / (totalWeight * totalWeight));
 }
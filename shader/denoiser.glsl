@@ -0,0 +1,23 @@
+// Edge-stopping functions shared by the fragment and compute denoisers.
+// Without a variance estimate, colors are compared with a fixed falloff. With one, luminance differences are
+// scaled by the local standard deviation, so noisy regions are smoothed harder than converged ones, and the
+// variance is filtered alongside the color so later iterations tighten as the noise goes down.
+// Spatiotemporal Variance-Guided Filtering [Schied et al. 2017]
+
+// Relative luminance, matching the moments accumulated by the temporal pass
+float denoiserLuminance(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+float colorWeight(vec3 center, vec3 tap, float phiColor)
+{
+    vec3 t = center - tap;
+    return min(exp(-dot(t, t) / phiColor), 1.0);
+}
+
+float luminanceWeight(vec3 center, vec3 tap, float deviation, float phiLuminance)
+{
+    float difference = abs(denoiserLuminance(center) - denoiserLuminance(tap));
+    return exp(-difference / (phiLuminance * deviation + 1e-4));
+}
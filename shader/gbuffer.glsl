@@ -0,0 +1,46 @@
+// Compact G-buffer encoding, shared by the tracers and the passes which read the G-buffer.
+// Positions aren't stored, but reconstructed from the distance along the primary ray held in the depth target.
+// Voxel normals are always axis-aligned, so they're stored as a face index in an R8 target.
+
+// Primary ray direction through a screen position from -1.0 to 1.0, for the given camera
+vec3 primaryRayDir(vec3 camDir, vec3 camRight, vec3 camUp, vec2 screenSize, vec2 jitter, vec2 screenPos)
+{
+    // Camera planes
+    vec3 cameraPlaneU = camRight;
+    vec3 cameraPlaneV = camUp * screenSize.y / screenSize.x;
+
+    return normalize(normalize(camDir) + screenPos.x * cameraPlaneU + screenPos.y * cameraPlaneV + vec3(jitter / screenSize * vec2(-2.0, 2.0), 0));
+}
+
+// World position of a primary ray hit, from the texel it was written to and its distance from the camera
+vec3 reconstructPosition(vec3 camPos, vec3 camDir, vec3 camRight, vec3 camUp, vec2 screenSize, vec2 jitter, ivec2 texel, float distance)
+{
+    vec2 screenPos = (vec2(texel) + 0.5) / screenSize * 2.0 - 1.0;
+    return camPos + primaryRayDir(camDir, camRight, camUp, screenSize, jitter, screenPos) * distance;
+}
+
+// Face index of an axis-aligned normal, with 0 for sky, scaled for an R8 unorm target
+float encodeNormal(vec3 normal)
+{
+    if (dot(normal, normal) < 0.5)
+        return 0.0;
+
+    uint axis = abs(normal.x) > 0.5 ? 0 : (abs(normal.y) > 0.5 ? 1 : 2);
+    uint positive = normal[axis] > 0.0 ? 1 : 0;
+    return float(1 + axis * 2 + positive) / 255.0;
+}
+
+vec3 decodeNormal(float encoded)
+{
+    uint face = uint(round(encoded * 255.0));
+    vec3 normal = vec3(0.0);
+    if (face != 0)
+        normal[(face - 1) / 2] = ((face - 1) % 2 == 1) ? 1.0 : -1.0;
+    return normal;
+}
+
+// Whether a pixel is traced this frame under checkerboard rendering, which alternates between the two halves every frame
+bool checkerboardTraced(ivec2 pixel, uint frame)
+{
+    return ((uint(pixel.x + pixel.y) + frame) & 1u) == 0u;
+}
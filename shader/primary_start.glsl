@@ -0,0 +1,54 @@
+// Starts primary rays from a conservative bound on their first hit, built from the previous frame by depth_tiles.comp
+// and from a beam traced through the coarse occupancy grid by beam_prepass.comp.
+// The including shader must include voxel_tracing.glsl, declare a depthTiles sampler and a uint depthTilesValid flag,
+// and declare the start counters after the step counters in its laneStats buffer.
+
+// Matches DEPTH_TILE_SIZE in depth_tile_stage.hpp
+const int DEPTH_TILE_SIZE = 8;
+// Distance kept in front of a tile's bound, in voxels and relative to the bound, for surfaces between last frame's samples
+const float START_MARGIN = 2.0;
+const float START_MARGIN_RELATIVE = 0.02;
+
+// Traversal steps between two points along a ray, as the number of voxel boundaries crossed
+uint stepsBetween(vec3 from, vec3 to)
+{
+    ivec3 cells = abs(ivec3(floor(to)) - ivec3(floor(from)));
+    return uint(cells.x + cells.y + cells.z);
+}
+
+// Records the steps each primary ray skipped, and how many had to fall back to tracing from the camera
+void recordPrimaryStart(uint skipped, bool miss)
+{
+    if (collectLaneStats == 0)
+        return;
+
+    uint rays = subgroupAdd(1u);
+    uint skippedSum = subgroupAdd(skipped);
+    uint misses = subgroupAdd(miss ? 1u : 0u);
+    if (subgroupElect())
+    {
+        atomicAdd(laneStats.primaryRays, rays);
+        atomicAdd(laneStats.skippedSteps, skippedSum);
+        atomicAdd(laneStats.startMisses, misses);
+    }
+}
+
+// Traces a primary ray from just in front of its tile's bound, rather than from where it enters the volume.
+// Starting inside a voxel means something now lies in front of the bound, so the ray is traced in full instead.
+RayHit tracePrimaryRay(ivec2 pixel, vec3 start, vec3 dir)
+{
+    float bound = depthTilesValid != 0 ? texelFetch(depthTiles, pixel / DEPTH_TILE_SIZE, 0).r : 0.0;
+    float skip = bound * (1.0 - START_MARGIN_RELATIVE) - START_MARGIN;
+
+    vec3 entry = boxIntersection(start, dir);
+    vec3 skipStart = start + dir * skip;
+    bool skipping = bound > 0.0 && skip > length(entry - start);
+    // Beams clear of the volume are bounded beyond it, where there's nothing to start inside
+    ivec3 startVoxel = ivec3(floor(skipStart));
+    bool inside = all(greaterThanEqual(startVoxel, ivec3(0))) && all(lessThan(startVoxel, ivec3(pushConstants.volumeBounds)));
+    bool miss = skipping && inside && getVoxel(startVoxel) != 0;
+    skipping = skipping && !miss;
+
+    recordPrimaryStart(skipping ? stepsBetween(entry, skipStart) : 0, miss);
+    return traceRay(skipping ? skipStart : start, dir, MAX_RAY_STEPS, KERNEL_PRIMARY);
+}
@@ -0,0 +1,107 @@
+// Bindings and helpers shared by the reduced resolution secondary ray kernels.
+// Each reduced texel traces from one full resolution pixel of its block, which rotates through the block over frames,
+// and the upsample kernel blends the nearest reduced texels back into the color target by how well their surfaces match.
+
+layout (push_constant) uniform constants
+{
+    vec4 camPos;
+    vec4 camDir;
+    vec4 camRight;
+    vec4 camUp;
+    uvec3 volumeBounds;
+    uint frame;
+    ivec2 screenSize;
+    vec2 cameraJitter;
+    // Pixels per reduced texel along each axis, for each effect
+    uint shadowScale;
+    uint ambientScale;
+    // Effect traced by the dispatch, as one of the DEFER bits
+    uint effect;
+} pushConstants;
+
+#include "voxel_types.glsl"
+
+// Bindings match the fragment tracer's where they overlap
+layout (set = 0, binding = 0) uniform usampler3D scene;
+layout (set = 0, binding = 1) uniform Palette {
+    Material materials[256];
+};
+layout (set = 0, binding = 2) uniform sampler2D blueNoise;
+layout (set = 0, binding = 4) uniform Parameters {
+    uint aoSamples;
+    float ambientIntensity;
+    uint collectLaneStats;
+    uint aoCacheEnabled;
+    uint aoCones;
+    uint aoAdaptive;
+    uint deferredSecondary;
+    uint checkerboard;
+    uint depthTilesValid;
+    uint tileClassification;
+    uint reflectionRoulette;
+};
+layout (set = 0, binding = 5) uniform Light {
+    vec3 lightDir;
+    float lightIntensity;
+    vec4 lightColor;
+};
+layout (set = 0, binding = 6) uniform sampler2D skybox;
+layout (set = 0, binding = 7) uniform Camera {
+    mat4 viewProjection;
+    mat4 prevViewProjection;
+};
+layout (set = 0, binding = 8) buffer LaneStats {
+    uint activeSteps[4];
+    uint issuedSteps[4];
+    uint primaryRays;
+    uint skippedSteps;
+    uint startMisses;
+} laneStats;
+layout (set = 0, binding = 9) uniform sampler3D sunVisibility;
+layout (set = 0, binding = 10) coherent buffer AmbientCache {
+    AoCacheEntry aoCache[];
+};
+layout (set = 0, binding = 11) uniform sampler3D occupancy;
+layout (set = 0, binding = 12, rgba8) uniform image2D outColor;
+layout (set = 0, binding = 13) uniform sampler2D depthTarget;
+layout (set = 0, binding = 14) uniform sampler2D normalTarget;
+// Light visibility and ambient occlusion at reduced resolution, each covering the top left of its target
+layout (set = 0, binding = 15, r8) uniform image2D shadowTarget;
+layout (set = 0, binding = 16, r8) uniform image2D ambientTarget;
+
+#include "voxel_tracing.glsl"
+
+uint effectScale(uint effect)
+{
+    return effect == DEFER_SHADOW ? pushConstants.shadowScale : pushConstants.ambientScale;
+}
+
+// Size of an effect's reduced target, rounding up so that partial blocks at the edges are covered
+ivec2 reducedSize(uint scale)
+{
+    return (pushConstants.screenSize + int(scale) - 1) / int(scale);
+}
+
+// Offset within each block of the pixel traced this frame
+ivec2 blockOffset(uint scale)
+{
+    uint index = pushConstants.frame % (scale * scale);
+    ivec2 offset = ivec2(index % scale, index / scale);
+    // Blocks start on even pixels, so a step along the row lands on the half of a checkerboard traced this frame
+    if (checkerboard != 0 && !checkerboardTraced(offset, pushConstants.frame))
+        offset.x ^= 1;
+    return offset;
+}
+
+ivec2 representativePixel(ivec2 texel, uint scale)
+{
+    return min(texel * int(scale) + blockOffset(scale), pushConstants.screenSize - 1);
+}
+
+// World position of the surface a pixel saw, snapped onto its face so rays start outside the voxel
+vec3 surfacePosition(ivec2 pixel, float depth, vec3 normal)
+{
+    vec3 pos = reconstructPosition(pushConstants.camPos.xyz, pushConstants.camDir.xyz, pushConstants.camRight.xyz, pushConstants.camUp.xyz,
+                                   vec2(pushConstants.screenSize), pushConstants.cameraJitter, pixel, depth);
+    return mix(pos, round(pos), abs(normal));
+}
@@ -0,0 +1,50 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+layout (location = 0) in vec2 vScreenPos;
+
+layout (location = 0) out vec4 outColor;
+layout (location = 1) out float outDepth;
+layout (location = 2) out vec2 outMotion;
+layout (location = 3) out float outMask;
+layout (location = 4) out float outNormal;
+
+layout (push_constant) uniform constants
+{
+    vec4 camPos;
+    vec4 camDir;
+    vec4 camRight;
+    vec4 camUp;
+    uvec3 volumeBounds;
+    uint frame;
+    ivec2 screenSize;
+    vec2 cameraJitter;
+} pushConstants;
+
+// Bindings match the fragment tracer's, whose set this is drawn with
+layout (set = 0, binding = 6) uniform sampler2D skybox;
+layout (set = 0, binding = 7) uniform Camera {
+    mat4 viewProjection;
+    mat4 prevViewProjection;
+};
+
+#include "gbuffer.glsl"
+#include "sky.glsl"
+
+// Writes the sky for pixels whose primary ray misses the volume, as the tracer would, and steps their stencil past the tracer's reference.
+// Everything else is discarded, so is left for the tracer.
+void main()
+{
+    // Screen position from -1.0 to 1.0
+    vec2 screenPos = vScreenPos * 2.0 - 1.0;
+    vec3 rayDir = primaryRayDir(pushConstants.camDir.xyz, pushConstants.camRight.xyz, pushConstants.camUp.xyz,
+                                vec2(pushConstants.screenSize), pushConstants.cameraJitter, screenPos);
+    if (rayHitsVolume(pushConstants.camPos.xyz, rayDir))
+        discard;
+
+    outColor = vec4(skyColor(rayDir).rgb, 1.0);
+    outDepth = 0.0;
+    outMask = 0.0;
+    outMotion = motionVector(vec4(rayDir, 0.0));
+    outNormal = encodeNormal(vec3(0.0));
+}
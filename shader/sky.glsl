@@ -0,0 +1,40 @@
+// Helpers for pixels which only see the sky, shared by the tracers and the sky fill ahead of the fragment tracer.
+// The including shader must declare pushConstants, starting with the ScreenQuadPush fields,
+// a skybox sampler, and viewProjection and prevViewProjection matrices.
+
+// Sky color sampled from skybox
+const vec2 invAtan = vec2(0.1591, 0.3183);
+vec4 skyColor(vec3 rayDir)
+{
+    vec2 uv = vec2(atan(rayDir.z, rayDir.x), asin(-rayDir.y));
+    uv *= invAtan;
+    uv += 0.5;
+    return texture(skybox, uv);
+}
+
+// Screen-space motion from this frame to the last, excluding jitter
+// Points use w = 1, while directions to the sky use w = 0 so only camera rotation moves them
+vec2 motionVector(vec4 worldPos)
+{
+    vec4 clip = viewProjection * worldPos;
+    vec4 prevClip = prevViewProjection * worldPos;
+
+    // Anything behind the previous camera was not on screen
+    if (prevClip.w <= 0.0)
+        return vec2(2.0);
+
+    vec2 uv = clip.xy / clip.w * 0.5 + 0.5;
+    vec2 prevUV = prevClip.xy / prevClip.w * 0.5 + 0.5;
+    return prevUV - uv;
+}
+
+// Whether a ray can reach the volume at all, from inside it or by entering it ahead of its start
+bool rayHitsVolume(vec3 start, vec3 dir)
+{
+    vec3 invDir = 1.0 / dir;
+    vec3 t1 = (-start) * invDir;
+    vec3 t2 = (vec3(pushConstants.volumeBounds) - start) * invDir;
+    float tmin = max(max(min(t1.x, t2.x), min(t1.y, t2.y)), min(t1.z, t2.z));
+    float tmax = min(min(max(t1.x, t2.x), max(t1.y, t2.y)), max(t1.z, t2.z));
+    return tmax >= max(tmin, 0.0);
+}
@@ -0,0 +1,14 @@
+// Lookup of the sun visibility volume baked by sun_visibility.comp.
+// Each voxel holds the fraction of its face towards the light along each axis which the light reaches,
+// with alpha set once it has been baked for the current light direction.
+// The including shader must declare the volume as a sunVisibility sampler, and pushConstants with the ScreenQuadPush fields.
+
+// Looks up the visibility of the light from a surface hit, returning false while its voxel hasn't been baked
+bool bakedSunVisibility(vec3 pos, vec3 normal, out float visibility)
+{
+    ivec3 voxel = clamp(ivec3(floor(pos - normal * 0.5)), ivec3(0), ivec3(pushConstants.volumeBounds) - 1);
+    vec4 baked = texelFetch(sunVisibility, voxel, 0);
+    // Faces away from the light share their axis' value, but get no direct light anyway
+    visibility = dot(baked.rgb, abs(normal));
+    return baked.a > 0.5;
+}
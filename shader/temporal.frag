@@ -0,0 +1,130 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "gbuffer.glsl"
+
+layout (location = 0) in vec2 vScreenPos;
+
+layout (location = 0) out vec4 outColor;
+// First and second moments of luminance, and the variance estimated from them
+layout (location = 1) out vec4 outMoments;
+
+layout (set = 0, binding = 0) uniform sampler2D inputColor;
+layout (set = 0, binding = 1) uniform sampler2D inputDepth;
+layout (set = 0, binding = 2) uniform sampler2D inputNormal;
+layout (set = 0, binding = 3) uniform sampler2D historyColor;
+layout (set = 0, binding = 4) uniform sampler2D historyDepth;
+layout (set = 0, binding = 5) uniform sampler2D historyNormal;
+layout (set = 0, binding = 6) uniform TemporalParams
+{
+    float blendFactor;
+    float positionThreshold;
+    float normalThreshold;
+    uint reset;
+    ivec2 prevScreenSize;
+    vec2 prevCameraJitter;
+    // Camera the history was rendered with, to reconstruct its positions
+    vec4 prevCamPos;
+    vec4 prevCamDir;
+    vec4 prevCamRight;
+    vec4 prevCamUp;
+} params;
+layout (set = 0, binding = 7) uniform sampler2D inputMotion;
+layout (set = 0, binding = 8) uniform sampler2D historyMoments;
+
+layout (push_constant) uniform constants
+{
+    vec4 camPos;
+    vec4 camDir;
+    vec4 camRight;
+    vec4 camUp;
+    uvec3 volumeBounds;
+    uint frame;
+    ivec2 screenSize;
+    vec2 cameraJitter;
+} pushConstants;
+
+// Finds this pixel's surface in the previous frame, returning false if it was not visible there
+bool reprojectHistory(vec2 uv, vec3 pos, vec3 normal, out ivec2 prevTexel)
+{
+    vec2 prevUV = vScreenPos + texture(inputMotion, uv).xy;
+    if (any(lessThan(prevUV, vec2(0.0))) || any(greaterThanEqual(prevUV, vec2(1.0))))
+        return false;
+    // Only part of the history targets was rendered to last frame
+    prevTexel = ivec2(prevUV * vec2(params.prevScreenSize));
+
+    // Reject history belonging to a different surface, using a tolerance which grows with view distance
+    vec3 prevPos = reconstructPosition(params.prevCamPos.xyz, params.prevCamDir.xyz, params.prevCamRight.xyz, params.prevCamUp.xyz,
+                                       vec2(params.prevScreenSize), params.prevCameraJitter, prevTexel, texelFetch(historyDepth, prevTexel, 0).r);
+    float tolerance = params.positionThreshold * max(length(pos - pushConstants.camPos.xyz), 1.0);
+    if (length(prevPos - pos) > tolerance)
+        return false;
+
+    vec3 prevNormal = decodeNormal(texelFetch(historyNormal, prevTexel, 0).r);
+    if (dot(prevNormal, normal) < params.normalThreshold)
+        return false;
+
+    return true;
+}
+
+// Relative luminance, which the variance is tracked over
+float luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// Luminance moments of the 3x3 neighbourhood, standing in for the temporal ones until enough history has been gathered
+vec2 spatialMoments(vec2 uv)
+{
+    vec2 texelSize = 1.0 / vec2(textureSize(inputColor, 0));
+    vec2 moments = vec2(0.0);
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            float l = luminance(texture(inputColor, uv + vec2(x, y) * texelSize).rgb);
+            moments += vec2(l, l * l);
+        }
+    }
+    return moments / 9.0;
+}
+
+// Variance of luminance from its moments, estimated spatially while the history is too short to be reliable
+// Spatiotemporal Variance-Guided Filtering [Schied et al. 2017]
+vec4 momentsOutput(vec2 moments, float historyLength, vec2 uv)
+{
+    vec2 varianceMoments = historyLength < 4.0 ? spatialMoments(uv) : moments;
+    float variance = max(varianceMoments.y - varianceMoments.x * varianceMoments.x, 0.0);
+    return vec4(moments, variance, 0.0);
+}
+
+void main()
+{
+    // Targets are allocated at the maximum render resolution, but only screenSize is rendered to
+    vec2 uv = vScreenPos * vec2(pushConstants.screenSize) / vec2(textureSize(inputColor, 0));
+
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    vec4 color = texture(inputColor, uv);
+    vec3 pos = reconstructPosition(pushConstants.camPos.xyz, pushConstants.camDir.xyz, pushConstants.camRight.xyz, pushConstants.camUp.xyz,
+                                   vec2(pushConstants.screenSize), pushConstants.cameraJitter, texel, texelFetch(inputDepth, texel, 0).r);
+    vec3 normal = decodeNormal(texelFetch(inputNormal, texel, 0).r);
+    float l = luminance(color.rgb);
+    vec2 moments = vec2(l, l * l);
+
+    // Sky has no normal, and is cheap enough to not need accumulation
+    ivec2 prevTexel;
+    if (params.reset != 0 || dot(normal, normal) < 0.5 || !reprojectHistory(uv, pos, normal, prevTexel))
+    {
+        outColor = vec4(color.rgb, 1.0);
+        outMoments = momentsOutput(moments, 1.0, uv);
+        return;
+    }
+
+    // Exponential moving average, using a plain average until enough history has been gathered
+    vec4 history = texelFetch(historyColor, prevTexel, 0);
+    float historyLength = min(history.a + 1.0, 1.0 / params.blendFactor);
+    float alpha = 1.0 / historyLength;
+    outColor = vec4(mix(history.rgb, color.rgb, alpha), historyLength);
+    outMoments = momentsOutput(mix(texelFetch(historyMoments, prevTexel, 0).xy, moments, alpha), historyLength, uv);
+}
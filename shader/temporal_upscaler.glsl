@@ -0,0 +1,29 @@
+// Bindings shared by the built-in temporal upscaler's kernels.
+// Inputs are at render resolution, in the top-left corner of targets allocated for the largest one,
+// while the history and output are at target resolution.
+
+// Matches UPSCALER_TILE_SIZE in upscaler_stage.hpp
+#define TILE_SIZE 8
+
+layout (push_constant) uniform constants
+{
+    vec4 camPos;
+    vec4 camDir;
+    vec4 camRight;
+    vec4 camUp;
+    uvec3 volumeBounds;
+    uint frame;
+    ivec2 screenSize;
+    vec2 cameraJitter;
+    ivec2 targetSize;
+    uint reset;
+    float sharpness;
+} pushConstants;
+
+layout (set = 0, binding = 0) uniform sampler2D inputColor;
+layout (set = 0, binding = 1) uniform sampler2D inputDepth;
+layout (set = 0, binding = 2) uniform sampler2D inputMotion;
+layout (set = 0, binding = 3) uniform sampler2D previousHistory;
+// Accumulated color, with the number of frames accumulated in alpha
+layout (set = 0, binding = 4, rgba16f) uniform image2D history;
+layout (set = 0, binding = 5, rgba8) uniform writeonly image2D upscaled;
@@ -0,0 +1,180 @@
+// Voxel traversal and shading helpers shared by the fragment and wavefront tracers.
+// The including shader must include voxel_types.glsl, and declare:
+// - pushConstants, starting with the ScreenQuadPush fields
+// - scene, blueNoise and skybox samplers
+// - viewProjection and prevViewProjection matrices
+// - a laneStats buffer and a uint collectLaneStats flag
+// It must also enable GL_KHR_shader_subgroup_basic and GL_KHR_shader_subgroup_arithmetic.
+
+#include "gbuffer.glsl"
+#include "sky.glsl"
+
+// Records how evenly traversal steps were spread across the subgroup
+// Lanes that finish early, or never started, still occupy the subgroup until its longest ray finishes
+void recordLaneSteps(uint kernel, uint steps)
+{
+    if (collectLaneStats == 0)
+        return;
+
+    uint active = subgroupAdd(steps);
+    uint issued = subgroupMax(steps) * gl_SubgroupSize;
+    if (subgroupElect())
+    {
+        atomicAdd(laneStats.activeSteps[kernel], active);
+        atomicAdd(laneStats.issuedSteps[kernel], issued);
+    }
+}
+
+// Scene definition from volume
+uint getVoxel(ivec3 pos)
+{
+    uint val = texture(scene, vec3(pos) / vec3(pushConstants.volumeBounds)).r;
+    return val;
+}
+
+// Generates a random number unique to this pixel from
+vec3 noiseSeq(vec2 pixel, uint num)
+{
+    uint offset = num * 32 + pushConstants.frame % 32;
+    // Constants inspired by http://extremelearning.com.au/unreasonable-effectiveness-of-quasirandom-sequences/
+    const float g = 1.22074408460575947536;
+    const vec3 a = vec3(1.0 / g, 1.0 / (g * g), 1.0 / (g * g * g));
+    vec2 p = pixel / NOISE_SIZE + vec2(0.5, 0.5);
+    vec3 noise = texture(blueNoise, p).rgb;
+    return mod(noise + offset * a, 1.0);
+}
+
+// Reflection chains are continued outright while their throughput is above this, and with a probability proportional to it below
+const float ROULETTE_THRESHOLD = 0.25;
+// Noise sequence used for roulette, past those used by ambient samples
+const uint ROULETTE_SEQUENCE = 4096;
+// Bounces up to this depth are always lit in full, while those beyond use simplified lighting under roulette
+const uint FULL_LIGHTING_DEPTH = 1;
+
+// Russian roulette for tracing the reflection at the given depth, returning false if the chain ends before it.
+// Surviving chains have their throughput scaled up to make up for those ended, so the expected radiance is unchanged.
+bool continueReflection(vec2 pixel, uint depth, inout vec3 pathThroughput)
+{
+    float strength = max(pathThroughput.r, max(pathThroughput.g, pathThroughput.b));
+    if (strength >= ROULETTE_THRESHOLD)
+        return true;
+
+    float survival = strength / ROULETTE_THRESHOLD;
+    if (noiseSeq(pixel, ROULETTE_SEQUENCE + depth).x >= survival)
+        return false;
+    pathThroughput /= survival;
+    return true;
+}
+
+// Generates a random direction within the unit sphere
+vec3 randomDir(vec2 pixel, uint num)
+{
+    return normalize(noiseSeq(pixel, num) * 2.0 - vec3(1.0));
+}
+
+// Calculate the point where a ray intersects the scene box
+// Design inspired by https://tavianator.com/2011/ray_box.html
+vec3 boxIntersection(vec3 start, vec3 dir) {
+    vec3 invDir = 1.0 / dir;
+
+    vec3 t1 = (-start) * invDir;
+    vec3 t2 = (vec3(pushConstants.volumeBounds) - start) * invDir;
+    vec3 tminDir = min(t1, t2);
+    vec3 tmaxDir = max(t1, t2);
+
+    float tmin = max(tminDir.x, max(tminDir.y, tminDir.z));
+    float tmax = min(tmaxDir.x, min(tmaxDir.y, tmaxDir.z));
+
+    if (tmin >= 0 && tmax >= tmin) {
+        return start + (tmin + 0.1) * dir;
+    } else {
+        return start;
+    }
+}
+
+RayHitInternal traceRayInt(vec3 start, vec3 dir, uint maxSteps, uint kernel)
+{
+    RayHitInternal result;
+
+    // Ray starting position
+    result.pos = boxIntersection(start, dir);
+
+    // First voxel to sample
+    ivec3 mapPos = ivec3(floor(result.pos));
+
+    // Portion of ray needed for ray to traverse a voxel in each direction
+    result.deltaDist = abs(1.0 / dir);
+
+    // Integer position steps along ray
+    result.rayStep = ivec3(sign(dir));
+
+    // Distance ray can travel in each direction before crossing a boundary
+    result.sideDist = (sign(dir) * (vec3(mapPos) - result.pos) + (sign(dir) * 0.5) + 0.5) * result.deltaDist;
+
+    uint i;
+    for (i = 0; i < maxSteps; i++)
+    {
+        // If we're out of bounds, break
+        if (mapPos.x < 0 || mapPos.x >= pushConstants.volumeBounds.x
+        || mapPos.y < 0 || mapPos.y >= pushConstants.volumeBounds.y
+        || mapPos.z < 0 || mapPos.z >= pushConstants.volumeBounds.z)
+        {
+            break;
+        }
+
+        // If we hit a voxel, break
+        result.material = getVoxel(mapPos);
+        if (result.material != 0)
+        {
+            break;
+        }
+
+        // Determine which direction has minimum travel distance before hitting a boundary
+        result.mask = lessThanEqual(result.sideDist.xyz, min(result.sideDist.yzx, result.sideDist.zxy));
+
+        // Advance the distance needed for that axis
+        result.sideDist += vec3(result.mask) * result.deltaDist;
+
+        // Advance the integer map positon
+        mapPos += ivec3(vec3(result.mask)) * result.rayStep;
+    }
+
+    recordLaneSteps(kernel, i);
+
+    return result;
+}
+
+RayHit traceRay(vec3 start, vec3 dir, uint maxSteps, uint kernel)
+{
+    // Internal trace, common between this and simplified versions
+    RayHitInternal interal = traceRayInt(start, dir, maxSteps, kernel);
+
+    RayHit result;
+    result.material = interal.material;
+    result.dir = dir;
+
+    if (result.material != 0)
+    {
+        // Calculate normal direction from final mask
+        result.normal = normalize(vec3(interal.mask) * -vec3(interal.rayStep));
+
+        // Calculate the ending position from distance traveled
+        float d = length(vec3(interal.mask) * (interal.sideDist - interal.deltaDist));
+        result.pos = interal.pos + d * dir;
+    }
+
+    return result;
+}
+
+bool traceRayHit(vec3 start, vec3 dir, uint maxSteps, uint kernel)
+{
+    RayHitInternal interal = traceRayInt(start, dir, maxSteps, kernel);
+    return interal.material != 0;
+}
+
+// Primary ray direction through a screen position from -1.0 to 1.0
+vec3 cameraRayDir(vec2 screenPos)
+{
+    return primaryRayDir(pushConstants.camDir.xyz, pushConstants.camRight.xyz, pushConstants.camUp.xyz,
+                         vec2(pushConstants.screenSize), pushConstants.cameraJitter, screenPos);
+}
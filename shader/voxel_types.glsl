@@ -0,0 +1,55 @@
+// Constants and structures shared by the fragment and wavefront tracers.
+
+// The fragment tracer declares its own limits as specialization constants
+#ifndef TRACER_LIMITS_SPECIALIZED
+const uint MAX_RAY_STEPS = 512;
+const uint MAX_REFLECTIONS = 5;
+#endif
+const uvec2 NOISE_SIZE = uvec2(512, 512);
+
+// Kernel slots for lane statistics
+const uint KERNEL_PRIMARY = 0;
+const uint KERNEL_SHADOW = 1;
+const uint KERNEL_AMBIENT = 2;
+const uint KERNEL_REFLECTION = 3;
+
+// Effects the tracers leave out of primary hits, for the secondary ray kernels to add at reduced resolution.
+// Bits of deferredSecondary, matching SECONDARY_DEFER_SHADOW and SECONDARY_DEFER_AMBIENT in parameters.hpp
+const uint DEFER_SHADOW = 1;
+const uint DEFER_AMBIENT = 2;
+
+struct Material
+{
+    vec4 diffuse;
+    float metallic;
+    float pad1;
+    float pad2;
+    float pad3;
+};
+
+struct RayHitInternal
+{
+    vec3 pos;
+    vec3 sideDist;
+    vec3 deltaDist;
+    ivec3 rayStep;
+    uint material;
+    bvec3 mask;
+};
+
+struct RayHit
+{
+    uint material;
+    vec3 pos;
+    vec3 normal;
+    vec3 dir;
+};
+
+// One voxel face's ambient occlusion samples, matching AoCacheEntry in parameters.hpp
+struct AoCacheEntry
+{
+    uint key;
+    uint lastFrame;
+    uint hits;
+    uint samples;
+};
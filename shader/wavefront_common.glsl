@@ -0,0 +1,201 @@
+// Bindings and ray queues shared by the wavefront tracer kernels.
+// Each pixel has a single path, so kernels for one bounce never write the same pixel twice.
+
+layout (push_constant) uniform constants
+{
+    vec4 camPos;
+    vec4 camDir;
+    vec4 camRight;
+    vec4 camUp;
+    uvec3 volumeBounds;
+    uint frame;
+    ivec2 screenSize;
+    vec2 cameraJitter;
+    // Bounce the kernel is processing, with 0 for primary rays
+    uint depth;
+} pushConstants;
+
+#include "voxel_types.glsl"
+
+// A surface hit waiting for shading, with its material and face packed together
+struct HitItem
+{
+    vec3 pos;
+    uint pixel;
+    vec3 dir;
+    uint materialFace;
+};
+
+// A reflection ray waiting to be traced
+struct RayItem
+{
+    vec3 origin;
+    uint pixel;
+    vec3 dir;
+    uint pad;
+};
+
+layout (set = 0, binding = 0) uniform usampler3D scene;
+layout (set = 0, binding = 1) uniform Palette {
+    Material materials[256];
+};
+layout (set = 0, binding = 2) uniform sampler2D blueNoise;
+layout (set = 0, binding = 3) uniform sampler2D skybox;
+layout (set = 0, binding = 4) uniform Parameters {
+    uint aoSamples;
+    float ambientIntensity;
+    uint collectLaneStats;
+    uint aoCacheEnabled;
+    uint aoCones;
+    uint aoAdaptive;
+    uint deferredSecondary;
+    uint checkerboard;
+    uint depthTilesValid;
+    uint tileClassification;
+    uint reflectionRoulette;
+};
+layout (set = 0, binding = 5) uniform Light {
+    vec3 lightDir;
+    float lightIntensity;
+    vec4 lightColor;
+};
+layout (set = 0, binding = 6) uniform Camera {
+    mat4 viewProjection;
+    mat4 prevViewProjection;
+};
+layout (set = 0, binding = 7, r32f) uniform image2D outDepth;
+layout (set = 0, binding = 8, rg16f) uniform image2D outMotion;
+layout (set = 0, binding = 9, r8) uniform image2D outMask;
+layout (set = 0, binding = 11, r8) uniform image2D outNormal;
+layout (set = 0, binding = 12, rgba8) uniform image2D outColor;
+layout (set = 0, binding = 13, rgba32f) uniform image2D radiance;
+layout (set = 0, binding = 14, rgba16f) uniform image2D throughput;
+layout (set = 0, binding = 15) buffer HitQueue {
+    HitItem hits[];
+};
+layout (set = 0, binding = 16) buffer RayQueue {
+    RayItem rays[];
+};
+// Queue lengths for each bounce, and the indirect dispatch sizes built from them
+layout (set = 0, binding = 17) buffer Queues {
+    uint hitCount[MAX_REFLECTIONS + 1];
+    uint rayCount[MAX_REFLECTIONS + 1];
+    uvec4 hitArgs[MAX_REFLECTIONS + 1];
+    uvec4 rayArgs[MAX_REFLECTIONS + 1];
+    uvec4 tileArgs;
+} queues;
+layout (set = 0, binding = 18) buffer LaneStats {
+    uint activeSteps[4];
+    uint issuedSteps[4];
+    uint primaryRays;
+    uint skippedSteps;
+    uint startMisses;
+} laneStats;
+// Baked visibility of the light, looked up by the shadow kernel
+layout (set = 0, binding = 19) uniform sampler3D sunVisibility;
+// Ambient occlusion shared between pixels, updated by the ambient kernel
+layout (set = 0, binding = 20) coherent buffer AmbientCache {
+    AoCacheEntry aoCache[];
+};
+// Occupancy mips for cone traced ambient occlusion
+layout (set = 0, binding = 21) uniform sampler3D occupancy;
+// Per-pixel ambient sample counts, stored as unorm
+layout (set = 0, binding = 22) uniform sampler2D sampleMap;
+// Distance each tile's primary rays may start from, reprojected from the previous frame or traced as a beam
+layout (set = 0, binding = 23) uniform sampler2D depthTiles;
+// Tiles of the primary dispatch classified as able to reach the volume, packed as pixels
+layout (set = 0, binding = 24) buffer TileQueue {
+    uint tiles[];
+};
+
+#include "voxel_tracing.glsl"
+
+const uint QUEUE_GROUP_SIZE = 64;
+
+uint packPixel(ivec2 pixel)
+{
+    return uint(pixel.x) | (uint(pixel.y) << 16);
+}
+
+ivec2 unpackPixel(uint pixel)
+{
+    return ivec2(pixel & 0xFFFF, pixel >> 16);
+}
+
+// Normals are axis aligned, so only the axis and sign need to be stored
+uint packMaterialFace(uint material, vec3 normal)
+{
+    uint axis = abs(normal.x) > 0.5 ? 0 : (abs(normal.y) > 0.5 ? 1 : 2);
+    uint positive = dot(normal, vec3(1.0)) > 0.0 ? 1 : 0;
+    return material | ((axis * 2 + positive) << 8);
+}
+
+uint unpackMaterial(uint materialFace)
+{
+    return materialFace & 0xFF;
+}
+
+vec3 unpackNormal(uint materialFace)
+{
+    uint face = materialFace >> 8;
+    vec3 normal = vec3(0.0);
+    normal[face / 2] = (face % 2 == 1) ? 1.0 : -1.0;
+    return normal;
+}
+
+// Queue slots are reserved with one atomic per subgroup, keeping each queue compact
+void enqueueHit(RayHit hit, ivec2 pixel)
+{
+    uvec4 ballot = subgroupBallot(true);
+    uint first = 0;
+    if (subgroupElect())
+        first = atomicAdd(queues.hitCount[pushConstants.depth], subgroupBallotBitCount(ballot));
+    uint index = subgroupBroadcastFirst(first) + subgroupBallotExclusiveBitCount(ballot);
+
+    hits[index] = HitItem(hit.pos, packPixel(pixel), hit.dir, packMaterialFace(hit.material, hit.normal));
+}
+
+void enqueueRay(vec3 origin, vec3 dir, ivec2 pixel)
+{
+    uvec4 ballot = subgroupBallot(true);
+    uint first = 0;
+    if (subgroupElect())
+        first = atomicAdd(queues.rayCount[pushConstants.depth + 1], subgroupBallotBitCount(ballot));
+    uint index = subgroupBroadcastFirst(first) + subgroupBallotExclusiveBitCount(ballot);
+
+    rays[index] = RayItem(origin, packPixel(pixel), dir, 0);
+}
+
+// Pixel of a primary invocation within its tile of the primary dispatch.
+// Under checkerboard rendering, the half of a checkerboard traced this frame is dispatched as half as many columns
+ivec2 primaryPixel(uvec2 tile)
+{
+    ivec2 pixel = ivec2(tile * gl_WorkGroupSize.xy + gl_LocalInvocationID.xy);
+    if (checkerboard != 0)
+        pixel.x = pixel.x * 2 + int((uint(pixel.y) + pushConstants.frame) & 1u);
+    return pixel;
+}
+
+// Camera ray through a pixel, matching the fragment tracer's pixel centers
+vec3 pixelRayDir(ivec2 pixel)
+{
+    vec2 screenPos = (vec2(pixel) + 0.5) / vec2(pushConstants.screenSize) * 2.0 - 1.0;
+    return cameraRayDir(screenPos);
+}
+
+// Writes the G-buffer and path state of a pixel whose primary ray escaped to the sky
+void writeSkyPixel(ivec2 pixel, vec3 rayDir)
+{
+    imageStore(throughput, pixel, vec4(1.0));
+    imageStore(radiance, pixel, vec4(skyColor(rayDir).rgb, 1.0));
+    imageStore(outDepth, pixel, vec4(0.0));
+    imageStore(outMask, pixel, vec4(0.0));
+    imageStore(outMotion, pixel, vec4(motionVector(vec4(rayDir, 0.0)), 0.0, 0.0));
+    imageStore(outNormal, pixel, vec4(encodeNormal(vec3(0.0))));
+}
+
+void addRadiance(ivec2 pixel, vec3 value)
+{
+    vec4 current = imageLoad(radiance, pixel);
+    imageStore(radiance, pixel, vec4(current.rgb + value, 1.0));
+}
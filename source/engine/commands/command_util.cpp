@@ -22,6 +22,17 @@ void cmdutil::imageMemoryBarrier(vk::CommandBuffer commandBuffer, vk::Image imag
     presentBarrier.image = nullptr;
 }
 
+void cmdutil::memoryBarrier(vk::CommandBuffer commandBuffer,
+                            vk::AccessFlags srcAccess, vk::AccessFlags dstAccess,
+                            vk::PipelineStageFlags srcStage, vk::PipelineStageFlags dstStage)
+{
+    vk::MemoryBarrier barrier = {};
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    commandBuffer.pipelineBarrier(srcStage, dstStage, vk::DependencyFlags(0),
+                                  1, &barrier, 0, nullptr, 0, nullptr);
+}
+
 void cmdutil::blit(vk::CommandBuffer commandBuffer,
                    vk::Image src, glm::ivec2 srcOffset, glm::ivec2 srcSize,
                    vk::Image dst, glm::ivec2 dstOffset, glm::ivec2 dstSize)
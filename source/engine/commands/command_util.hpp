@@ -11,6 +11,11 @@ namespace cmdutil
                             vk::PipelineStageFlags srcStage, vk::PipelineStageFlags dstStage,
                             vk::ImageAspectFlagBits aspect);
 
+    // Global barrier covering all buffers, for resources that aren't tracked individually
+    void memoryBarrier(vk::CommandBuffer commandBuffer,
+                       vk::AccessFlags srcAccess, vk::AccessFlags dstAccess,
+                       vk::PipelineStageFlags srcStage, vk::PipelineStageFlags dstStage);
+
     void blit(vk::CommandBuffer commandBuffer,
               vk::Image src, glm::ivec2 srcOffset, glm::ivec2 srcSize,
               vk::Image dst, glm::ivec2 dstOffset, glm::ivec2 dstSize);
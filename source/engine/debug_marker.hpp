@@ -21,7 +21,8 @@ namespace DebugMarker
             { std::type_index(typeid(VkImageView)), vk::ObjectType::eImageView },
             { std::type_index(typeid(VkSampler)), vk::ObjectType::eSampler },
             { std::type_index(typeid(VkBuffer)), vk::ObjectType::eBuffer },
-            { std::type_index(typeid(VkDescriptorSet)), vk::ObjectType::eDescriptorSet }
+            { std::type_index(typeid(VkDescriptorSet)), vk::ObjectType::eDescriptorSet },
+            { std::type_index(typeid(VkDescriptorSetLayout)), vk::ObjectType::eDescriptorSetLayout }
         };
 
         setObjectName(device, reinterpret_cast<uint64_t>(object), objectMap[typeid(T)], name);
@@ -7,6 +7,7 @@
 #include <VkBootstrap.h>
 #include <fmt/format.h>
 #include <chrono>
+#include <array>
 #include "engine/renderer.hpp"
 
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
@@ -59,6 +60,7 @@ void Engine::draw(float delta)
     // Wait for GPU to finish work
     res = device.waitForFences(1, &renderFence, true, 1000000000);
     vk::resultCheck(res, "Error waiting for fences");
+    uniforms->beginFrame(flightFrame);
 
     // Request image from swapchain
     vk::ResultValue<uint32_t> imageIndexResult = device.acquireNextImageKHR(swapchain.swapchain, 1000000000, presentSemaphore);
@@ -94,12 +96,26 @@ void Engine::draw(float delta)
     // End command buffer
     commandBuffer.end();
 
-    // Submit command buffer to queue
+    // Send off any uploads recorded this frame in a single batch
+    uploads->flush();
+
+    // Submit command buffer to queue, waiting for uploads before any shader reads them
+    std::array<vk::Semaphore, 2> waitSemaphores = { presentSemaphore, uploads->timeline };
+    std::array<vk::PipelineStageFlags, 2> waitStages = {
+        vk::PipelineStageFlagBits::eColorAttachmentOutput,
+        vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader
+    };
+    // The binary semaphore's value is ignored
+    std::array<uint64_t, 2> waitValues = { 0, uploads->flushedValue() };
+    vk::TimelineSemaphoreSubmitInfo timelineInfo;
+    timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+    timelineInfo.pWaitSemaphoreValues = waitValues.data();
+
     vk::SubmitInfo submitInfo;
-    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-    submitInfo.pWaitDstStageMask = &waitStage;
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &presentSemaphore;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = &renderSemaphore;
     submitInfo.commandBufferCount = 1;
@@ -140,8 +156,14 @@ void Engine::resize()
     device.waitIdle();
 }
 
+uint32_t Engine::frameCount() const
+{
+    return _frameCount;
+}
+
 void Engine::destroy() {
     device.waitIdle();
+    pipelineCache.save();
     deletionQueue.destroy_all();
 
     _initialized = false;
@@ -221,13 +243,18 @@ void Engine::initVulkan() {
 
     // Select physical device (GPU)
     VkPhysicalDeviceFeatures required10Features = {};
+    // Ray statistics are written from fragment shaders, and the wavefront tracer stores into R8 and RG32F images
+    required10Features.fragmentStoresAndAtomics = true;
+    required10Features.shaderStorageImageExtendedFormats = true;
     //required10Features.shaderInt16 = true;
     VkPhysicalDeviceVulkan11Features required11Features = {};
     VkPhysicalDeviceVulkan12Features required12Features = {};
     //required12Features.shaderFloat16 = true;
+    // Upload completion is tracked with a timeline semaphore
+    required12Features.timelineSemaphore = true;
     vkb::PhysicalDeviceSelector physicalDeviceSelector(vkbInstance);
     auto physicalDeviceResult = physicalDeviceSelector
-        .set_minimum_version(1, 1)
+        .set_minimum_version(1, 2)
         .set_surface(surface)
         .set_required_features(required10Features)
         .set_required_features_11(required11Features)
@@ -239,6 +266,19 @@ void Engine::initVulkan() {
     vkb::PhysicalDevice vkbPhysicalDevice = physicalDeviceResult.value();
     physicalDevice = vkbPhysicalDevice.physical_device;
 
+    // Lane statistics are gathered with subgroup arithmetic in the fragment tracer as well as the compute kernels,
+    // and the wavefront queues are compacted with ballots
+    auto subgroupChain = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceSubgroupProperties>();
+    const vk::PhysicalDeviceSubgroupProperties& subgroupProperties = subgroupChain.get<vk::PhysicalDeviceSubgroupProperties>();
+    vk::ShaderStageFlags requiredSubgroupStages = vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute;
+    vk::SubgroupFeatureFlags requiredSubgroupOperations = vk::SubgroupFeatureFlagBits::eBasic | vk::SubgroupFeatureFlagBits::eArithmetic | vk::SubgroupFeatureFlagBits::eBallot;
+    if ((subgroupProperties.supportedStages & requiredSubgroupStages) != requiredSubgroupStages
+        || (subgroupProperties.supportedOperations & requiredSubgroupOperations) != requiredSubgroupOperations)
+    {
+        throw std::runtime_error(fmt::format("Physical device {} lacks subgroup basic, arithmetic and ballot operations in fragment and compute shaders",
+                                             vkbPhysicalDevice.properties.deviceName));
+    }
+
     // Create logical device
     vkb::DeviceBuilder deviceBuilder(vkbPhysicalDevice);
     auto deviceResult = deviceBuilder.build();
@@ -270,6 +310,17 @@ void Engine::initVulkan() {
     // Get queues from device
     graphicsQueue = vkbDevice.get_queue(vkb::QueueType::graphics).value();
     graphicsQueueFamily = vkbDevice.get_queue_index(vkb::QueueType::graphics).value();
+    auto transferQueueResult = vkbDevice.get_dedicated_queue(vkb::QueueType::transfer);
+    if (transferQueueResult)
+    {
+        transferQueue = transferQueueResult.value();
+        transferQueueFamily = vkbDevice.get_dedicated_queue_index(vkb::QueueType::transfer).value();
+    }
+    else
+    {
+        transferQueue = graphicsQueue;
+        transferQueueFamily = graphicsQueueFamily;
+    }
 
     // Create swapchain
     swapchain.init(shared_from_this());
@@ -286,7 +337,7 @@ void Engine::initVulkan() {
     });
 
     // Create command buffers
-    vk::CommandBufferAllocateInfo uploadCommandBufferInfo(renderCommandPool, vk::CommandBufferLevel::ePrimary, MAX_FRAMES_IN_FLIGHT);
+    vk::CommandBufferAllocateInfo uploadCommandBufferInfo(uploadCommandPool, vk::CommandBufferLevel::ePrimary, 1);
     auto uploadCommandBufferResult = device.allocateCommandBuffers(uploadCommandBufferInfo);
     uploadCommandBuffer = uploadCommandBufferResult.front();
     vk::CommandBufferAllocateInfo renderCommandBufferInfo(renderCommandPool, vk::CommandBufferLevel::ePrimary, MAX_FRAMES_IN_FLIGHT);
@@ -295,21 +346,17 @@ void Engine::initVulkan() {
         return renderCommandBufferResult[i];
     });
 
-    // Create descriptor pool
-    std::vector<vk::DescriptorPoolSize> sizes =
-    {
-        { vk::DescriptorType::eUniformBuffer, 1000 },
-        { vk::DescriptorType::eCombinedImageSampler, 1000 }
-    };
-    vk::DescriptorPoolCreateInfo descriptorPoolInfo {};
-    descriptorPoolInfo.maxSets = 100;
-    descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(sizes.size());
-    descriptorPoolInfo.pPoolSizes = sizes.data();
-    descriptorPoolInfo.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
-    descriptorPool = device.createDescriptorPool(descriptorPoolInfo);
-    deletionQueue.push_group([=]() {
-        device.destroy(descriptorPool);
-    });
+    // Create descriptor allocator, which adds pools as needed
+    descriptors.emplace(shared_from_this(), 64);
+
+    // Create upload manager, with enough staging memory for a typical scene
+    uploads.emplace(shared_from_this(), transferQueue, transferQueueFamily, 64 * 1024 * 1024);
+
+    // Create per-frame uniform allocator
+    uniforms.emplace(shared_from_this(), 64 * 1024);
+
+    // Load compiled pipelines from the last run
+    pipelineCache.init(shared_from_this(), PipelineCache::defaultPath());
 }
 
 void Engine::initSyncStructures() {
@@ -348,10 +395,6 @@ void Engine::initSyncStructures() {
 
 void Engine::upload_submit(const std::function<void(const vk::CommandBuffer& cmd)>& recordCommands)
 {
-    device.waitIdle();
-
-    uploadCommandBuffer.reset();
-
     // Begin command buffer
     vk::CommandBufferBeginInfo cmdBeginInfo;
     cmdBeginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
@@ -367,9 +410,13 @@ void Engine::upload_submit(const std::function<void(const vk::CommandBuffer& cmd
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &uploadCommandBuffer;
 
-    auto res = graphicsQueue.submit(1, &submitInfo, VK_NULL_HANDLE);
+    // Wait on a fence for just this submission, rather than idling the whole device
+    vk::Fence uploadFence = device.createFence({});
+    auto res = graphicsQueue.submit(1, &submitInfo, uploadFence);
     vk::resultCheck(res, "Error submitting upload command buffer");
+    res = device.waitForFences(1, &uploadFence, true, UINT64_MAX);
+    vk::resultCheck(res, "Error waiting for upload");
+    device.destroy(uploadFence);
 
-    device.waitIdle();
     device.resetCommandPool(uploadCommandPool);
 }
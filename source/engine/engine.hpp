@@ -8,6 +8,10 @@
 #pragma warning(pop)
 #include <glm/glm.hpp>
 #include "engine/swapchain.hpp"
+#include "engine/pipeline_cache.hpp"
+#include "engine/upload_manager.hpp"
+#include "engine/resource/uniform_ring.hpp"
+#include "engine/pipeline/descriptor_allocator.hpp"
 #include "util/deletion_queue.hpp"
 #include "util/resource_ring.hpp"
 #include "recreation_queue.hpp"
@@ -48,14 +52,22 @@ public:
 
     vk::Queue graphicsQueue;
     uint32_t graphicsQueueFamily;
+    // A dedicated transfer queue when the device has one, otherwise the graphics queue
+    vk::Queue transferQueue;
+    uint32_t transferQueueFamily;
 
     vk::CommandPool renderCommandPool;
     ResourceRing<vk::CommandBuffer> renderCommandBuffers;
 
     vk::CommandPool uploadCommandPool;
     vk::CommandBuffer uploadCommandBuffer;
+    std::optional<UploadManager> uploads;
+    // Per-frame uniform data, reset at the start of each frame
+    std::optional<UniformRing> uniforms;
 
-    vk::DescriptorPool descriptorPool;
+    std::optional<DescriptorAllocator> descriptors;
+
+    PipelineCache pipelineCache;
 
     ResourceRing<vk::Semaphore> presentSemaphores;
     ResourceRing<vk::Semaphore> renderSemaphores;
@@ -73,6 +85,11 @@ public:
     void run();
     void destroy();
 
+    // Number of frames drawn so far
+    uint32_t frameCount() const;
+
+    // Records and runs commands on the graphics queue, blocking until they finish.
+    // Prefer the upload manager, unless the commands need graphics queue capabilities.
     void upload_submit(const std::function<void(const vk::CommandBuffer& cmd)>& recordCommands);
 
 private:
@@ -0,0 +1,56 @@
+#include "gpu_timer.hpp"
+
+#include "engine/engine.hpp"
+
+GpuTimer::GpuTimer(const std::shared_ptr<Engine>& engine) : AResource(engine)
+{
+    // Two timestamps per flight frame
+    vk::QueryPoolCreateInfo queryPoolInfo;
+    queryPoolInfo.queryType = vk::QueryType::eTimestamp;
+    queryPoolInfo.queryCount = MAX_FRAMES_IN_FLIGHT * 2;
+    _queryPool = engine->device.createQueryPool(queryPoolInfo);
+
+    vk::QueryPool localQueryPool = _queryPool;
+    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
+        delEngine->device.destroy(localQueryPool);
+    });
+
+    _timestampPeriod = engine->physicalDevice.getProperties().limits.timestampPeriod;
+    std::vector<vk::QueueFamilyProperties> queueFamilies = engine->physicalDevice.getQueueFamilyProperties();
+    _supported = queueFamilies[engine->graphicsQueueFamily].timestampValidBits > 0;
+
+    _written = std::vector<bool>(MAX_FRAMES_IN_FLIGHT, false);
+}
+
+void GpuTimer::begin(const vk::CommandBuffer& cmd, uint32_t flightFrame)
+{
+    if (!_supported)
+        return;
+
+    uint32_t firstQuery = flightFrame * 2;
+
+    // The fence for this flight frame has already been waited on, so its results are available
+    if (_written[flightFrame])
+    {
+        uint64_t timestamps[2];
+        vk::Result res = engine->device.getQueryPoolResults(_queryPool, firstQuery, 2, sizeof(timestamps), timestamps,
+                                                            sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+        if (res == vk::Result::eSuccess)
+        {
+            lastFrameMs = static_cast<float>(timestamps[1] - timestamps[0]) * _timestampPeriod / 1000000.0f;
+            valid = true;
+        }
+    }
+
+    cmd.resetQueryPool(_queryPool, firstQuery, 2);
+    cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, _queryPool, firstQuery);
+}
+
+void GpuTimer::end(const vk::CommandBuffer& cmd, uint32_t flightFrame)
+{
+    if (!_supported)
+        return;
+
+    cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, _queryPool, flightFrame * 2 + 1);
+    _written[flightFrame] = true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "engine/resource.hpp"
+
+// Measures the GPU time spent on each frame's command buffer using timestamp queries.
+// Results are read back one flight frame later, once the frame's fence has been waited on.
+class GpuTimer : public AResource
+{
+public:
+    // Duration of the most recently completed frame, in milliseconds
+    float lastFrameMs = 0.0f;
+    // Whether lastFrameMs holds a real measurement yet
+    bool valid = false;
+
+private:
+    vk::QueryPool _queryPool;
+    float _timestampPeriod;
+    bool _supported;
+    std::vector<bool> _written;
+
+public:
+    GpuTimer(const std::shared_ptr<Engine>& engine);
+
+    // Reads back the previous results for this flight frame, then starts timing.
+    // Must be recorded outside of a render pass.
+    void begin(const vk::CommandBuffer& cmd, uint32_t flightFrame);
+    void end(const vk::CommandBuffer& cmd, uint32_t flightFrame);
+};
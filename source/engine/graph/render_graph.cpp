@@ -0,0 +1,297 @@
+#include "render_graph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/format.h>
+#include "engine/engine.hpp"
+
+static const vk::AccessFlags WRITE_ACCESS = vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eTransferWrite;
+
+struct AccessInfo
+{
+    vk::ImageLayout layout;
+    vk::PipelineStageFlags stages;
+    vk::AccessFlags access;
+};
+
+static AccessInfo accessInfo(ImageAccess access, bool write)
+{
+    switch (access)
+    {
+        case ImageAccess::ColorAttachment:
+            return { vk::ImageLayout::eColorAttachmentOptimal, vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                     write ? vk::AccessFlagBits::eColorAttachmentWrite : vk::AccessFlagBits::eColorAttachmentRead };
+        case ImageAccess::FragmentSampled:
+            return { vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead };
+        case ImageAccess::ComputeSampled:
+            return { vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead };
+        case ImageAccess::ComputeStorage:
+            return { vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits::eComputeShader,
+                     write ? vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite : vk::AccessFlagBits::eShaderRead };
+    }
+    throw std::runtime_error("Unknown image access.");
+}
+
+RenderGraphPass& RenderGraphPass::read(const std::string& image, ImageAccess access)
+{
+    _accesses.push_back({ image, access, false });
+    return *this;
+}
+
+RenderGraphPass& RenderGraphPass::write(const std::string& image, ImageAccess access)
+{
+    _accesses.push_back({ image, access, true });
+    return *this;
+}
+
+RenderGraph::RenderGraph(const std::shared_ptr<Engine>& engine) : AResource(engine) {}
+
+void RenderGraph::transient(const std::string& name, const GraphImageDesc& desc)
+{
+    Transient transient;
+    transient.desc = desc;
+    _transients.emplace(name, std::move(transient));
+}
+
+void RenderGraph::external(const std::string& name)
+{
+    _externals.emplace(name, nullptr);
+}
+
+RenderGraphPass& RenderGraph::pass(const std::string& name)
+{
+    return _passes.emplace_back(name);
+}
+
+void RenderGraph::compile()
+{
+    // Find the span of passes each transient is used in
+    for (int32_t i = 0; i < static_cast<int32_t>(_passes.size()); i++)
+    {
+        for (const RenderGraphPass::Access& access : _passes[i]._accesses)
+        {
+            auto transientIt = _transients.find(access.image);
+            if (transientIt == _transients.end())
+            {
+                if (_externals.find(access.image) == _externals.end())
+                    throw std::runtime_error(fmt::format("Render graph pass {} uses undeclared image {}.", _passes[i]._name, access.image));
+                continue;
+            }
+
+            transientIt->second.firstPass = std::min(transientIt->second.firstPass, i);
+            transientIt->second.lastPass = std::max(transientIt->second.lastPass, i);
+        }
+    }
+
+    // Query what each transient needs from memory
+    std::vector<std::pair<std::string, vk::MemoryRequirements>> requirements;
+    for (const auto& [name, transient] : _transients)
+    {
+        vk::Image probe = engine->device.createImage(RenderImage::createInfo(transient.desc.size.x, transient.desc.size.y, transient.desc.format, transient.desc.usage));
+        requirements.emplace_back(name, engine->device.getImageMemoryRequirements(probe));
+        engine->device.destroy(probe);
+    }
+
+    // Place the largest transients first, each in the first block whose occupants' lifetimes it doesn't overlap
+    std::sort(requirements.begin(), requirements.end(), [](const auto& a, const auto& b) {
+        return a.second.size > b.second.size;
+    });
+    _memory = {};
+    for (const auto& entry : requirements)
+    {
+        const std::string& name = entry.first;
+        const vk::MemoryRequirements& requirement = entry.second;
+        Transient& transient = _transients.at(name);
+        _memory.requestedBytes += requirement.size;
+
+        auto fits = [&](const Block& block) {
+            if ((block.requirements.memoryTypeBits & requirement.memoryTypeBits) == 0)
+                return false;
+            for (const std::string& occupantName : block.occupants)
+            {
+                const Transient& occupant = _transients.at(occupantName);
+                if (transient.firstPass <= occupant.lastPass && occupant.firstPass <= transient.lastPass)
+                    return false;
+            }
+            return true;
+        };
+        auto blockIt = std::find_if(_blocks.begin(), _blocks.end(), fits);
+        if (blockIt == _blocks.end())
+        {
+            _blocks.emplace_back();
+            blockIt = std::prev(_blocks.end());
+            blockIt->requirements = requirement;
+        }
+
+        blockIt->requirements.size = std::max(blockIt->requirements.size, requirement.size);
+        blockIt->requirements.alignment = std::max(blockIt->requirements.alignment, requirement.alignment);
+        blockIt->requirements.memoryTypeBits &= requirement.memoryTypeBits;
+        blockIt->occupants.push_back(name);
+        transient.block = static_cast<uint32_t>(std::distance(_blocks.begin(), blockIt));
+    }
+
+    // Allocate each block, and create its occupants on top of it
+    for (Block& block : _blocks)
+    {
+        VmaAllocationCreateInfo allocInfo = {};
+        allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+        allocInfo.requiredFlags = VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+        VkMemoryRequirements requirementsC = VkMemoryRequirements(block.requirements);
+        VmaAllocation allocation;
+        auto res = vmaAllocateMemory(engine->allocator, &requirementsC, &allocInfo, &allocation, nullptr);
+        vk::resultCheck(vk::Result(res), "Error allocating render graph memory");
+        block.allocation = allocation;
+        pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
+            vmaFreeMemory(delEngine->allocator, allocation);
+        });
+        _memory.allocatedBytes += block.requirements.size;
+
+        for (const std::string& name : block.occupants)
+        {
+            Transient& transient = _transients.at(name);
+            transient.image.emplace(engine, transient.desc.size.x, transient.desc.size.y, transient.desc.format, transient.desc.usage,
+                                    vk::ImageAspectFlagBits::eColor, name, allocation);
+        }
+    }
+}
+
+void RenderGraph::release()
+{
+    for (const auto& [name, transient] : _transients)
+    {
+        if (transient.image.has_value())
+            transient.image->destroy();
+    }
+    resetDestroy();
+
+    _transients.clear();
+    _externals.clear();
+    _passes.clear();
+    _blocks.clear();
+    _memory = {};
+}
+
+void RenderGraph::bindExternal(const std::string& name, const RenderImage& image)
+{
+    auto externalIt = _externals.find(name);
+    if (externalIt == _externals.end())
+        throw std::runtime_error(fmt::format("Render graph image {} is not declared as external.", name));
+    externalIt->second = &image;
+}
+
+void RenderGraph::forgetExternal(const RenderImage& image)
+{
+    _externalStates.erase(static_cast<VkImage>(image.image));
+}
+
+const RenderImage& RenderGraph::image(const std::string& name) const
+{
+    auto transientIt = _transients.find(name);
+    if (transientIt != _transients.end())
+        return *transientIt->second.image;
+
+    auto externalIt = _externals.find(name);
+    if (externalIt == _externals.end() || externalIt->second == nullptr)
+        throw std::runtime_error(fmt::format("Render graph image {} is not declared, or not bound this frame.", name));
+    return *externalIt->second;
+}
+
+void RenderGraph::beginFrame()
+{
+    for (auto& [name, image] : _externals)
+        image = nullptr;
+    for (Block& block : _blocks)
+        block.occupant.reset();
+}
+
+void RenderGraph::beginPass(const vk::CommandBuffer& cmd, const std::string& name)
+{
+    auto passIt = std::find_if(_passes.begin(), _passes.end(), [&](const RenderGraphPass& pass) {
+        return pass._name == name;
+    });
+    if (passIt == _passes.end())
+        throw std::runtime_error(fmt::format("Render graph pass {} is not declared.", name));
+
+    std::vector<vk::ImageMemoryBarrier> barriers;
+    vk::PipelineStageFlags srcStages;
+    vk::PipelineStageFlags dstStages;
+    for (const RenderGraphPass::Access& access : passIt->_accesses)
+    {
+        AccessInfo info = accessInfo(access.access, access.write);
+        vk::Image image;
+        ImageState& current = state(access.image, image);
+
+        vk::ImageMemoryBarrier barrier = {};
+        barrier.image = image;
+        barrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+        barrier.oldLayout = current.layout;
+        barrier.newLayout = info.layout;
+        barrier.dstAccessMask = info.access;
+
+        if (current.layout != info.layout || access.write)
+        {
+            // Transitions and writes wait for every earlier access
+            barrier.srcAccessMask = current.writeAccess;
+            srcStages |= current.writeStages | current.readStages;
+
+            current.layout = info.layout;
+            current.writeStages = info.stages;
+            current.writeAccess = info.access & WRITE_ACCESS;
+            // A write isn't visible to anything yet, not even later passes in its own stages
+            current.visibleStages = access.write ? vk::PipelineStageFlags() : info.stages;
+            current.readStages = access.write ? vk::PipelineStageFlags() : info.stages;
+        }
+        else if ((info.stages & ~current.visibleStages) && current.writeStages)
+        {
+            // Reads only wait for the last write, and only once per stage
+            barrier.srcAccessMask = current.writeAccess;
+            srcStages |= current.writeStages;
+
+            current.visibleStages |= info.stages;
+            current.readStages |= info.stages;
+        }
+        else
+        {
+            current.readStages |= info.stages;
+            continue;
+        }
+
+        dstStages |= info.stages;
+        barriers.push_back(barrier);
+    }
+
+    if (barriers.empty())
+        return;
+
+    if (!srcStages)
+        srcStages = vk::PipelineStageFlagBits::eTopOfPipe;
+    cmd.pipelineBarrier(srcStages, dstStages, vk::DependencyFlags(0),
+                        0, nullptr, 0, nullptr,
+                        static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+const RenderGraphMemory& RenderGraph::memory() const
+{
+    return _memory;
+}
+
+RenderGraph::ImageState& RenderGraph::state(const std::string& name, vk::Image& image)
+{
+    auto transientIt = _transients.find(name);
+    if (transientIt == _transients.end())
+    {
+        image = this->image(name).image;
+        return _externalStates[static_cast<VkImage>(image)];
+    }
+
+    // Transients hold nothing between frames, or once another transient has used their memory
+    Block& block = _blocks[transientIt->second.block];
+    image = transientIt->second.image->image;
+    if (block.occupant != name)
+    {
+        block.state.layout = vk::ImageLayout::eUndefined;
+        block.occupant = name;
+    }
+    return block.state;
+}
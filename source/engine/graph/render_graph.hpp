@@ -0,0 +1,155 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+#include <vk_mem_alloc.h>
+#include "engine/resource.hpp"
+#include "engine/resource/render_image.hpp"
+
+class Engine;
+
+// How a pass uses an image, from which the graph derives layouts, pipeline stages and access masks.
+enum class ImageAccess
+{
+    // Written as a color attachment of a render pass
+    ColorAttachment,
+    // Sampled from fragment shaders
+    FragmentSampled,
+    // Sampled from compute shaders
+    ComputeSampled,
+    // Read and written as a storage image from compute shaders
+    ComputeStorage
+};
+
+// Properties of an image created by the graph.
+struct GraphImageDesc
+{
+    glm::uvec2 size;
+    vk::Format format;
+    vk::ImageUsageFlags usage;
+};
+
+// VRAM used by the graph's transient images.
+struct RenderGraphMemory
+{
+    // What the transients would take with dedicated memory each
+    vk::DeviceSize requestedBytes = 0;
+    // What they take with memory shared between transients whose lifetimes don't overlap
+    vk::DeviceSize allocatedBytes = 0;
+};
+
+// A pass declared in the graph, in execution order.
+class RenderGraphPass
+{
+private:
+    struct Access
+    {
+        std::string image;
+        ImageAccess access;
+        bool write;
+    };
+
+    std::string _name;
+    std::vector<Access> _accesses;
+
+    friend class RenderGraph;
+
+public:
+    explicit RenderGraphPass(const std::string& name) : _name(name) {}
+
+    // Declares that the pass reads the named image.
+    RenderGraphPass& read(const std::string& image, ImageAccess access);
+    // Declares that the pass writes the named image.
+    RenderGraphPass& write(const std::string& image, ImageAccess access);
+};
+
+// Orders the frame's image accesses between passes, and owns the images which only live within a frame.
+// Passes and images are declared by name, then the graph is compiled, which allocates transient images,
+// sharing memory between those whose lifetimes don't overlap.
+// While recording, each pass is begun through the graph, which issues the barriers and layout transitions
+// its declared accesses need, based on the tracked state of each image.
+// Must only be used from the render thread.
+class RenderGraph : public AResource
+{
+private:
+    struct ImageState
+    {
+        vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+        // Last write, including layout transitions
+        vk::PipelineStageFlags writeStages;
+        vk::AccessFlags writeAccess;
+        // Stages which have waited for the last write
+        vk::PipelineStageFlags visibleStages;
+        // Stages which have read since the last write, which the next write must wait for
+        vk::PipelineStageFlags readStages;
+    };
+
+    struct Transient
+    {
+        GraphImageDesc desc;
+        // First and last pass using the image, empty if unused
+        int32_t firstPass = INT32_MAX;
+        int32_t lastPass = -1;
+        uint32_t block = 0;
+        std::optional<RenderImage> image;
+    };
+
+    // Memory shared by transients, holding one at a time
+    struct Block
+    {
+        vk::MemoryRequirements requirements;
+        std::vector<std::string> occupants;
+        VmaAllocation allocation = nullptr;
+        // State of whichever occupant used the memory last
+        ImageState state;
+        // Occupant the memory currently holds, if any this frame
+        std::optional<std::string> occupant;
+    };
+
+    std::unordered_map<std::string, Transient> _transients;
+    std::unordered_map<std::string, const RenderImage*> _externals;
+    std::deque<RenderGraphPass> _passes;
+    std::vector<Block> _blocks;
+    RenderGraphMemory _memory;
+
+    // External images keep their layouts across frames, until their owner destroys them
+    std::unordered_map<VkImage, ImageState> _externalStates;
+
+public:
+    explicit RenderGraph(const std::shared_ptr<Engine>& engine);
+
+    // Declares an image which is created by the graph, and only holds data within a frame.
+    void transient(const std::string& name, const GraphImageDesc& desc);
+    // Declares an image owned elsewhere, which is bound each frame before use.
+    void external(const std::string& name);
+    // Declares the next pass.
+    RenderGraphPass& pass(const std::string& name);
+
+    // Allocates transient images for the declared passes.
+    void compile();
+    // Destroys transient images and discards all declarations.
+    void release();
+
+    // Binds an external image for this frame.
+    void bindExternal(const std::string& name, const RenderImage& image);
+    // Discards the tracked state of an external image, which must be called before destroying it.
+    void forgetExternal(const RenderImage& image);
+    // Returns the named transient or bound external image.
+    const RenderImage& image(const std::string& name) const;
+
+    // Starts the frame, after which every transient's contents are undefined.
+    void beginFrame();
+    // Records the barriers the named pass needs before its commands.
+    void beginPass(const vk::CommandBuffer& cmd, const std::string& name);
+
+    const RenderGraphMemory& memory() const;
+
+private:
+    ImageState& state(const std::string& name, vk::Image& image);
+};
@@ -39,6 +39,7 @@ ImguiRenderer::ImguiRenderer(const std::shared_ptr<Engine>& engine, const vk::Re
 	init_info.Device = engine->device;
 	init_info.Queue = engine->graphicsQueue;
 	init_info.DescriptorPool = imguiPool;
+	init_info.PipelineCache = engine->pipelineCache.cache;
 	init_info.MinImageCount = 3;
 	init_info.ImageCount = 3;
 	init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
@@ -0,0 +1,46 @@
+#include "compute_pipeline.hpp"
+
+#include <chrono>
+#include "engine/engine.hpp"
+
+AComputePipeline::AComputePipeline(const std::shared_ptr<Engine>& engine) : AResource(engine) {}
+
+void AComputePipeline::buildAll()
+{
+    // Create prerequisite pipeline infos
+    vk::PipelineShaderStageCreateInfo shaderStage = buildShaderStage();
+    vk::PipelineLayoutCreateInfo layoutInfo = buildPipelineLayout();
+    if (shaderStage.pSpecializationInfo == nullptr)
+        shaderStage.pSpecializationInfo = _specialization.info();
+
+    // Create layout
+    vk::PipelineLayout createdLayout = engine->device.createPipelineLayout(layoutInfo);
+    layout = createdLayout;
+    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
+        delEngine->device.destroy(createdLayout);
+    });
+
+    // Group together create info
+    vk::ComputePipelineCreateInfo pipelineInfo;
+    pipelineInfo.stage = shaderStage;
+    pipelineInfo.layout = layout;
+
+    // Actually build the pipeline
+    auto createStart = std::chrono::steady_clock::now();
+    auto pipelineResult = engine->device.createComputePipeline(engine->pipelineCache.cache, pipelineInfo);
+    engine->pipelineCache.recordCreation(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - createStart).count());
+    vk::resultCheck(pipelineResult.result, "Error creating compute pipeline");
+    vk::Pipeline createdPipeline = pipelineResult.value;
+    pipeline = createdPipeline;
+    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
+        delEngine->device.destroy(createdPipeline);
+    });
+
+    pipelineDeletionQueue.destroy_all();
+}
+
+vk::PipelineLayoutCreateInfo AComputePipeline::buildPipelineLayout()
+{
+    // Defaults are fine for layout
+    return {};
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <memory>
+#include <vulkan/vulkan.hpp>
+#include "util/deletion_queue.hpp"
+#include "engine/resource.hpp"
+#include "engine/pipeline/specialization.hpp"
+
+class Engine;
+
+// An abstract Vulkan compute pipeline.
+// Different kernels should be implemented as subclasses of this base class.
+class AComputePipeline : public AResource
+{
+public:
+    vk::Pipeline pipeline;
+    vk::PipelineLayout layout;
+
+protected:
+    DeletionQueue pipelineDeletionQueue;
+
+    // Applied to the shader stage unless it provides its own specialization info
+    SpecializationConstants _specialization;
+
+protected:
+    explicit AComputePipeline(const std::shared_ptr<Engine>& engine);
+
+public:
+    void buildAll();
+
+protected:
+    virtual vk::PipelineShaderStageCreateInfo buildShaderStage() = 0;
+    virtual vk::PipelineLayoutCreateInfo buildPipelineLayout();
+};
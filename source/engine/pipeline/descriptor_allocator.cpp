@@ -0,0 +1,79 @@
+#include "descriptor_allocator.hpp"
+
+#include "engine/engine.hpp"
+
+// Descriptors reserved in each pool, per set
+static const std::vector<std::pair<vk::DescriptorType, uint32_t>> POOL_RATIOS =
+{
+    { vk::DescriptorType::eUniformBuffer, 4 },
+    { vk::DescriptorType::eUniformBufferDynamic, 4 },
+    { vk::DescriptorType::eCombinedImageSampler, 8 },
+    { vk::DescriptorType::eStorageBuffer, 4 },
+    { vk::DescriptorType::eStorageImage, 8 }
+};
+
+DescriptorAllocator::DescriptorAllocator(const std::shared_ptr<Engine>& engine, uint32_t setsPerPool) : AResource(engine), _setsPerPool(setsPerPool)
+{
+    _pools.push_back(createPool());
+}
+
+DescriptorAllocation DescriptorAllocator::allocate(vk::DescriptorSetLayout layout, uint32_t count)
+{
+    std::vector<vk::DescriptorSetLayout> layouts(count, layout);
+    vk::DescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.descriptorSetCount = count;
+    allocInfo.pSetLayouts = layouts.data();
+
+    DescriptorAllocation allocation;
+    allocation.sets.resize(count);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Older pools may have room again after sets were freed
+    for (auto poolIt = _pools.rbegin(); poolIt != _pools.rend(); poolIt++)
+    {
+        allocInfo.descriptorPool = *poolIt;
+        vk::Result res = engine->device.allocateDescriptorSets(&allocInfo, allocation.sets.data());
+        if (res == vk::Result::eSuccess)
+        {
+            allocation.pool = *poolIt;
+            return allocation;
+        }
+        if (res != vk::Result::eErrorOutOfPoolMemory && res != vk::Result::eErrorFragmentedPool)
+            vk::resultCheck(res, "Error allocating descriptor sets");
+    }
+
+    // Every pool is full, so grow
+    vk::DescriptorPool pool = createPool();
+    _pools.push_back(pool);
+    allocInfo.descriptorPool = pool;
+    vk::Result res = engine->device.allocateDescriptorSets(&allocInfo, allocation.sets.data());
+    vk::resultCheck(res, "Error allocating descriptor sets");
+    allocation.pool = pool;
+    return allocation;
+}
+
+void DescriptorAllocator::free(const DescriptorAllocation& allocation)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    engine->device.freeDescriptorSets(allocation.pool, static_cast<uint32_t>(allocation.sets.size()), allocation.sets.data());
+}
+
+vk::DescriptorPool DescriptorAllocator::createPool()
+{
+    std::vector<vk::DescriptorPoolSize> sizes;
+    for (const auto& [type, ratio] : POOL_RATIOS)
+        sizes.emplace_back(type, ratio * _setsPerPool);
+
+    vk::DescriptorPoolCreateInfo poolInfo {};
+    poolInfo.maxSets = _setsPerPool;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(sizes.size());
+    poolInfo.pPoolSizes = sizes.data();
+    poolInfo.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
+    vk::DescriptorPool pool = engine->device.createDescriptorPool(poolInfo);
+    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
+        delEngine->device.destroy(pool);
+    });
+
+    return pool;
+}
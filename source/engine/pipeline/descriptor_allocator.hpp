@@ -0,0 +1,37 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "engine/resource.hpp"
+
+class Engine;
+
+// Descriptor sets allocated together, along with the pool they came from.
+struct DescriptorAllocation
+{
+    vk::DescriptorPool pool;
+    std::vector<vk::DescriptorSet> sets;
+};
+
+// Allocates descriptor sets from a growing list of pools, so the number of stages and passes isn't capped by one fixed pool.
+// Safe to use from multiple threads.
+class DescriptorAllocator : public AResource
+{
+private:
+    uint32_t _setsPerPool;
+    // Newest pool last, which is tried first
+    std::vector<vk::DescriptorPool> _pools;
+    std::mutex _mutex;
+
+public:
+    DescriptorAllocator(const std::shared_ptr<Engine>& engine, uint32_t setsPerPool);
+
+    // Allocates count sets with the given layout, creating a new pool if every existing one is full.
+    DescriptorAllocation allocate(vk::DescriptorSetLayout layout, uint32_t count);
+    // Returns sets to the pool they were allocated from.
+    void free(const DescriptorAllocation& allocation);
+
+private:
+    vk::DescriptorPool createPool();
+};
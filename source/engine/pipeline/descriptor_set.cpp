@@ -3,57 +3,140 @@
 #include "engine/engine.hpp"
 #include "engine/debug_marker.hpp"
 
-const vk::DescriptorSet* DescriptorSet::getSet(uint32_t frame) const
+// Combines a value into a running hash, as in boost::hash_combine
+template<typename T>
+static void hashCombine(size_t& seed, const T& value)
 {
-    return &sets[frame];
+    seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 }
 
-void DescriptorSet::writeBuffer(uint32_t binding, uint32_t frame,
-                                vk::Buffer buffer, vk::DeviceSize size, vk::DescriptorType type) const
+bool DescriptorBindings::Entry::operator==(const Entry& other) const
 {
-    vk::DescriptorBufferInfo bufferInfo {};
-    bufferInfo.buffer = buffer;
-    bufferInfo.offset = 0;
-    bufferInfo.range = size;
-
-    vk::WriteDescriptorSet bufferWrite = {};
-    bufferWrite.dstBinding = binding;
-    bufferWrite.dstSet = sets[frame];
-    bufferWrite.descriptorCount = 1;
-    bufferWrite.descriptorType = type;
-    bufferWrite.pBufferInfo = &bufferInfo;
-
-    engine->device.updateDescriptorSets(1, &bufferWrite, 0, nullptr);
+    return binding == other.binding && type == other.type && buffer == other.buffer && image == other.image;
 }
 
-void DescriptorSet::writeImage(uint32_t binding, uint32_t frame,
-                               vk::ImageView imageView, vk::Sampler sampler, vk::ImageLayout imageLayout) const
+DescriptorBindings& DescriptorBindings::buffer(uint32_t binding, vk::Buffer buffer, vk::DeviceSize size, vk::DescriptorType type)
 {
-    vk::DescriptorImageInfo imageInfo {};
-    imageInfo.sampler = sampler;
-    imageInfo.imageView = imageView;
-    imageInfo.imageLayout = imageLayout;
-
-    vk::WriteDescriptorSet imageWrite = {};
-    imageWrite.dstBinding = binding;
-    imageWrite.dstSet = sets[frame];
-    imageWrite.descriptorCount = 1;
-    imageWrite.descriptorType = vk::DescriptorType::eCombinedImageSampler;
-    imageWrite.pImageInfo = &imageInfo;
-
-    engine->device.updateDescriptorSets(1, &imageWrite, 0, nullptr);
+    Entry entry = {};
+    entry.binding = binding;
+    entry.type = type;
+    entry.buffer.buffer = buffer;
+    entry.buffer.offset = 0;
+    entry.buffer.range = size;
+    return add(entry);
 }
 
-void DescriptorSet::initBuffer(uint32_t binding, vk::Buffer buffer, vk::DeviceSize size, vk::DescriptorType type) const
+DescriptorBindings& DescriptorBindings::image(uint32_t binding, vk::ImageView imageView, vk::Sampler sampler, vk::ImageLayout layout)
 {
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-        writeBuffer(binding, i, buffer, size, type);
+    Entry entry = {};
+    entry.binding = binding;
+    entry.type = vk::DescriptorType::eCombinedImageSampler;
+    entry.image.imageView = imageView;
+    entry.image.sampler = sampler;
+    entry.image.imageLayout = layout;
+    return add(entry);
 }
 
-void DescriptorSet::initImage(uint32_t binding, vk::ImageView imageView, vk::Sampler sampler, vk::ImageLayout imageLayout) const
+DescriptorBindings& DescriptorBindings::storageImage(uint32_t binding, vk::ImageView imageView)
 {
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-        writeImage(binding, i, imageView, sampler, imageLayout);
+    Entry entry = {};
+    entry.binding = binding;
+    entry.type = vk::DescriptorType::eStorageImage;
+    entry.image.imageView = imageView;
+    entry.image.imageLayout = vk::ImageLayout::eGeneral;
+    return add(entry);
+}
+
+DescriptorBindings& DescriptorBindings::add(const Entry& entry)
+{
+    hashCombine(_hash, entry.binding);
+    hashCombine(_hash, static_cast<VkDescriptorType>(entry.type));
+    hashCombine(_hash, static_cast<VkBuffer>(entry.buffer.buffer));
+    hashCombine(_hash, entry.buffer.range);
+    hashCombine(_hash, static_cast<VkImageView>(entry.image.imageView));
+    hashCombine(_hash, static_cast<VkSampler>(entry.image.sampler));
+    hashCombine(_hash, static_cast<VkImageLayout>(entry.image.imageLayout));
+
+    _entries.push_back(entry);
+    return *this;
+}
+
+bool DescriptorBindings::operator==(const DescriptorBindings& other) const
+{
+    return _hash == other._hash && _entries == other._entries;
+}
+
+size_t DescriptorBindings::hash() const
+{
+    return _hash;
+}
+
+void DescriptorBindings::write(vk::Device device, vk::DescriptorSet set) const
+{
+    std::vector<vk::WriteDescriptorSet> writes;
+    writes.reserve(_entries.size());
+    for (const Entry& entry : _entries)
+    {
+        vk::WriteDescriptorSet write = {};
+        write.dstSet = set;
+        write.dstBinding = entry.binding;
+        write.descriptorCount = 1;
+        write.descriptorType = entry.type;
+        if (entry.type == vk::DescriptorType::eCombinedImageSampler || entry.type == vk::DescriptorType::eStorageImage)
+            write.pImageInfo = &entry.image;
+        else
+            write.pBufferInfo = &entry.buffer;
+        writes.push_back(write);
+    }
+
+    device.updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+const vk::DescriptorSet* DescriptorSet::getSet(const DescriptorBindings& bindings) const
+{
+    // Recreated resources can reuse the handles of destroyed ones, so no cached set can be trusted afterwards
+    uint32_t generation = engine->recreationQueue->generation();
+    if (_cache->generation != generation)
+    {
+        collect(true);
+        _cache->generation = generation;
+    }
+
+    uint32_t frame = engine->frameCount();
+    if (_cache->collectedFrame != frame)
+    {
+        collect(false);
+        _cache->collectedFrame = frame;
+    }
+
+    auto setIt = _cache->sets.find(bindings);
+    if (setIt == _cache->sets.end())
+    {
+        CachedSet cached = { engine->descriptors->allocate(layout, 1), frame };
+        bindings.write(engine->device, cached.allocation.sets[0]);
+        DebugMarker::setObjectName(engine->device, (VkDescriptorSet)cached.allocation.sets[0], _cache->name);
+        setIt = _cache->sets.emplace(bindings, std::move(cached)).first;
+    }
+
+    setIt->second.lastUsedFrame = frame;
+    return &setIt->second.allocation.sets[0];
+}
+
+void DescriptorSet::collect(bool all) const
+{
+    uint32_t frame = engine->frameCount();
+    for (auto setIt = _cache->sets.begin(); setIt != _cache->sets.end();)
+    {
+        if (all || frame - setIt->second.lastUsedFrame > MAX_FRAMES_IN_FLIGHT)
+        {
+            engine->descriptors->free(setIt->second.allocation);
+            setIt = _cache->sets.erase(setIt);
+        }
+        else
+        {
+            setIt++;
+        }
+    }
 }
 
 DescriptorSetBuilder& DescriptorSetBuilder::buffer(uint32_t binding, vk::ShaderStageFlags stages, vk::DescriptorType type)
@@ -80,6 +163,18 @@ DescriptorSetBuilder& DescriptorSetBuilder::image(uint32_t binding, vk::ShaderSt
     return *this;
 }
 
+DescriptorSetBuilder& DescriptorSetBuilder::storageImage(uint32_t binding, vk::ShaderStageFlags stages)
+{
+    vk::DescriptorSetLayoutBinding imageBinding {};
+    imageBinding.descriptorType = vk::DescriptorType::eStorageImage;
+    imageBinding.stageFlags = stages;
+    imageBinding.binding = binding;
+    imageBinding.descriptorCount = 1;
+    bindings.push_back(imageBinding);
+
+    return *this;
+}
+
 DescriptorSet DescriptorSetBuilder::build(const std::string& name)
 {
     DescriptorSet descriptorSet(engine);
@@ -95,24 +190,13 @@ DescriptorSet DescriptorSetBuilder::build(const std::string& name)
         delEngine->device.destroy(layout);
     });
 
-    // Create descriptor sets using the layout
-    std::vector<vk::DescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSet.layout);
-    vk::DescriptorSetAllocateInfo descriptorAllocInfo = {};
-    descriptorAllocInfo.descriptorPool = engine->descriptorPool;
-    descriptorAllocInfo.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
-    descriptorAllocInfo.pSetLayouts = layouts.data();
-    auto sceneDescriptorAllocResult = engine->device.allocateDescriptorSets(descriptorAllocInfo);
-    std::vector<vk::DescriptorSet> localSets;
-    descriptorSet.pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
-        delEngine->device.freeDescriptorSets(delEngine->descriptorPool, static_cast<uint32_t>(sceneDescriptorAllocResult.size()), sceneDescriptorAllocResult.data());
-    });
+    DebugMarker::setObjectName(engine->device, (VkDescriptorSetLayout)layout, name);
 
-    // Copy results into our set storage
-    descriptorSet.sets = ResourceRing<vk::DescriptorSet>::fromFunc(MAX_FRAMES_IN_FLIGHT, [&](size_t i) {
-        return sceneDescriptorAllocResult[i];
+    // Sets are allocated as they are first bound
+    descriptorSet._cache->name = name;
+    descriptorSet.pushDeletor([=](const std::shared_ptr<Engine>&) {
+        descriptorSet.collect(true);
     });
 
-    DebugMarker::setObjectName(engine->device, (VkDescriptorSet)descriptorSet.sets[0], name);
-
     return descriptorSet;
 }
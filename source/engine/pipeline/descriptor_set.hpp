@@ -1,43 +1,102 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
 #include "engine/resource.hpp"
 #include "engine/resource_builder.hpp"
-#include "util/resource_ring.hpp"
-#include <vulkan/vulkan.hpp>
+#include "engine/pipeline/descriptor_allocator.hpp"
+
+// The resources bound to each binding of a descriptor set.
+// Used as the key for finding a matching cached set, and to write new ones.
+class DescriptorBindings
+{
+private:
+    struct Entry
+    {
+        uint32_t binding;
+        vk::DescriptorType type;
+        vk::DescriptorBufferInfo buffer;
+        vk::DescriptorImageInfo image;
+
+        bool operator==(const Entry& other) const;
+    };
+
+    std::vector<Entry> _entries;
+    size_t _hash = 0;
+
+public:
+    // Binds the start of a buffer.
+    DescriptorBindings& buffer(uint32_t binding, vk::Buffer buffer, vk::DeviceSize size, vk::DescriptorType type);
+    // Binds a combined image sampler.
+    DescriptorBindings& image(uint32_t binding, vk::ImageView imageView, vk::Sampler sampler, vk::ImageLayout layout);
+    // Binds a storage image, in the general layout.
+    DescriptorBindings& storageImage(uint32_t binding, vk::ImageView imageView);
+
+    bool operator==(const DescriptorBindings& other) const;
+    size_t hash() const;
+
+    // Writes every binding to the given set, in a single update.
+    void write(vk::Device device, vk::DescriptorSet set) const;
+
+private:
+    DescriptorBindings& add(const Entry& entry);
+};
+
+struct DescriptorBindingsHash
+{
+    size_t operator()(const DescriptorBindings& bindings) const
+    {
+        return bindings.hash();
+    }
+};
 
 // Abstraction around creating Vulkan descriptor sets.
 // These should typically be created by pipelines to bind shader uniforms.
-// Each DescriptorSet object will implicitly create a descriptor set for each flight frame.
+// Sets are cached by the resources bound to them, so each combination is allocated and written once,
+// and then reused for as long as it keeps being bound.
 class DescriptorSet : public AResource
 {
 public:
     // The layout of the descriptor set
     vk::DescriptorSetLayout layout;
-    // The actual descriptor set for each frame
-    ResourceRing<vk::DescriptorSet> sets;
+
+private:
+    struct CachedSet
+    {
+        DescriptorAllocation allocation;
+        uint32_t lastUsedFrame;
+    };
+
+    struct Cache
+    {
+        std::string name;
+        std::unordered_map<DescriptorBindings, CachedSet, DescriptorBindingsHash> sets;
+        uint32_t collectedFrame = 0;
+        uint32_t generation = 0;
+    };
+
+    // Shared between copies, so the deletor frees sets allocated through any of them
+    std::shared_ptr<Cache> _cache;
 
 protected:
     // Creates a new descriptor set.
     // Initialization will be completed by the friend builder.
-    explicit DescriptorSet(const std::shared_ptr<Engine>& engine) : AResource(engine) {}
+    explicit DescriptorSet(const std::shared_ptr<Engine>& engine) : AResource(engine), _cache(std::make_shared<Cache>()) {}
 
     friend class DescriptorSetBuilder;
 
 public:
-    // Returns a pointer to the next descriptor set for a given frame.
-    const vk::DescriptorSet* getSet(uint32_t frame) const;
-
-    // Writes buffer data to the descriptor set for the given frame.
-    void writeBuffer(uint32_t binding, uint32_t frame,
-                     vk::Buffer buffer, vk::DeviceSize size, vk::DescriptorType type) const;
-    // Writes image data to the descriptor set for the given frame.
-    void writeImage(uint32_t binding, uint32_t frame,
-                    vk::ImageView imageView, vk::Sampler sampler, vk::ImageLayout layout) const;
-
-    // Writes buffer data to the descriptor set for all frames.
-    void initBuffer(uint32_t binding, vk::Buffer buffer, vk::DeviceSize size, vk::DescriptorType type) const;
-    // Writes image data to the descriptor set for all frames.
-    void initImage(uint32_t binding, vk::ImageView imageView, vk::Sampler sampler, vk::ImageLayout layout) const;
+    // Returns a set with the given resources bound, allocating and writing one if none is cached.
+    // Sets which haven't been returned for MAX_FRAMES_IN_FLIGHT frames are freed, as are all sets once resources are recreated.
+    // Must only be used from the render thread.
+    const vk::DescriptorSet* getSet(const DescriptorBindings& bindings) const;
+
+private:
+    // Frees cached sets, either all of them or those no frame in flight can be using.
+    void collect(bool all) const;
 };
 
 // Builder for descriptor sets.
@@ -55,6 +114,8 @@ public:
     DescriptorSetBuilder& buffer(uint32_t binding, vk::ShaderStageFlags stages, vk::DescriptorType type);
     // Adds an image descriptor at the given binding.
     DescriptorSetBuilder& image(uint32_t binding, vk::ShaderStageFlags stages);
+    // Adds a storage image descriptor at the given binding.
+    DescriptorSetBuilder& storageImage(uint32_t binding, vk::ShaderStageFlags stages);
 
     // Builds the descriptor set.
     DescriptorSet build(const std::string& name) override;
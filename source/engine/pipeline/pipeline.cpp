@@ -1,5 +1,6 @@
 #include "pipeline.hpp"
 
+#include <chrono>
 #include "engine/engine.hpp"
 
 APipeline::APipeline(const std::shared_ptr<Engine>& engine, const vk::RenderPass& pass)
@@ -19,6 +20,13 @@ void APipeline::buildAll()
     vk::PipelineDepthStencilStateCreateInfo depthStencilStateCreateInfo = buildDepthStencil();
     vk::PipelineLayoutCreateInfo layoutInfo = buildPipelineLayout();
 
+    // Stages which don't declare a constant ignore its map entry
+    for (vk::PipelineShaderStageCreateInfo& stage : shaderStages)
+    {
+        if (stage.pSpecializationInfo == nullptr)
+            stage.pSpecializationInfo = _specialization.info();
+    }
+
     // Create layout
     vk::PipelineLayout createdLayout = engine->device.createPipelineLayout(layoutInfo);
     layout = createdLayout;
@@ -43,7 +51,9 @@ void APipeline::buildAll()
     pipelineInfo.subpass = 0;
 
     // Actually build the pipeline
-    auto pipelineResult = engine->device.createGraphicsPipeline(VK_NULL_HANDLE, pipelineInfo);
+    auto createStart = std::chrono::steady_clock::now();
+    auto pipelineResult = engine->device.createGraphicsPipeline(engine->pipelineCache.cache, pipelineInfo);
+    engine->pipelineCache.recordCreation(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - createStart).count());
     vk::resultCheck(pipelineResult.result, "Error creating graphics pipeline");
     vk::Pipeline createdPipeline = pipelineResult.value;
     pipeline = createdPipeline;
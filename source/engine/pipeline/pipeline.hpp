@@ -5,6 +5,7 @@
 #include <vulkan/vulkan.hpp>
 #include "util/deletion_queue.hpp"
 #include "engine/resource.hpp"
+#include "engine/pipeline/specialization.hpp"
 
 class Engine;
 
@@ -21,6 +22,9 @@ protected:
 
     vk::RenderPass pass;
 
+    // Applied to every shader stage which doesn't provide its own specialization info
+    SpecializationConstants _specialization;
+
     std::vector<vk::DynamicState> _dynamicStates;
     vk::PipelineColorBlendAttachmentState _colorBlendAttachment;
 
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Pipelines keyed by the settings baked into them, with missing variants built on a worker thread.
+// Until a variant is ready, callers should keep using a generic pipeline, so settings changes never stall a frame.
+// Pipeline must be an AResource.
+template<typename Key, typename Pipeline, typename Hash = std::hash<Key>>
+class PipelineVariantCache
+{
+public:
+    using BuildFunc = std::function<Pipeline(const Key& key)>;
+
+private:
+    struct Variant
+    {
+        std::unique_ptr<Pipeline> pipeline;
+        uint64_t lastUsedFrame;
+    };
+
+    BuildFunc _build;
+    size_t _capacity;
+    uint32_t _retireFrames;
+
+    uint64_t _frame = 0;
+    std::unordered_map<Key, Variant, Hash> _variants;
+
+    // Only one variant is built at a time, so a burst of settings changes can't flood the driver.
+    // A build whose key is no longer requested once it finishes is dropped, so the latest key is built next.
+    std::optional<Key> _pendingKey;
+    std::future<Pipeline> _pending;
+
+    // Evicted variants, destroyed once no frame in flight can still reference them
+    std::vector<std::pair<std::unique_ptr<Pipeline>, uint64_t>> _retired;
+
+public:
+    // Keeps at most capacity variants, destroying evicted ones after retireFrames further frames.
+    PipelineVariantCache(BuildFunc build, size_t capacity, uint32_t retireFrames)
+        : _build(std::move(build)), _capacity(capacity), _retireFrames(retireFrames) {}
+
+    // Returns the variant for the given key, or null if it is still being built.
+    // Should be called once per frame, as it also collects finished builds and destroys evicted variants.
+    Pipeline* get(const Key& key)
+    {
+        _frame++;
+        collectPending(key);
+        destroyRetired(false);
+
+        auto variantIt = _variants.find(key);
+        if (variantIt != _variants.end())
+        {
+            variantIt->second.lastUsedFrame = _frame;
+            return variantIt->second.pipeline.get();
+        }
+
+        if (!_pending.valid())
+        {
+            _pendingKey = key;
+            _pending = std::async(std::launch::async, _build, key);
+        }
+        return nullptr;
+    }
+
+    // Waits for any build in progress, then destroys every variant.
+    void destroy()
+    {
+        if (_pending.valid())
+            _pending.get().destroy();
+        _pendingKey.reset();
+
+        for (auto& [key, variant] : _variants)
+            variant.pipeline->destroy();
+        _variants.clear();
+
+        destroyRetired(true);
+    }
+
+private:
+    void collectPending(const Key& requested)
+    {
+        if (!_pending.valid() || _pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return;
+
+        // Rethrows any error from the worker thread
+        auto pipeline = std::make_unique<Pipeline>(_pending.get());
+
+        // Settings moved on while it was building, so it would only hold up the requested key.
+        // No frame has bound it yet, so it can be destroyed right away.
+        if (!(*_pendingKey == requested))
+        {
+            pipeline->destroy();
+            _pendingKey.reset();
+            return;
+        }
+
+        if (_variants.size() >= _capacity)
+        {
+            auto oldest = _variants.begin();
+            for (auto variantIt = _variants.begin(); variantIt != _variants.end(); variantIt++)
+            {
+                if (variantIt->second.lastUsedFrame < oldest->second.lastUsedFrame)
+                    oldest = variantIt;
+            }
+            _retired.emplace_back(std::move(oldest->second.pipeline), _frame);
+            _variants.erase(oldest);
+        }
+
+        _variants.emplace(*_pendingKey, Variant { std::move(pipeline), _frame });
+        _pendingKey.reset();
+    }
+
+    void destroyRetired(bool all)
+    {
+        for (auto retiredIt = _retired.begin(); retiredIt != _retired.end();)
+        {
+            if (all || _frame - retiredIt->second > _retireFrames)
+            {
+                retiredIt->first->destroy();
+                retiredIt = _retired.erase(retiredIt);
+            }
+            else
+            {
+                retiredIt++;
+            }
+        }
+    }
+};
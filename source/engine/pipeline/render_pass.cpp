@@ -50,7 +50,8 @@ RenderPassBuilder& RenderPassBuilder::depthStencil(uint32_t attachment, vk::Form
     depthAttachment.samples = vk::SampleCountFlagBits::e1;
     depthAttachment.loadOp = vk::AttachmentLoadOp::eClear;
     depthAttachment.storeOp = vk::AttachmentStoreOp::eStore;
-    depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+    // Stencil is only meaningful within the pass, but must start from its clear value
+    depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eClear;
     depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
     depthAttachment.initialLayout = vk::ImageLayout::eUndefined;
     depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
@@ -0,0 +1,18 @@
+#include "specialization.hpp"
+
+bool SpecializationConstants::empty() const
+{
+    return _entries.empty();
+}
+
+const vk::SpecializationInfo* SpecializationConstants::info()
+{
+    if (empty())
+        return nullptr;
+
+    _info.mapEntryCount = static_cast<uint32_t>(_entries.size());
+    _info.pMapEntries = _entries.data();
+    _info.dataSize = _data.size();
+    _info.pData = _data.data();
+    return &_info;
+}
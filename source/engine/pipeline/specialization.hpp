@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// Values for a pipeline's specialization constants, packed into a single data block.
+// Booleans must be given as vk::Bool32, matching their size in SPIR-V.
+class SpecializationConstants
+{
+private:
+    std::vector<vk::SpecializationMapEntry> _entries;
+    std::vector<uint8_t> _data;
+    vk::SpecializationInfo _info;
+
+public:
+    template<typename T>
+    SpecializationConstants& set(uint32_t constantId, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Specialization constants must be trivially copyable");
+
+        uint32_t offset = static_cast<uint32_t>(_data.size());
+        _data.resize(offset + sizeof(T));
+        std::memcpy(_data.data() + offset, &value, sizeof(T));
+        _entries.emplace_back(constantId, offset, sizeof(T));
+        return *this;
+    }
+
+    bool empty() const;
+
+    // Returns info pointing into this object, or null if no constants are set.
+    // The pointer is only valid until this object is modified, copied or destroyed.
+    const vk::SpecializationInfo* info();
+};
@@ -0,0 +1,119 @@
+#include "pipeline_cache.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include "engine/engine.hpp"
+
+// Header written at the start of all cache data, as defined for VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+struct PipelineCacheHeader
+{
+    uint32_t length;
+    uint32_t version;
+    uint32_t vendorId;
+    uint32_t deviceId;
+    uint8_t uuid[VK_UUID_SIZE];
+};
+
+// Drivers should reject foreign data themselves, but some crash on it instead
+static bool isCompatible(const std::vector<uint8_t>& data, const vk::PhysicalDeviceProperties& properties)
+{
+    if (data.size() < sizeof(PipelineCacheHeader))
+        return false;
+
+    PipelineCacheHeader header;
+    std::memcpy(&header, data.data(), sizeof(PipelineCacheHeader));
+    return header.length >= sizeof(PipelineCacheHeader)
+        && header.version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorId == properties.vendorID
+        && header.deviceId == properties.deviceID
+        && std::memcmp(header.uuid, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
+
+void PipelineCache::init(const std::shared_ptr<Engine>& engine, const std::filesystem::path& path)
+{
+    _device = engine->device;
+    _path = path;
+
+    std::vector<uint8_t> data;
+    std::ifstream file(path, std::ios::binary);
+    if (file.is_open())
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    vk::PipelineCacheCreateInfo cacheInfo;
+    if (isCompatible(data, engine->physicalDevice.getProperties()))
+    {
+        cacheInfo.initialDataSize = data.size();
+        cacheInfo.pInitialData = data.data();
+        _stats.warm = true;
+    }
+    cache = engine->device.createPipelineCache(cacheInfo);
+    engine->deletionQueue.push_group([&]() {
+        _device.destroy(cache);
+    });
+}
+
+void PipelineCache::save() const
+{
+    std::vector<uint8_t> data = _device.getPipelineCacheData(cache);
+
+    // Failing to save only costs the next startup a cold cache
+    std::error_code error;
+    if (_path.has_parent_path())
+        std::filesystem::create_directories(_path.parent_path(), error);
+
+    // Write alongside the old file and swap it in, so a crash mid-write can't leave a truncated cache
+    std::filesystem::path tempPath = _path;
+    tempPath += ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    // Closing flushes the stream, which can fail too
+    file.close();
+    if (!file.good())
+    {
+        std::filesystem::remove(tempPath, error);
+        return;
+    }
+
+    std::filesystem::rename(tempPath, _path, error);
+    if (error)
+        std::filesystem::remove(tempPath, error);
+}
+
+std::filesystem::path PipelineCache::defaultPath()
+{
+    std::filesystem::path cacheDir;
+#if defined(_WIN32)
+    if (const char* localAppData = std::getenv("LOCALAPPDATA"))
+        cacheDir = localAppData;
+#elif defined(__APPLE__)
+    if (const char* home = std::getenv("HOME"))
+        cacheDir = std::filesystem::path(home) / "Library" / "Caches";
+#else
+    const char* cacheHome = std::getenv("XDG_CACHE_HOME");
+    if (cacheHome != nullptr && cacheHome[0] != '\0')
+        cacheDir = cacheHome;
+    else if (const char* home = std::getenv("HOME"))
+        cacheDir = std::filesystem::path(home) / ".cache";
+#endif
+
+    // Without a home directory, fall back to the working directory
+    if (cacheDir.empty())
+        return "pipeline_cache.bin";
+    return cacheDir / "voxels" / "pipeline_cache.bin";
+}
+
+void PipelineCache::recordCreation(float ms)
+{
+    std::lock_guard<std::mutex> lock(_statsMutex);
+    _stats.count++;
+    _stats.totalMs += ms;
+}
+
+PipelineCreationStats PipelineCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(_statsMutex);
+    return _stats;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vulkan/vulkan.hpp>
+
+class Engine;
+
+// Time spent creating pipelines since startup
+struct PipelineCreationStats
+{
+    uint32_t count = 0;
+    float totalMs = 0.0f;
+    // Whether a compatible cache was loaded from disk, making this a warm start
+    bool warm = false;
+};
+
+// A VkPipelineCache shared by every pipeline, persisted to disk between runs.
+// Should only be created by the main engine.
+class PipelineCache
+{
+private:
+    vk::Device _device;
+    std::filesystem::path _path;
+
+    mutable std::mutex _statsMutex;
+    PipelineCreationStats _stats;
+
+public:
+    vk::PipelineCache cache;
+
+public:
+    // Creates the cache, seeded from the given file unless it is missing or was written by a different device or driver.
+    void init(const std::shared_ptr<Engine>& engine, const std::filesystem::path& path);
+    // Writes the cache to disk, atomically replacing the previous file.
+    void save() const;
+
+    // File in the user's cache directory, so runs share it whichever directory they're started from.
+    static std::filesystem::path defaultPath();
+
+    // Records the time taken to create a single pipeline. May be called from any thread.
+    void recordCreation(float ms);
+    PipelineCreationStats stats() const;
+};
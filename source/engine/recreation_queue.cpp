@@ -17,7 +17,12 @@ uint32_t RecreationQueue::push(RecreationEventFlags flags, const CreatorFunc& cr
 
 void RecreationQueue::fire(RecreationEventFlags flags)
 {
+    // Fired every frame, but only worth stalling for when something is recreated
+    if (!flags)
+        return;
+
     engine->device.waitIdle();
+    _generation++;
 
     // Fire relevant deletors
     for (size_t i = _deletors.size() - 1; i != -1; i--)
@@ -63,3 +68,8 @@ void RecreationQueue::remove(uint32_t id)
 
     _recreatorIdGen.reclaim(id);
 }
+
+uint32_t RecreationQueue::generation() const
+{
+    return _generation;
+}
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <functional>
+#include <memory>
 #include <bitflags/bitflags.hpp>
 #include "util/id_generator.hpp"
 
@@ -15,6 +16,7 @@ BEGIN_BITFLAGS(RecreationEventFlags)
     FLAG(TARGET_RESIZE)
     FLAG(DENOISER_SETTINGS)
     FLAG(SCENE_PATH)
+    FLAG(RENDER_GRAPH)
 END_BITFLAGS(RecreationEventFlags)
 
 typedef std::function<void(const std::shared_ptr<Engine>& engine)> DeletorFunc;
@@ -33,6 +35,8 @@ private:
     std::vector<std::tuple<uint32_t, RecreationEventFlags, CreatorFunc>> _creators;
     std::vector<std::tuple<uint32_t, RecreationEventFlags, DeletorFunc>> _deletors;
 
+    uint32_t _generation = 0;
+
 public:
     explicit RecreationQueue(const std::shared_ptr<Engine>& engine);
 
@@ -45,5 +49,9 @@ public:
     void remove(uint32_t id);
 
     // Calls all deletors with the given flags, and then calls their corresponding creators.
+    // Does nothing if no flags are given.
     void fire(RecreationEventFlags flags);
+
+    // Incremented each time the queue fires, so caches can tell when resources they reference may have been recreated.
+    uint32_t generation() const;
 };
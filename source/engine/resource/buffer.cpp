@@ -13,12 +13,16 @@ Buffer::Buffer(const std::shared_ptr<Engine>& engine,
 
     VmaAllocationCreateInfo allocInfo = {};
     allocInfo.usage = memoryUsage;
+    if (memoryUsage != VMA_MEMORY_USAGE_GPU_ONLY)
+        allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
 
     VkBufferCreateInfo bufferInfoC = VkBufferCreateInfo(bufferInfo);
     VkBuffer outBufferC;
-    auto res = vmaCreateBuffer(engine->allocator, &bufferInfoC, &allocInfo, &outBufferC, &allocation, nullptr);
+    VmaAllocationInfo allocResult;
+    auto res = vmaCreateBuffer(engine->allocator, &bufferInfoC, &allocInfo, &outBufferC, &allocation, &allocResult);
     vk::resultCheck(vk::Result(res), "Error creating buffer");
     buffer = outBufferC;
+    mapped = allocResult.pMappedData;
 
     DebugMarker::setObjectName(engine->device, (VkBuffer)buffer, name);
 
@@ -29,10 +33,14 @@ Buffer::Buffer(const std::shared_ptr<Engine>& engine,
     });
 }
 
-void Buffer::copyData(void* data, size_t length) const
+void Buffer::copyData(const void* data, size_t length) const
 {
-    void* bufferData;
-    vmaMapMemory(engine->allocator, allocation, &bufferData);
-    std::memcpy(bufferData, data, length);
-    vmaUnmapMemory(engine->allocator, allocation);
+    std::memcpy(mapped, data, length);
+    vmaFlushAllocation(engine->allocator, allocation, 0, length);
+}
+
+void Buffer::readData(void* data, size_t length) const
+{
+    vmaInvalidateAllocation(engine->allocator, allocation, 0, length);
+    std::memcpy(data, mapped, length);
 }
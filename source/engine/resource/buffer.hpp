@@ -14,9 +14,13 @@ public:
 
 private:
     VmaAllocation allocation;
+    // Host visible buffers stay mapped for their whole lifetime
+    void* mapped = nullptr;
 
 public:
     Buffer::Buffer(const std::shared_ptr<Engine>& engine,
                    size_t size, vk::BufferUsageFlags usage, VmaMemoryUsage memoryUsage, const std::string& name);
-    void copyData(void* data, size_t size) const;
+    void copyData(const void* data, size_t size) const;
+    // Reads back the start of the buffer, which must be host visible.
+    void readData(void* data, size_t size) const;
 };
@@ -7,20 +7,7 @@ RenderImage::RenderImage(const std::shared_ptr<Engine>& engine, uint32_t width,
                          vk::Format format, vk::ImageUsageFlags usage, vk::ImageAspectFlags aspect, const std::string& name)
                          : AResource(engine), width(width), height(height), format(format)
 {
-    vk::Extent3D imageExtent;
-    imageExtent.width = width;
-    imageExtent.height = height;
-    imageExtent.depth = 1;
-
-    vk::ImageCreateInfo imageInfo = {};
-    imageInfo.imageType = vk::ImageType::e2D;
-    imageInfo.format = format;
-    imageInfo.extent = imageExtent;
-    imageInfo.mipLevels = 1;
-    imageInfo.arrayLayers = 1;
-    imageInfo.samples = vk::SampleCountFlagBits::e1;
-    imageInfo.tiling = vk::ImageTiling::eOptimal;
-    imageInfo.usage = usage;
+    vk::ImageCreateInfo imageInfo = createInfo(width, height, format, usage);
 
     // Allocation requirements
     VmaAllocationCreateInfo imageAllocInfo = {};
@@ -39,6 +26,49 @@ RenderImage::RenderImage(const std::shared_ptr<Engine>& engine, uint32_t width,
         vmaDestroyImage(delEngine->allocator, imageC, localAllocation);
     });
 
+    createViews(aspect, name);
+}
+
+RenderImage::RenderImage(const std::shared_ptr<Engine>& engine, uint32_t width, uint32_t height,
+                         vk::Format format, vk::ImageUsageFlags usage, vk::ImageAspectFlags aspect, const std::string& name, VmaAllocation memory)
+                         : AResource(engine), width(width), height(height), format(format), allocation(memory)
+{
+    // Create image, without memory of its own
+    vk::Image createdImage = engine->device.createImage(createInfo(width, height, format, usage));
+    image = createdImage;
+    DebugMarker::setObjectName(engine->device, (VkImage)image, fmt::format("{} Image", name));
+    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
+        delEngine->device.destroy(createdImage);
+    });
+
+    auto res = vmaBindImageMemory(engine->allocator, memory, static_cast<VkImage>(image));
+    vk::resultCheck(vk::Result(res), "Error binding render target memory");
+
+    createViews(aspect, name);
+}
+
+vk::ImageCreateInfo RenderImage::createInfo(uint32_t width, uint32_t height, vk::Format format, vk::ImageUsageFlags usage)
+{
+    vk::Extent3D imageExtent;
+    imageExtent.width = width;
+    imageExtent.height = height;
+    imageExtent.depth = 1;
+
+    vk::ImageCreateInfo imageInfo = {};
+    imageInfo.imageType = vk::ImageType::e2D;
+    imageInfo.format = format;
+    imageInfo.extent = imageExtent;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = vk::SampleCountFlagBits::e1;
+    imageInfo.tiling = vk::ImageTiling::eOptimal;
+    imageInfo.usage = usage;
+
+    return imageInfo;
+}
+
+void RenderImage::createViews(vk::ImageAspectFlags aspect, const std::string& name)
+{
     // Create image view
     vk::ImageViewCreateInfo imageViewInfo = {};
     imageViewInfo.viewType = vk::ImageViewType::e2D;
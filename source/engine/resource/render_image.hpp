@@ -22,4 +22,14 @@ private:
 public:
     RenderImage(const std::shared_ptr<Engine>& engine, uint32_t width, uint32_t height,
                 vk::Format format, vk::ImageUsageFlags usage, vk::ImageAspectFlags aspect, const std::string& name);
+    // Creates an image bound to the start of existing memory, which other images may alias.
+    // The memory must satisfy the requirements of an image with the same create info, and outlive this image.
+    RenderImage(const std::shared_ptr<Engine>& engine, uint32_t width, uint32_t height,
+                vk::Format format, vk::ImageUsageFlags usage, vk::ImageAspectFlags aspect, const std::string& name, VmaAllocation memory);
+
+    // The create info used for render images with the given properties
+    static vk::ImageCreateInfo createInfo(uint32_t width, uint32_t height, vk::Format format, vk::ImageUsageFlags usage);
+
+private:
+    void createViews(vk::ImageAspectFlags aspect, const std::string& name);
 };
@@ -1,7 +1,6 @@
 #include "texture_2d.hpp"
 
 #include "engine/engine.hpp"
-#include "engine/resource/buffer.hpp"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <fmt/format.h>
@@ -48,14 +47,6 @@ Texture2D::Texture2D(const std::shared_ptr<Engine>& engine,
 
     vk::DeviceSize imageSize = width * height * formatSize(imageFormat);
 
-    // Create CPU-side buffer to hold data
-    Buffer stagingBuffer(engine, imageSize, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_CPU_ONLY, "Texture2D Staging Buffer");
-
-    // Copy data to buffer
-    stagingBuffer.copyData(pixels, static_cast<size_t>(imageSize));
-
-    stbi_image_free(pixels);
-
     // Extents
     vk::Extent3D imageExtent;
     imageExtent.width = static_cast<uint32_t>(width);
@@ -72,6 +63,7 @@ Texture2D::Texture2D(const std::shared_ptr<Engine>& engine,
     imageInfo.arrayLayers = 1;
     imageInfo.samples = vk::SampleCountFlagBits::e1;
     imageInfo.tiling = vk::ImageTiling::eOptimal;
+    engine->uploads->shareImage(imageInfo);
 
     // Allocation info
     VmaAllocationCreateInfo imageAllocInfo = {};
@@ -84,58 +76,14 @@ Texture2D::Texture2D(const std::shared_ptr<Engine>& engine,
     vk::resultCheck(vk::Result(res), "Error creating image");
     image = vk::Image(imageC);
 
-    // Submit commands to copy and transition image
-    engine->upload_submit([&](vk::CommandBuffer cmd) {
-        // The range to transfer, assumed to be color
-        vk::ImageSubresourceRange range = {};
-        range.aspectMask = vk::ImageAspectFlagBits::eColor;
-        range.baseMipLevel = 0;
-        range.levelCount = 1;
-        range.baseArrayLayer = 0;
-        range.layerCount = 1;
-
-        // Barrier to get into transfer destination layout
-        vk::ImageMemoryBarrier imageBarrierTransfer = {};
-        imageBarrierTransfer.oldLayout = vk::ImageLayout::eUndefined;
-        imageBarrierTransfer.newLayout = vk::ImageLayout::eTransferDstOptimal;
-        imageBarrierTransfer.image = image;
-        imageBarrierTransfer.subresourceRange = range;
-        imageBarrierTransfer.srcAccessMask = vk::AccessFlagBits::eNone;
-        imageBarrierTransfer.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
-                            vk::DependencyFlags(0), 0, nullptr, 0, nullptr,
-                            1, &imageBarrierTransfer);
-
-        // Copy staging buffer to image
-        vk::BufferImageCopy copyRegion = {};
-        copyRegion.bufferOffset = 0;
-        copyRegion.bufferRowLength = 0;
-        copyRegion.bufferImageHeight = 0;
-        copyRegion.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-        copyRegion.imageSubresource.mipLevel = 0;
-        copyRegion.imageSubresource.baseArrayLayer = 0;
-        copyRegion.imageSubresource.layerCount = 1;
-        copyRegion.imageExtent = imageExtent;
-        cmd.copyBufferToImage(stagingBuffer.buffer, image, vk::ImageLayout::eTransferDstOptimal, 1, &copyRegion);
-
-        // Barrier to get into shader read layout
-        vk::ImageMemoryBarrier imageBarrierShader = {};
-        imageBarrierShader.oldLayout = vk::ImageLayout::eTransferDstOptimal;
-        imageBarrierShader.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-        imageBarrierShader.image = image;
-        imageBarrierShader.subresourceRange = range;
-        imageBarrierShader.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-        imageBarrierShader.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader,
-                            vk::DependencyFlags(0), 0, nullptr, 0, nullptr,
-                            1, &imageBarrierShader);
-    });
+    // Stream data through the staging ring, which leaves the image ready to sample
+    engine->uploads->uploadImage(image, imageExtent, pixels, static_cast<size_t>(imageSize));
+    stbi_image_free(pixels);
 
     VmaAllocation localAllocation = allocation;
     pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
         vmaDestroyImage(delEngine->allocator, imageC, localAllocation);
     });
-    stagingBuffer.destroy();
 
     // Create image view
     vk::ImageViewCreateInfo imageViewInfo = {};
@@ -1,22 +1,39 @@
 #include "texture_3d.hpp"
 
+#include <algorithm>
 #include "engine/engine.hpp"
-#include "engine/resource/buffer.hpp"
 
 Texture3D::Texture3D(const std::shared_ptr<Engine>& engine,
                      void* imageData,
                      size_t width, size_t height, size_t depth,
-                     size_t pixelSize, vk::Format imageFormat)
-                     : AResource(engine), width(width), height(height), depth(depth)
+                     size_t pixelSize, vk::Format imageFormat, uint32_t mipLevels)
+                     : AResource(engine), width(width), height(height), depth(depth), mipLevels(mipLevels)
 {
-    vk::DeviceSize imageSize = width * height * depth * pixelSize;
+    vk::DeviceSize imageSize = 0;
+    for (uint32_t level = 0; level < mipLevels; level++)
+        imageSize += std::max(width >> level, size_t(1)) * std::max(height >> level, size_t(1)) * std::max(depth >> level, size_t(1)) * pixelSize;
+
+    vk::ImageCreateInfo imageInfo = createInfo(imageFormat, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst);
+    engine->uploads->shareImage(imageInfo);
+    createImage(imageInfo);
 
-    // Create CPU-side buffer to hold data
-    Buffer stagingBuffer(engine, imageSize, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_CPU_ONLY, "Texture3D Buffer");
+    // Stream data through the staging ring, which leaves the image ready to sample
+    engine->uploads->uploadImage(image, imageInfo.extent, imageData, static_cast<size_t>(imageSize), mipLevels);
 
-    // Copy data to buffer
-    stagingBuffer.copyData(imageData, static_cast<size_t>(imageSize));
+    createViews(imageFormat);
+}
+
+Texture3D::Texture3D(const std::shared_ptr<Engine>& engine,
+                     size_t width, size_t height, size_t depth,
+                     vk::Format imageFormat, vk::ImageUsageFlags usage)
+                     : AResource(engine), width(width), height(height), depth(depth)
+{
+    createImage(createInfo(imageFormat, usage));
+    createViews(imageFormat);
+}
 
+vk::ImageCreateInfo Texture3D::createInfo(vk::Format imageFormat, vk::ImageUsageFlags usage) const
+{
     // Extents
     vk::Extent3D imageExtent;
     imageExtent.width = static_cast<uint32_t>(width);
@@ -28,12 +45,16 @@ Texture3D::Texture3D(const std::shared_ptr<Engine>& engine,
     imageInfo.imageType = vk::ImageType::e3D;
     imageInfo.extent = imageExtent;
     imageInfo.format = imageFormat;
-    imageInfo.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
-    imageInfo.mipLevels = 1;
+    imageInfo.usage = usage;
+    imageInfo.mipLevels = mipLevels;
     imageInfo.arrayLayers = 1;
     imageInfo.samples = vk::SampleCountFlagBits::e1;
     imageInfo.tiling = vk::ImageTiling::eOptimal;
+    return imageInfo;
+}
 
+void Texture3D::createImage(const vk::ImageCreateInfo& imageInfo)
+{
     // Allocation info
     VmaAllocationCreateInfo imageAllocInfo = {};
     imageAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
@@ -45,59 +66,14 @@ Texture3D::Texture3D(const std::shared_ptr<Engine>& engine,
     vk::resultCheck(vk::Result(res), "Error creating image");
     image = vk::Image(imageC);
 
-    // Submit commands to copy and transition image
-    engine->upload_submit([&](vk::CommandBuffer cmd) {
-        // The range to transfer, assumed to be color
-        vk::ImageSubresourceRange range = {};
-        range.aspectMask = vk::ImageAspectFlagBits::eColor;
-        range.baseMipLevel = 0;
-        range.levelCount = 1;
-        range.baseArrayLayer = 0;
-        range.layerCount = 1;
-
-        // Barrier to get into transfer destination layout
-        vk::ImageMemoryBarrier imageBarrierTransfer = {};
-        imageBarrierTransfer.oldLayout = vk::ImageLayout::eUndefined;
-        imageBarrierTransfer.newLayout = vk::ImageLayout::eTransferDstOptimal;
-        imageBarrierTransfer.image = image;
-        imageBarrierTransfer.subresourceRange = range;
-        imageBarrierTransfer.srcAccessMask = vk::AccessFlagBits::eNone;
-        imageBarrierTransfer.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
-                            vk::DependencyFlags(0), 0, nullptr, 0, nullptr,
-                            1, &imageBarrierTransfer);
-
-        // Copy staging buffer to image
-        vk::BufferImageCopy copyRegion = {};
-        copyRegion.bufferOffset = 0;
-        copyRegion.bufferRowLength = 0;
-        copyRegion.bufferImageHeight = 0;
-        copyRegion.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-        copyRegion.imageSubresource.mipLevel = 0;
-        copyRegion.imageSubresource.baseArrayLayer = 0;
-        copyRegion.imageSubresource.layerCount = 1;
-        copyRegion.imageExtent = imageExtent;
-        cmd.copyBufferToImage(stagingBuffer.buffer, image, vk::ImageLayout::eTransferDstOptimal, 1, &copyRegion);
-
-        // Barrier to get into shader read layout
-        vk::ImageMemoryBarrier imageBarrierShader = {};
-        imageBarrierShader.oldLayout = vk::ImageLayout::eTransferDstOptimal;
-        imageBarrierShader.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-        imageBarrierShader.image = image;
-        imageBarrierShader.subresourceRange = range;
-        imageBarrierShader.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-        imageBarrierShader.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader,
-                            vk::DependencyFlags(0), 0, nullptr, 0, nullptr,
-                            1, &imageBarrierShader);
-    });
-
     VmaAllocation localAllocation = allocation;
     pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
         vmaDestroyImage(delEngine->allocator, imageC, localAllocation);
     });
-    stagingBuffer.destroy();
+}
 
+void Texture3D::createViews(vk::Format imageFormat)
+{
     // Create image view
     vk::ImageViewCreateInfo imageViewInfo = {};
     imageViewInfo.viewType = vk::ImageViewType::e3D;
@@ -105,7 +81,7 @@ Texture3D::Texture3D(const std::shared_ptr<Engine>& engine,
     imageViewInfo.format = imageFormat;
     imageViewInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
     imageViewInfo.subresourceRange.baseMipLevel = 0;
-    imageViewInfo.subresourceRange.levelCount = 1;
+    imageViewInfo.subresourceRange.levelCount = mipLevels;
     imageViewInfo.subresourceRange.baseArrayLayer = 0;
     imageViewInfo.subresourceRange.layerCount = 1;
     vk::ImageView createdImageView = engine->device.createImageView(imageViewInfo);
@@ -116,8 +92,11 @@ Texture3D::Texture3D(const std::shared_ptr<Engine>& engine,
 
     // Create sampler
     vk::SamplerCreateInfo samplerInfo = {};
-    samplerInfo.minFilter = vk::Filter::eNearest;
-    samplerInfo.magFilter = vk::Filter::eNearest;
+    vk::Filter filter = mipLevels > 1 ? vk::Filter::eLinear : vk::Filter::eNearest;
+    samplerInfo.minFilter = filter;
+    samplerInfo.magFilter = filter;
+    samplerInfo.mipmapMode = mipLevels > 1 ? vk::SamplerMipmapMode::eLinear : vk::SamplerMipmapMode::eNearest;
+    samplerInfo.maxLod = static_cast<float>(mipLevels - 1);
     samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
     samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
     samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
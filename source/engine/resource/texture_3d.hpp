@@ -10,6 +10,7 @@ class Texture3D : public AResource
 {
 public:
     size_t width, height, depth = 0;
+    uint32_t mipLevels = 1;
 
     vk::Image image;
     vk::ImageView imageView;
@@ -19,8 +20,19 @@ private:
     VmaAllocation allocation;
 
 public:
+    // Image data may hold a chain of mips, each tightly packed after the last.
+    // Mipmapped textures are sampled with trilinear filtering, and others with nearest filtering.
     Texture3D(const std::shared_ptr<Engine>& engine,
               void* imageData,
               size_t width, size_t height, size_t depth,
-              size_t pixelSize, vk::Format imageFormat);
+              size_t pixelSize, vk::Format imageFormat, uint32_t mipLevels = 1);
+    // Creates an image with undefined contents and layout, for commands to fill in.
+    Texture3D(const std::shared_ptr<Engine>& engine,
+              size_t width, size_t height, size_t depth,
+              vk::Format imageFormat, vk::ImageUsageFlags usage);
+
+private:
+    vk::ImageCreateInfo createInfo(vk::Format imageFormat, vk::ImageUsageFlags usage) const;
+    void createImage(const vk::ImageCreateInfo& imageInfo);
+    void createViews(vk::Format imageFormat);
 };
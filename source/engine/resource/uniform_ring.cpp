@@ -0,0 +1,55 @@
+#include "uniform_ring.hpp"
+
+#include <cstring>
+#include "engine/engine.hpp"
+#include "engine/debug_marker.hpp"
+
+UniformRing::UniformRing(const std::shared_ptr<Engine>& engine, size_t frameSize) : AResource(engine)
+{
+    _alignment = static_cast<size_t>(engine->physicalDevice.getProperties().limits.minUniformBufferOffsetAlignment);
+    _frameSize = (frameSize + _alignment - 1) / _alignment * _alignment;
+
+    vk::BufferCreateInfo bufferInfo = {};
+    bufferInfo.size = _frameSize * MAX_FRAMES_IN_FLIGHT;
+    bufferInfo.usage = vk::BufferUsageFlagBits::eUniformBuffer;
+
+    // Mapped for the lifetime of the engine
+    VmaAllocationCreateInfo allocInfo = {};
+    allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VkBufferCreateInfo bufferInfoC = VkBufferCreateInfo(bufferInfo);
+    VkBuffer bufferC;
+    VmaAllocationInfo allocResult;
+    auto res = vmaCreateBuffer(engine->allocator, &bufferInfoC, &allocInfo, &bufferC, &_allocation, &allocResult);
+    vk::resultCheck(vk::Result(res), "Error creating uniform ring");
+    buffer = bufferC;
+    _data = static_cast<uint8_t*>(allocResult.pMappedData);
+
+    DebugMarker::setObjectName(engine->device, (VkBuffer)buffer, "Uniform Ring");
+
+    VmaAllocation localAllocation = _allocation;
+    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
+        vmaDestroyBuffer(delEngine->allocator, bufferC, localAllocation);
+    });
+}
+
+void UniformRing::beginFrame(uint32_t flightFrame)
+{
+    _frameStart = flightFrame * _frameSize;
+    _offset = 0;
+}
+
+uint32_t UniformRing::push(const void* data, size_t size)
+{
+    if (_offset + size > _frameSize)
+        throw std::runtime_error("Uniform ring is out of space for this frame.");
+
+    size_t offset = _frameStart + _offset;
+    std::memcpy(_data + offset, data, size);
+    // No-op on the usual host coherent memory
+    vmaFlushAllocation(engine->allocator, _allocation, offset, size);
+
+    _offset = (_offset + size + _alignment - 1) / _alignment * _alignment;
+    return static_cast<uint32_t>(offset);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vk_mem_alloc.h>
+#include "engine/resource.hpp"
+
+class Engine;
+
+// A linear allocator for per-frame uniform data, over one persistently mapped buffer with a region per flight frame.
+// Data is bound through eUniformBufferDynamic descriptors, which are written once and then selected with dynamic offsets,
+// so a frame never overwrites uniforms the previous frame may still be reading.
+class UniformRing : public AResource
+{
+public:
+    vk::Buffer buffer;
+
+private:
+    VmaAllocation _allocation;
+    uint8_t* _data;
+    size_t _frameSize;
+    size_t _alignment;
+
+    size_t _frameStart = 0;
+    size_t _offset = 0;
+
+public:
+    UniformRing(const std::shared_ptr<Engine>& engine, size_t frameSize);
+
+    // Restarts allocation in the given flight frame's region, which the GPU must be finished with.
+    void beginFrame(uint32_t flightFrame);
+
+    // Copies data into this frame's region, returning the dynamic offset to bind it with.
+    uint32_t push(const void* data, size_t size);
+
+    template<typename T>
+    uint32_t push(const T& value)
+    {
+        return push(&value, sizeof(T));
+    }
+};
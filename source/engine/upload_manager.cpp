@@ -0,0 +1,314 @@
+#include "upload_manager.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include "engine/engine.hpp"
+#include "engine/debug_marker.hpp"
+
+// Covers every texel size we upload, and the 4 byte alignment required for transfer queue copies
+#define STAGING_ALIGNMENT 16
+
+UploadTicket::UploadTicket(UploadManager* manager, uint64_t value) : _manager(manager), _value(value) {}
+
+bool UploadTicket::ready() const
+{
+    return _manager->isComplete(_value);
+}
+
+void UploadTicket::wait() const
+{
+    _manager->wait(_value);
+}
+
+UploadManager::UploadManager(const std::shared_ptr<Engine>& engine, vk::Queue queue, uint32_t queueFamily, size_t ringSize)
+    : AResource(engine), _queue(queue), _queueFamily(queueFamily), _ringSize(ringSize)
+{
+    if (queueFamily != engine->graphicsQueueFamily)
+        _sharedFamilies = { engine->graphicsQueueFamily, queueFamily };
+
+    // Create timeline semaphore
+    vk::SemaphoreTypeCreateInfo timelineInfo;
+    timelineInfo.semaphoreType = vk::SemaphoreType::eTimeline;
+    timelineInfo.initialValue = 0;
+    vk::SemaphoreCreateInfo semaphoreInfo;
+    semaphoreInfo.pNext = &timelineInfo;
+    vk::Semaphore createdTimeline = engine->device.createSemaphore(semaphoreInfo);
+    timeline = createdTimeline;
+    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
+        delEngine->device.destroy(createdTimeline);
+    });
+
+    // Create command pool for the transfer queue
+    vk::CommandPoolCreateInfo commandPoolInfo(vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueFamily);
+    vk::CommandPool createdPool = engine->device.createCommandPool(commandPoolInfo);
+    _commandPool = createdPool;
+    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
+        delEngine->device.destroy(createdPool);
+    });
+
+    // Create staging ring, mapped for its whole lifetime
+    vk::BufferCreateInfo bufferInfo = {};
+    bufferInfo.size = ringSize;
+    bufferInfo.usage = vk::BufferUsageFlagBits::eTransferSrc;
+
+    VmaAllocationCreateInfo allocInfo = {};
+    allocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VkBufferCreateInfo bufferInfoC = VkBufferCreateInfo(bufferInfo);
+    VkBuffer ringC;
+    VmaAllocationInfo ringAllocInfo;
+    auto res = vmaCreateBuffer(engine->allocator, &bufferInfoC, &allocInfo, &ringC, &_ringAllocation, &ringAllocInfo);
+    vk::resultCheck(vk::Result(res), "Error creating staging ring");
+    _ring = ringC;
+    _ringData = static_cast<uint8_t*>(ringAllocInfo.pMappedData);
+
+    DebugMarker::setObjectName(engine->device, (VkBuffer)_ring, "Staging Ring");
+
+    VmaAllocation localAllocation = _ringAllocation;
+    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
+        vmaDestroyBuffer(delEngine->allocator, ringC, localAllocation);
+    });
+}
+
+UploadTicket UploadManager::uploadImage(vk::Image image, vk::Extent3D extent, const void* data, size_t size, uint32_t mipLevels)
+{
+    // Texel counts of each mip, from which the texel size follows
+    std::vector<size_t> mipTexels(mipLevels);
+    std::vector<vk::Extent3D> mipExtents(mipLevels);
+    size_t texels = 0;
+    for (uint32_t level = 0; level < mipLevels; level++)
+    {
+        mipExtents[level] = vk::Extent3D(std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u), std::max(extent.depth >> level, 1u));
+        mipTexels[level] = static_cast<size_t>(mipExtents[level].width) * mipExtents[level].height * mipExtents[level].depth;
+        texels += mipTexels[level];
+    }
+    size_t texelSize = size / texels;
+
+    // Mips of small texels don't end on aligned offsets, so they're repacked with each mip aligned as transfer queues require
+    std::vector<vk::DeviceSize> mipOffsets(mipLevels, 0);
+    std::vector<uint8_t> packed;
+    if (mipLevels > 1)
+    {
+        size_t packedSize = 0;
+        for (uint32_t level = 0; level < mipLevels; level++)
+        {
+            mipOffsets[level] = packedSize;
+            packedSize = (packedSize + mipTexels[level] * texelSize + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+        }
+        packed.resize(packedSize);
+
+        const uint8_t* mipData = static_cast<const uint8_t*>(data);
+        for (uint32_t level = 0; level < mipLevels; level++)
+        {
+            std::memcpy(packed.data() + mipOffsets[level], mipData, mipTexels[level] * texelSize);
+            mipData += mipTexels[level] * texelSize;
+        }
+        data = packed.data();
+        size = packed.size();
+    }
+
+    auto [source, offset] = stage(data, size);
+    Batch& batch = openBatch();
+
+    // The range to transfer, assumed to be color
+    vk::ImageSubresourceRange range = {};
+    range.aspectMask = vk::ImageAspectFlagBits::eColor;
+    range.baseMipLevel = 0;
+    range.levelCount = mipLevels;
+    range.baseArrayLayer = 0;
+    range.layerCount = 1;
+
+    // Barrier to get into transfer destination layout
+    vk::ImageMemoryBarrier imageBarrierTransfer = {};
+    imageBarrierTransfer.oldLayout = vk::ImageLayout::eUndefined;
+    imageBarrierTransfer.newLayout = vk::ImageLayout::eTransferDstOptimal;
+    imageBarrierTransfer.image = image;
+    imageBarrierTransfer.subresourceRange = range;
+    imageBarrierTransfer.srcAccessMask = vk::AccessFlagBits::eNone;
+    imageBarrierTransfer.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+    batch.cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+                              vk::DependencyFlags(0), 0, nullptr, 0, nullptr,
+                              1, &imageBarrierTransfer);
+
+    // Copy staging memory to image, one region per mip
+    std::vector<vk::BufferImageCopy> copyRegions(mipLevels);
+    for (uint32_t level = 0; level < mipLevels; level++)
+    {
+        copyRegions[level].bufferOffset = offset + mipOffsets[level];
+        copyRegions[level].bufferRowLength = 0;
+        copyRegions[level].bufferImageHeight = 0;
+        copyRegions[level].imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+        copyRegions[level].imageSubresource.mipLevel = level;
+        copyRegions[level].imageSubresource.baseArrayLayer = 0;
+        copyRegions[level].imageSubresource.layerCount = 1;
+        copyRegions[level].imageExtent = mipExtents[level];
+    }
+    batch.cmd.copyBufferToImage(source, image, vk::ImageLayout::eTransferDstOptimal, static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+
+    // Barrier to get into shader read layout
+    // Transfer queues can't name shader stages, so visibility comes from the graphics queue's semaphore wait instead
+    vk::ImageMemoryBarrier imageBarrierShader = {};
+    imageBarrierShader.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+    imageBarrierShader.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    imageBarrierShader.image = image;
+    imageBarrierShader.subresourceRange = range;
+    imageBarrierShader.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    imageBarrierShader.dstAccessMask = vk::AccessFlagBits::eNone;
+    batch.cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe,
+                              vk::DependencyFlags(0), 0, nullptr, 0, nullptr,
+                              1, &imageBarrierShader);
+
+    return UploadTicket(this, batch.value);
+}
+
+void UploadManager::shareImage(vk::ImageCreateInfo& imageInfo) const
+{
+    if (_sharedFamilies.empty())
+        return;
+
+    imageInfo.sharingMode = vk::SharingMode::eConcurrent;
+    imageInfo.queueFamilyIndexCount = static_cast<uint32_t>(_sharedFamilies.size());
+    imageInfo.pQueueFamilyIndices = _sharedFamilies.data();
+}
+
+void UploadManager::flush()
+{
+    collect();
+
+    if (!_openBatch.has_value())
+        return;
+
+    Batch batch = std::move(*_openBatch);
+    _openBatch.reset();
+    batch.cmd.end();
+
+    vk::TimelineSemaphoreSubmitInfo timelineInfo;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &batch.value;
+
+    vk::SubmitInfo submitInfo;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.cmd;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &timeline;
+    auto res = _queue.submit(1, &submitInfo, VK_NULL_HANDLE);
+    vk::resultCheck(res, "Error submitting upload batch");
+
+    _flushedValue = batch.value;
+    _inFlight.push_back(std::move(batch));
+}
+
+uint64_t UploadManager::flushedValue() const
+{
+    return _flushedValue;
+}
+
+bool UploadManager::isComplete(uint64_t value)
+{
+    if (value > _completedValue)
+        collect();
+    return value <= _completedValue;
+}
+
+void UploadManager::wait(uint64_t value)
+{
+    if (value <= _completedValue)
+        return;
+    if (_openBatch.has_value() && value >= _openBatch->value)
+        flush();
+
+    vk::SemaphoreWaitInfo waitInfo;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &timeline;
+    waitInfo.pValues = &value;
+    auto res = engine->device.waitSemaphores(waitInfo, UINT64_MAX);
+    vk::resultCheck(res, "Error waiting for upload");
+
+    collect();
+}
+
+UploadManager::Batch& UploadManager::openBatch()
+{
+    if (!_openBatch.has_value())
+    {
+        vk::CommandBuffer cmd;
+        if (!_freeCommandBuffers.empty())
+        {
+            cmd = _freeCommandBuffers.back();
+            _freeCommandBuffers.pop_back();
+        }
+        else
+        {
+            vk::CommandBufferAllocateInfo commandBufferInfo(_commandPool, vk::CommandBufferLevel::ePrimary, 1);
+            cmd = engine->device.allocateCommandBuffers(commandBufferInfo).front();
+        }
+
+        vk::CommandBufferBeginInfo cmdBeginInfo;
+        cmdBeginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+        cmd.begin(cmdBeginInfo);
+
+        _openBatch = Batch { cmd, _nextValue++, _ringHead, {} };
+    }
+
+    return *_openBatch;
+}
+
+std::pair<vk::Buffer, vk::DeviceSize> UploadManager::stage(const void* data, size_t size)
+{
+    // Too large for the ring, so give it a buffer of its own which lives as long as the batch
+    if (size > _ringSize)
+    {
+        Batch& batch = openBatch();
+        batch.oversized.emplace_back(engine, size, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_CPU_ONLY, "Oversized Staging Buffer");
+        batch.oversized.back().copyData(data, size);
+        return { batch.oversized.back().buffer, 0 };
+    }
+
+    while (true)
+    {
+        // Restart an empty ring from its beginning, so the whole ring is available
+        if (_ringTail == _ringHead)
+        {
+            _ringHead = (_ringHead + _ringSize - 1) / _ringSize * _ringSize;
+            _ringTail = _ringHead;
+        }
+
+        // Allocations never straddle the end of the ring
+        uint64_t start = (_ringHead + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+        if (start % _ringSize + size > _ringSize)
+            start += _ringSize - start % _ringSize;
+
+        if (start + size - _ringTail <= _ringSize)
+        {
+            size_t offset = static_cast<size_t>(start % _ringSize);
+            std::memcpy(_ringData + offset, data, size);
+            _ringHead = start + size;
+            openBatch().ringHead = _ringHead;
+            return { _ring, offset };
+        }
+
+        // Ring is full, so wait for the oldest batch to release its staging memory
+        if (_inFlight.empty())
+            flush();
+        wait(_inFlight.front().value);
+    }
+}
+
+void UploadManager::collect()
+{
+    _completedValue = engine->device.getSemaphoreCounterValue(timeline);
+
+    // Batches complete in submission order, each releasing the ring up to its last allocation
+    while (!_inFlight.empty() && _inFlight.front().value <= _completedValue)
+    {
+        Batch& batch = _inFlight.front();
+        _ringTail = std::max(_ringTail, batch.ringHead);
+        for (const Buffer& buffer : batch.oversized)
+            buffer.destroy();
+        batch.cmd.reset();
+        _freeCommandBuffers.push_back(batch.cmd);
+        _inFlight.pop_front();
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include <vk_mem_alloc.h>
+#include "engine/resource.hpp"
+#include "engine/resource/buffer.hpp"
+
+class Engine;
+class UploadManager;
+
+// Handle to an upload, which completes once the transfer queue has executed it.
+class UploadTicket
+{
+private:
+    UploadManager* _manager;
+    uint64_t _value;
+
+public:
+    UploadTicket(UploadManager* manager, uint64_t value);
+
+    // Whether the upload has finished on the GPU. Never blocks.
+    bool ready() const;
+    // Blocks until the upload has finished, submitting it first if needed.
+    void wait() const;
+};
+
+// Streams data to GPU images through a persistently mapped staging ring, using a dedicated transfer queue when there is one.
+// Uploads are batched into one submission per frame, and the engine's next frame waits on it before reading from shaders.
+// Must only be used from the render thread.
+class UploadManager : public AResource
+{
+public:
+    // Timeline semaphore, signalled with each batch's value once it completes
+    vk::Semaphore timeline;
+
+private:
+    struct Batch
+    {
+        vk::CommandBuffer cmd;
+        uint64_t value;
+        // Ring position after the batch's last staging allocation
+        uint64_t ringHead;
+        // Staging buffers for uploads too large for the ring
+        std::vector<Buffer> oversized;
+    };
+
+    vk::Queue _queue;
+    uint32_t _queueFamily;
+    // Queue families images are shared between, if the transfer queue is separate
+    std::vector<uint32_t> _sharedFamilies;
+
+    vk::CommandPool _commandPool;
+    std::vector<vk::CommandBuffer> _freeCommandBuffers;
+
+    vk::Buffer _ring;
+    VmaAllocation _ringAllocation;
+    uint8_t* _ringData;
+    size_t _ringSize;
+    // Monotonic byte positions, wrapped by the ring size
+    uint64_t _ringHead = 0;
+    uint64_t _ringTail = 0;
+
+    std::optional<Batch> _openBatch;
+    std::deque<Batch> _inFlight;
+    uint64_t _nextValue = 1;
+    uint64_t _flushedValue = 0;
+    uint64_t _completedValue = 0;
+
+public:
+    UploadManager(const std::shared_ptr<Engine>& engine, vk::Queue queue, uint32_t queueFamily, size_t ringSize);
+
+    // Fills the first mipLevels mips of the given color image, leaving them in eShaderReadOnlyOptimal.
+    // Data holds each mip tightly packed after the last, starting with the largest, which has the given extent.
+    // The image must have been created with eTransferDst, and passed through shareImage.
+    UploadTicket uploadImage(vk::Image image, vk::Extent3D extent, const void* data, size_t size, uint32_t mipLevels = 1);
+
+    // Lets images filled on a separate transfer queue be used on the graphics queue without ownership transfers.
+    // The create info must not outlive this manager.
+    void shareImage(vk::ImageCreateInfo& imageInfo) const;
+
+    // Submits all uploads recorded since the last flush, and reclaims staging memory from finished ones.
+    // Called by the engine before each frame's submission.
+    void flush();
+    // Value of the timeline semaphore once every flushed upload has finished
+    uint64_t flushedValue() const;
+
+    bool isComplete(uint64_t value);
+    void wait(uint64_t value);
+
+private:
+    Batch& openBatch();
+    // Copies data into staging memory, returning the buffer and offset to copy from.
+    std::pair<vk::Buffer, vk::DeviceSize> stage(const void* data, size_t size);
+    void collect();
+};
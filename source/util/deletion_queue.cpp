@@ -1,7 +1,28 @@
 #include "deletion_queue.hpp"
 
+DeletionQueue::DeletionQueue(const DeletionQueue& other)
+{
+    std::lock_guard<std::mutex> lock(other._mutex);
+    _groupIdGen = other._groupIdGen;
+    _groups = other._groups;
+    _deletors = other._deletors;
+}
+
+DeletionQueue& DeletionQueue::operator=(const DeletionQueue& other)
+{
+    if (this != &other)
+    {
+        std::scoped_lock lock(_mutex, other._mutex);
+        _groupIdGen = other._groupIdGen;
+        _groups = other._groups;
+        _deletors = other._deletors;
+    }
+    return *this;
+}
+
 uint32_t DeletionQueue::next_group()
 {
+    std::lock_guard<std::mutex> lock(_mutex);
     uint32_t group = _groupIdGen.next();
     _groups.push_front(group);
     return group;
@@ -9,6 +30,7 @@ uint32_t DeletionQueue::next_group()
 
 void DeletionQueue::push_deletor(uint32_t group, const std::function<void()>& deletor)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
     auto groupIt = _deletors.find(group);
     if (groupIt != _deletors.end())
     {
@@ -31,29 +53,41 @@ uint32_t DeletionQueue::push_group(const std::function<void()>& deletor)
 
 void DeletionQueue::destroy_group(uint32_t group)
 {
-    auto groupIt = _deletors.find(group);
-    if (groupIt != _deletors.end())
+    // Deletors run without the lock held, as they may destroy other resources
+    std::vector<std::function<void()>> foundDeletors;
     {
-        std::vector<std::function<void()>> foundDeletors;
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto groupIt = _deletors.find(group);
+        if (groupIt == _deletors.end())
+            return;
+
         foundDeletors.insert(foundDeletors.end(), groupIt->second.begin(), groupIt->second.end());
         _deletors.erase(group);
-        for (const auto& deletor : foundDeletors)
-        {
-            deletor();
-        }
+    }
+
+    for (const auto& deletor : foundDeletors)
+    {
+        deletor();
     }
 }
 
 
 void DeletionQueue::destroy_all()
 {
-    while (!_groups.empty())
+    while (true)
     {
-        uint32_t group = _groups.front();
-        _groups.pop_front();
+        uint32_t group;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_groups.empty())
+                break;
+            group = _groups.front();
+            _groups.pop_front();
+        }
         destroy_group(group);
     }
 
+    std::lock_guard<std::mutex> lock(_mutex);
     _groups.clear();
     _deletors.clear();
 }
@@ -3,17 +3,25 @@
 #include <functional>
 #include <unordered_map>
 #include <deque>
+#include <mutex>
 #include "util/id_generator.hpp"
 
 // A queue of functions to call to destroy Vulkan (or other) objects.
+// Safe to use from multiple threads, so resources can be created off the render thread.
 class DeletionQueue
 {
 private:
     IdGenerator _groupIdGen;
     std::deque<uint32_t> _groups;
     std::unordered_map<uint32_t, std::deque<std::function<void()>>> _deletors;
+    mutable std::mutex _mutex;
 
 public:
+    DeletionQueue() = default;
+    // Copies share no lock with the original
+    DeletionQueue(const DeletionQueue& other);
+    DeletionQueue& operator=(const DeletionQueue& other);
+
     // Returns the ID of the next group of objects.
     uint32_t next_group();
 
@@ -0,0 +1,248 @@
+#include "cpu_denoiser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <fmt/format.h>
+#include "voxels/voxel_render_settings.hpp"
+#include "voxels/cpu/cpu_denoiser_rows.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace cpudenoiser
+{
+    static float luminance(float r, float g, float b)
+    {
+        return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+    }
+
+    void filterPixel(const Source& source, const Target& target, const DenoiserParams& params, const Taps& taps, int32_t x, int32_t y)
+    {
+        // Variance guiding the luminance weights is prefiltered over the kernel's footprint
+        int32_t index[DENOISER_KERNEL_SIZE];
+        float deviation = 0.0f;
+        for (int32_t t = 0; t < DENOISER_KERNEL_SIZE; t++)
+        {
+            int32_t tx = std::clamp(x + taps.dx[t], 0, source.width - 1);
+            int32_t ty = std::clamp(y + taps.dy[t], 0, source.height - 1);
+            index[t] = ty * source.width + tx;
+            deviation += source.color[3][index[t]] * taps.weight[t];
+        }
+        deviation = std::sqrt(std::max(deviation / taps.weightSum, 0.0f));
+
+        int32_t center = y * source.width + x;
+        float centerColor[3] = { source.color[0][center], source.color[1][center], source.color[2][center] };
+        float centerLuminance = luminance(centerColor[0], centerColor[1], centerColor[2]);
+
+        float sum[3] = {};
+        float totalWeight = 0.0f;
+        float variance = 0.0f;
+        for (int32_t t = 0; t < DENOISER_KERNEL_SIZE; t++)
+        {
+            int32_t i = index[t];
+            float color[3] = { source.color[0][i], source.color[1][i], source.color[2][i] };
+
+            float edgeWeight;
+            if (params.varianceGuided != 0)
+            {
+                float difference = std::abs(centerLuminance - luminance(color[0], color[1], color[2]));
+                edgeWeight = std::exp(-difference / (params.phiLuminance * deviation + 1e-4f));
+            }
+            else
+            {
+                float dist2 = 0.0f;
+                for (int32_t c = 0; c < 3; c++)
+                    dist2 += (centerColor[c] - color[c]) * (centerColor[c] - color[c]);
+                edgeWeight = std::min(std::exp(-dist2 / params.phiColor), 1.0f);
+            }
+
+            float normalDist2 = 0.0f;
+            float posDist2 = 0.0f;
+            for (int32_t c = 0; c < 3; c++)
+            {
+                float n = source.normal[c][center] - source.normal[c][i];
+                float p = source.position[c][center] - source.position[c][i];
+                normalDist2 += n * n;
+                posDist2 += p * p;
+            }
+            normalDist2 = std::max(normalDist2 / (params.stepWidth * params.stepWidth), 0.0f);
+            float normalWeight = std::min(std::exp(-normalDist2 / params.phiNormal), 1.0f);
+            float posWeight = std::min(std::exp(-posDist2 / params.phiPos), 1.0f);
+
+            float weight = edgeWeight * normalWeight * posWeight;
+            float kernelWeight = weight * taps.weight[t];
+            for (int32_t c = 0; c < 3; c++)
+                sum[c] += color[c] * kernelWeight;
+            totalWeight += kernelWeight;
+            // Variance of a weighted sum scales with the squared weights
+            variance += source.color[3][i] * kernelWeight * kernelWeight;
+        }
+
+        for (int32_t c = 0; c < 3; c++)
+            target.color[c][center] = sum[c] / totalWeight;
+        target.color[3][center] = variance / (totalWeight * totalWeight);
+    }
+
+    void filterRowsScalar(const Source& source, const Target& target, const DenoiserParams& params, const Taps& taps, int32_t rowBegin, int32_t rowEnd)
+    {
+        for (int32_t y = rowBegin; y < rowEnd; y++)
+        {
+            for (int32_t x = 0; x < source.width; x++)
+                filterPixel(source, target, params, taps, x, y);
+        }
+    }
+}
+
+// Splits rows into one contiguous range per thread, running the last on the calling thread
+template<typename Func>
+static void forEachRowRange(int32_t height, uint32_t threads, const Func& func)
+{
+    int32_t ranges = std::max(std::min(static_cast<int32_t>(threads), height), 1);
+    std::vector<std::thread> workers;
+    workers.reserve(ranges - 1);
+    for (int32_t i = 0; i < ranges - 1; i++)
+        workers.emplace_back(func, i * height / ranges, (i + 1) * height / ranges);
+    func((ranges - 1) * height / ranges, height);
+
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+CpuDenoiser::CpuDenoiser(uint32_t threads)
+    : CpuDenoiser(avx2Supported() ? Backend::Avx2 : Backend::Scalar, threads)
+{
+}
+
+CpuDenoiser::CpuDenoiser(Backend backend, uint32_t threads)
+    : _backend(backend), _threads(threads), _kernel(DenoiserKernel::build())
+{
+    if (_threads == 0)
+        _threads = std::max(std::thread::hardware_concurrency(), 1u);
+    if (_backend == Backend::Avx2 && !avx2Supported())
+        throw std::runtime_error("AVX2 denoiser backend is not supported by this CPU.");
+}
+
+bool CpuDenoiser::avx2Supported()
+{
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 1);
+    bool fma = (info[2] & (1 << 12)) != 0;
+    // The OS must save YMM registers too
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+CpuDenoiser::Backend CpuDenoiser::backend() const
+{
+    return _backend;
+}
+
+std::vector<glm::vec4> CpuDenoiser::denoise(const CpuDenoiserFrame& frame, const DenoiserSettings& settings) const
+{
+    int32_t width = frame.size.x;
+    int32_t height = frame.size.y;
+    size_t pixels = static_cast<size_t>(std::max(width, 0)) * static_cast<size_t>(std::max(height, 0));
+    if (frame.color.size() != pixels || frame.normal.size() != pixels || frame.depth.size() != pixels
+        || (!frame.variance.empty() && frame.variance.size() != pixels))
+        throw std::runtime_error(fmt::format("Denoiser inputs don't match the frame size of {}x{}.", width, height));
+
+    // Planar copies of the inputs, so the SIMD backend can load eight neighbouring pixels at once
+    std::vector<float> colorPlanes[2] = { std::vector<float>(pixels * 4), std::vector<float>(pixels * 4) };
+    std::vector<float> positionPlanes(pixels * 3);
+    std::vector<float> normalPlanes(pixels * 3);
+
+    // Same reconstruction as reconstructPosition and decodeNormal in gbuffer.glsl
+    const ScreenQuadPush& screen = frame.screen;
+    glm::vec3 camDir = glm::normalize(glm::vec3(screen.camDir));
+    glm::vec3 planeU = glm::vec3(screen.camRight);
+    glm::vec3 planeV = glm::vec3(screen.camUp) * static_cast<float>(height) / static_cast<float>(width);
+    glm::vec3 jitter(screen.cameraJitter.x / width * -2.0f, screen.cameraJitter.y / height * 2.0f, 0.0f);
+    forEachRowRange(height, _threads, [&](int32_t rowBegin, int32_t rowEnd) {
+        for (int32_t y = rowBegin; y < rowEnd; y++)
+        {
+            for (int32_t x = 0; x < width; x++)
+            {
+                size_t i = static_cast<size_t>(y) * width + x;
+                for (size_t c = 0; c < 3; c++)
+                    colorPlanes[0][pixels * c + i] = frame.color[i][static_cast<glm::length_t>(c)];
+                colorPlanes[0][pixels * 3 + i] = frame.variance.empty() ? 0.0f : frame.variance[i];
+
+                glm::vec2 screenPos = (glm::vec2(x, y) + 0.5f) / glm::vec2(width, height) * 2.0f - 1.0f;
+                glm::vec3 rayDir = glm::normalize(camDir + screenPos.x * planeU + screenPos.y * planeV + jitter);
+                glm::vec3 position = glm::vec3(screen.camPos) + rayDir * frame.depth[i];
+
+                glm::vec3 normal(0.0f);
+                uint8_t face = frame.normal[i];
+                if (face != 0)
+                    normal[(face - 1) / 2] = (face - 1) % 2 == 1 ? 1.0f : -1.0f;
+
+                for (size_t c = 0; c < 3; c++)
+                {
+                    positionPlanes[pixels * c + i] = position[static_cast<glm::length_t>(c)];
+                    normalPlanes[pixels * c + i] = normal[static_cast<glm::length_t>(c)];
+                }
+            }
+        }
+    });
+
+    bool varianceGuided = settings.varianceGuided && !frame.variance.empty();
+    uint32_t iterations = static_cast<uint32_t>(std::max(settings.iterations, 0));
+    for (uint32_t iteration = 0; iteration < iterations; iteration++)
+    {
+        const std::vector<float>& input = colorPlanes[iteration % 2];
+        std::vector<float>& output = colorPlanes[(iteration + 1) % 2];
+
+        cpudenoiser::Source source = {};
+        source.width = width;
+        source.height = height;
+        cpudenoiser::Target target = {};
+        for (size_t c = 0; c < 4; c++)
+        {
+            source.color[c] = input.data() + pixels * c;
+            target.color[c] = output.data() + pixels * c;
+        }
+        for (size_t c = 0; c < 3; c++)
+        {
+            source.position[c] = positionPlanes.data() + pixels * c;
+            source.normal[c] = normalPlanes.data() + pixels * c;
+        }
+
+        // Taps land on the nearest texel, like the normal and depth fetches of the fragment denoiser
+        DenoiserParams params = denoiserIterationParams(settings, varianceGuided, iteration);
+        cpudenoiser::Taps taps = {};
+        for (int32_t t = 0; t < DENOISER_KERNEL_SIZE; t++)
+        {
+            taps.dx[t] = static_cast<int32_t>(std::floor(0.5f + _kernel.offsets[t].x * params.stepWidth));
+            taps.dy[t] = static_cast<int32_t>(std::floor(0.5f + _kernel.offsets[t].y * params.stepWidth));
+            taps.weight[t] = _kernel.weights[t].x;
+            taps.weightSum += taps.weight[t];
+            taps.minDx = std::min(taps.minDx, taps.dx[t]);
+            taps.maxDx = std::max(taps.maxDx, taps.dx[t]);
+        }
+
+        forEachRowRange(height, _threads, [&](int32_t rowBegin, int32_t rowEnd) {
+            if (_backend == Backend::Avx2)
+                cpudenoiser::filterRowsAvx2(source, target, params, taps, rowBegin, rowEnd);
+            else
+                cpudenoiser::filterRowsScalar(source, target, params, taps, rowBegin, rowEnd);
+        });
+    }
+
+    const std::vector<float>& result = colorPlanes[iterations % 2];
+    std::vector<glm::vec4> denoised(pixels);
+    for (size_t i = 0; i < pixels; i++)
+        denoised[i] = glm::vec4(result[i], result[pixels + i], result[pixels * 2 + i], result[pixels * 3 + i]);
+    return denoised;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "voxels/resource/denoiser_kernel.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+struct DenoiserSettings;
+
+// Inputs of one frame, in row-major order.
+struct CpuDenoiserFrame
+{
+    glm::ivec2 size = {};
+    // Camera the frame was rendered with, from which positions are reconstructed
+    ScreenQuadPush screen = {};
+    // Color to denoise, alpha is ignored
+    std::vector<glm::vec4> color;
+    // Face indices, as held by the normal target
+    std::vector<uint8_t> normal;
+    // Distances along the primary rays, as held by the depth target
+    std::vector<float> depth;
+    // Variance of luminance, as written by temporal accumulation, or empty to use fixed color weights
+    std::vector<float> variance;
+};
+
+// CPU implementation of the edge-avoiding à-trous filter of DenoiserStage, for validating and tuning it offline,
+// and for denoising frames rendered without a GPU.
+// Filters with the same iteration parameters and kernel as the fragment denoiser, reading taps from the nearest texel,
+// which matches its bilinear color fetches whenever the step width is whole.
+// Rows are split between threads, and filtered eight pixels at a time with AVX2 on CPUs which support it.
+class CpuDenoiser
+{
+public:
+    enum class Backend
+    {
+        Scalar,
+        Avx2
+    };
+
+private:
+    Backend _backend;
+    uint32_t _threads;
+    DenoiserKernel _kernel;
+
+public:
+    // Uses AVX2 if the CPU supports it, and one thread per hardware thread if threads is 0.
+    explicit CpuDenoiser(uint32_t threads = 0);
+    CpuDenoiser(Backend backend, uint32_t threads);
+
+    static bool avx2Supported();
+    Backend backend() const;
+
+    // Returns the denoised color, with the filtered variance in alpha.
+    std::vector<glm::vec4> denoise(const CpuDenoiserFrame& frame, const DenoiserSettings& settings) const;
+};
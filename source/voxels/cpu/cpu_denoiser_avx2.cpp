@@ -0,0 +1,154 @@
+// Built with AVX2 and FMA enabled, and only called once the CPU is known to support them
+#include "voxels/cpu/cpu_denoiser_rows.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+
+namespace cpudenoiser
+{
+    // Polynomial exponential after Cephes' expf, accurate to a few ulp over the float range
+    static __m256 exp256(__m256 x)
+    {
+        x = _mm256_min_ps(x, _mm256_set1_ps(88.3762626647949f));
+        x = _mm256_max_ps(x, _mm256_set1_ps(-88.3762626647949f));
+
+        // Split into 2^n * e^r, with r in [-ln(2) / 2, ln(2) / 2]
+        __m256 n = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(1.44269504088896341f), _mm256_set1_ps(0.5f)));
+        x = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+        x = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), x);
+
+        __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1f));
+        y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), x);
+        y = _mm256_add_ps(y, _mm256_set1_ps(1.0f));
+
+        __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(y, _mm256_castsi256_ps(exponent));
+    }
+
+    static __m256 luminance(__m256 r, __m256 g, __m256 b)
+    {
+        __m256 l = _mm256_mul_ps(r, _mm256_set1_ps(0.2126f));
+        l = _mm256_fmadd_ps(g, _mm256_set1_ps(0.7152f), l);
+        return _mm256_fmadd_ps(b, _mm256_set1_ps(0.0722f), l);
+    }
+
+    // Filters the eight pixels starting at x, whose taps must all lie within the row
+    static void filterSpan(const Source& source, const Target& target, const DenoiserParams& params, const Taps& taps, int32_t x, int32_t y)
+    {
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        const __m256 one = _mm256_set1_ps(1.0f);
+
+        int32_t rowIndex[DENOISER_KERNEL_SIZE];
+        __m256 deviation = _mm256_setzero_ps();
+        for (int32_t t = 0; t < DENOISER_KERNEL_SIZE; t++)
+        {
+            rowIndex[t] = std::clamp(y + taps.dy[t], 0, source.height - 1) * source.width + x + taps.dx[t];
+            deviation = _mm256_fmadd_ps(_mm256_loadu_ps(source.color[3] + rowIndex[t]), _mm256_set1_ps(taps.weight[t]), deviation);
+        }
+        deviation = _mm256_sqrt_ps(_mm256_max_ps(_mm256_div_ps(deviation, _mm256_set1_ps(taps.weightSum)), _mm256_setzero_ps()));
+        __m256 luminanceScale = _mm256_fmadd_ps(_mm256_set1_ps(params.phiLuminance), deviation, _mm256_set1_ps(1e-4f));
+
+        int32_t center = y * source.width + x;
+        __m256 centerColor[3];
+        __m256 centerNormal[3];
+        __m256 centerPosition[3];
+        for (int32_t c = 0; c < 3; c++)
+        {
+            centerColor[c] = _mm256_loadu_ps(source.color[c] + center);
+            centerNormal[c] = _mm256_loadu_ps(source.normal[c] + center);
+            centerPosition[c] = _mm256_loadu_ps(source.position[c] + center);
+        }
+        __m256 centerLuminance = luminance(centerColor[0], centerColor[1], centerColor[2]);
+
+        // Divisions by the falloffs become multiplications by their negated reciprocals
+        __m256 colorFalloff = _mm256_set1_ps(-1.0f / params.phiColor);
+        __m256 normalFalloff = _mm256_set1_ps(-1.0f / (params.phiNormal * params.stepWidth * params.stepWidth));
+        __m256 posFalloff = _mm256_set1_ps(-1.0f / params.phiPos);
+
+        __m256 sum[3] = { _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+        __m256 totalWeight = _mm256_setzero_ps();
+        __m256 variance = _mm256_setzero_ps();
+        for (int32_t t = 0; t < DENOISER_KERNEL_SIZE; t++)
+        {
+            int32_t i = rowIndex[t];
+            __m256 color[3];
+            for (int32_t c = 0; c < 3; c++)
+                color[c] = _mm256_loadu_ps(source.color[c] + i);
+
+            __m256 edgeWeight;
+            if (params.varianceGuided != 0)
+            {
+                __m256 difference = _mm256_and_ps(_mm256_sub_ps(centerLuminance, luminance(color[0], color[1], color[2])), absMask);
+                edgeWeight = exp256(_mm256_div_ps(_mm256_sub_ps(_mm256_setzero_ps(), difference), luminanceScale));
+            }
+            else
+            {
+                __m256 dist2 = _mm256_setzero_ps();
+                for (int32_t c = 0; c < 3; c++)
+                {
+                    __m256 d = _mm256_sub_ps(centerColor[c], color[c]);
+                    dist2 = _mm256_fmadd_ps(d, d, dist2);
+                }
+                edgeWeight = _mm256_min_ps(exp256(_mm256_mul_ps(dist2, colorFalloff)), one);
+            }
+
+            __m256 normalDist2 = _mm256_setzero_ps();
+            __m256 posDist2 = _mm256_setzero_ps();
+            for (int32_t c = 0; c < 3; c++)
+            {
+                __m256 n = _mm256_sub_ps(centerNormal[c], _mm256_loadu_ps(source.normal[c] + i));
+                __m256 p = _mm256_sub_ps(centerPosition[c], _mm256_loadu_ps(source.position[c] + i));
+                normalDist2 = _mm256_fmadd_ps(n, n, normalDist2);
+                posDist2 = _mm256_fmadd_ps(p, p, posDist2);
+            }
+            __m256 normalWeight = _mm256_min_ps(exp256(_mm256_mul_ps(normalDist2, normalFalloff)), one);
+            __m256 posWeight = _mm256_min_ps(exp256(_mm256_mul_ps(posDist2, posFalloff)), one);
+
+            __m256 kernelWeight = _mm256_mul_ps(_mm256_mul_ps(edgeWeight, normalWeight), _mm256_mul_ps(posWeight, _mm256_set1_ps(taps.weight[t])));
+            for (int32_t c = 0; c < 3; c++)
+                sum[c] = _mm256_fmadd_ps(color[c], kernelWeight, sum[c]);
+            totalWeight = _mm256_add_ps(totalWeight, kernelWeight);
+            variance = _mm256_fmadd_ps(_mm256_loadu_ps(source.color[3] + i), _mm256_mul_ps(kernelWeight, kernelWeight), variance);
+        }
+
+        for (int32_t c = 0; c < 3; c++)
+            _mm256_storeu_ps(target.color[c] + center, _mm256_div_ps(sum[c], totalWeight));
+        _mm256_storeu_ps(target.color[3] + center, _mm256_div_ps(variance, _mm256_mul_ps(totalWeight, totalWeight)));
+    }
+
+    void filterRowsAvx2(const Source& source, const Target& target, const DenoiserParams& params, const Taps& taps, int32_t rowBegin, int32_t rowEnd)
+    {
+        // Pixels whose taps would be clamped at the left or right edge go through the scalar path
+        int32_t spanBegin = std::max(-taps.minDx, 0);
+        int32_t spanEnd = source.width - std::max(taps.maxDx, 0);
+        for (int32_t y = rowBegin; y < rowEnd; y++)
+        {
+            int32_t x = 0;
+            for (; x < std::min(spanBegin, source.width); x++)
+                filterPixel(source, target, params, taps, x, y);
+            for (; x + 8 <= spanEnd; x += 8)
+                filterSpan(source, target, params, taps, x, y);
+            for (; x < source.width; x++)
+                filterPixel(source, target, params, taps, x, y);
+        }
+    }
+}
+
+#else
+
+namespace cpudenoiser
+{
+    void filterRowsAvx2(const Source& source, const Target& target, const DenoiserParams& params, const Taps& taps, int32_t rowBegin, int32_t rowEnd)
+    {
+        filterRowsScalar(source, target, params, taps, rowBegin, rowEnd);
+    }
+}
+
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include "voxels/resource/denoiser_kernel.hpp"
+
+// Row filters shared by the CPU denoiser's backends, working on planar images.
+namespace cpudenoiser
+{
+    // Per-pixel inputs of an iteration, one plane per channel
+    struct Source
+    {
+        int32_t width;
+        int32_t height;
+        const float* color[4];
+        const float* position[3];
+        const float* normal[3];
+    };
+
+    struct Target
+    {
+        float* color[4];
+    };
+
+    // Kernel taps of an iteration, as whole-texel offsets
+    struct Taps
+    {
+        int32_t dx[DENOISER_KERNEL_SIZE];
+        int32_t dy[DENOISER_KERNEL_SIZE];
+        float weight[DENOISER_KERNEL_SIZE];
+        float weightSum;
+        // Offset range, within which pixels need no clamping
+        int32_t minDx;
+        int32_t maxDx;
+    };
+
+    void filterPixel(const Source& source, const Target& target, const DenoiserParams& params, const Taps& taps, int32_t x, int32_t y);
+    void filterRowsScalar(const Source& source, const Target& target, const DenoiserParams& params, const Taps& taps, int32_t rowBegin, int32_t rowEnd);
+    // Must only be called on CPUs supporting AVX2 and FMA.
+    void filterRowsAvx2(const Source& source, const Target& target, const DenoiserParams& params, const Taps& taps, int32_t rowBegin, int32_t rowEnd);
+}
@@ -0,0 +1,50 @@
+#include "beam_prepass_pipeline.hpp"
+
+#include "engine/engine.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+BeamPrepassPipeline BeamPrepassPipeline::build(const std::shared_ptr<Engine>& engine)
+{
+    BeamPrepassPipeline pipeline(engine);
+    pipeline.buildAll();
+    return pipeline;
+}
+
+vk::PipelineShaderStageCreateInfo BeamPrepassPipeline::buildShaderStage()
+{
+    computeModule = ShaderModule(engine, "../shader/beam_prepass.comp.spv", vk::ShaderStageFlagBits::eCompute);
+
+    pipelineDeletionQueue.push_group([=]() {
+        computeModule->destroy();
+    });
+
+    return computeModule->buildStageCreateInfo();
+}
+
+vk::PipelineLayoutCreateInfo BeamPrepassPipeline::buildPipelineLayout()
+{
+    // Screen push constants, followed by whether to combine with the reprojected bounds
+    pushConstantRange = vk::PushConstantRange();
+    pushConstantRange->offset = 0;
+    pushConstantRange->size = sizeof(BeamPrepassPush);
+    pushConstantRange->stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    // Coarse occupancy, and the tiles the bounds are written to
+    auto localDescriptorSet = DescriptorSetBuilder(engine)
+        .image(0, vk::ShaderStageFlagBits::eCompute)
+        .storageImage(1, vk::ShaderStageFlagBits::eCompute)
+        .build("Beam Prepass Descriptor Set");
+    descriptorSet = localDescriptorSet;
+    pushDeletor([=](const std::shared_ptr<Engine>&) {
+        localDescriptorSet.destroy();
+    });
+
+    // Actual layout
+    vk::PipelineLayoutCreateInfo layoutInfo;
+    layoutInfo.pPushConstantRanges = &pushConstantRange.value();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &descriptorSet->layout;
+
+    return layoutInfo;
+}
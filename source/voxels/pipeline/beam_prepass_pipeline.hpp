@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include "engine/pipeline/compute_pipeline.hpp"
+#include "engine/resource/shader_module.hpp"
+#include "engine/pipeline/descriptor_set.hpp"
+
+// Traces a beam per depth tile through the coarse occupancy grid, bounding where its primary rays can first hit.
+class BeamPrepassPipeline : public AComputePipeline
+{
+public:
+    std::optional<DescriptorSet> descriptorSet;
+
+private:
+    std::optional<ShaderModule> computeModule;
+
+    std::optional<vk::PushConstantRange> pushConstantRange;
+
+protected:
+    explicit BeamPrepassPipeline(const std::shared_ptr<Engine>& engine) : AComputePipeline(engine) {};
+
+public:
+    static BeamPrepassPipeline build(const std::shared_ptr<Engine>& engine);
+
+protected:
+    virtual vk::PipelineShaderStageCreateInfo buildShaderStage() override;
+    virtual vk::PipelineLayoutCreateInfo buildPipelineLayout() override;
+};
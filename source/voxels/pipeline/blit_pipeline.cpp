@@ -57,7 +57,7 @@ vk::PipelineLayoutCreateInfo BlitPipeline::buildPipelineLayout()
     // Shader uniforms
     auto localDescriptorSet = DescriptorSetBuilder(engine)
         .image(0, vk::ShaderStageFlagBits::eFragment)
-        .buffer(1, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eUniformBuffer)
+        .buffer(1, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eUniformBufferDynamic)
         .build("Blit Descriptor Set");
     descriptorSet = localDescriptorSet;
     pushDeletor([=](const std::shared_ptr<Engine>&) {
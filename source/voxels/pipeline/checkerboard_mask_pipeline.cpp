@@ -0,0 +1,104 @@
+#include "checkerboard_mask_pipeline.hpp"
+
+#include "engine/engine.hpp"
+#include "engine/resource/shader_module.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+CheckerboardMaskPipeline CheckerboardMaskPipeline::build(const std::shared_ptr<Engine>& engine, const vk::RenderPass& pass)
+{
+    CheckerboardMaskPipeline pipeline(engine, pass);
+    pipeline.buildAll();
+    return pipeline;
+}
+
+std::vector<vk::PipelineShaderStageCreateInfo> CheckerboardMaskPipeline::buildShaderStages()
+{
+    vertexModule = ShaderModule(engine, "../shader/screen_quad.vert.spv", vk::ShaderStageFlagBits::eVertex);
+    fragmentModule = ShaderModule(engine, "../shader/checkerboard_mask.frag.spv", vk::ShaderStageFlagBits::eFragment);
+
+    pipelineDeletionQueue.push_group([=]() {
+        vertexModule->destroy();
+        fragmentModule->destroy();
+    });
+
+    return
+    {
+        vertexModule->buildStageCreateInfo(),
+        fragmentModule->buildStageCreateInfo()
+    };
+}
+
+vk::PipelineVertexInputStateCreateInfo CheckerboardMaskPipeline::buildVertexInputInfo()
+{
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+    vertexInputInfo.vertexBindingDescriptionCount = 0;
+    vertexInputInfo.vertexAttributeDescriptionCount = 0;
+
+    return vertexInputInfo;
+}
+
+vk::PipelineInputAssemblyStateCreateInfo CheckerboardMaskPipeline::buildInputAssembly()
+{
+    // Triangle list with no restart
+    vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
+    inputAssemblyInfo.topology = vk::PrimitiveTopology::eTriangleList;
+    inputAssemblyInfo.primitiveRestartEnable = false;
+    return inputAssemblyInfo;
+}
+
+vk::PipelineLayoutCreateInfo CheckerboardMaskPipeline::buildPipelineLayout()
+{
+    // Screen push constants, with the same range as the tracer's
+    pushConstantRange = vk::PushConstantRange();
+    pushConstantRange->offset = 0;
+    pushConstantRange->size = sizeof(ScreenQuadPush);
+    pushConstantRange->stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
+
+    // No descriptors
+    vk::PipelineLayoutCreateInfo layoutInfo;
+    layoutInfo.pPushConstantRanges = &pushConstantRange.value();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.setLayoutCount = 0;
+
+    return layoutInfo;
+}
+
+vk::PipelineColorBlendStateCreateInfo CheckerboardMaskPipeline::buildColorBlendAttachment()
+{
+    // Color, depth, motion, mask and normal, none of which are written
+    colorBlendAttachments = {};
+
+    vk::PipelineColorBlendAttachmentState blendState;
+    blendState.colorWriteMask = vk::ColorComponentFlags();
+    blendState.blendEnable = false;
+    for (size_t i = 0; i < 5; i++)
+        colorBlendAttachments.push_back(blendState);
+
+    vk::PipelineColorBlendStateCreateInfo colorBlendInfo;
+    colorBlendInfo.logicOpEnable = false;
+    colorBlendInfo.logicOp = vk::LogicOp::eCopy;
+    colorBlendInfo.attachmentCount = static_cast<uint32_t>(colorBlendAttachments.size());
+    colorBlendInfo.pAttachments = colorBlendAttachments.data();
+
+    return colorBlendInfo;
+}
+
+vk::PipelineDepthStencilStateCreateInfo CheckerboardMaskPipeline::buildDepthStencil()
+{
+    vk::PipelineDepthStencilStateCreateInfo depthStencilInfo = APipeline::buildDepthStencil();
+
+    // Every fragment which survives the shader's discard marks its pixel as traced
+    vk::StencilOpState stencil;
+    stencil.failOp = vk::StencilOp::eKeep;
+    stencil.passOp = vk::StencilOp::eReplace;
+    stencil.depthFailOp = vk::StencilOp::eKeep;
+    stencil.compareOp = vk::CompareOp::eAlways;
+    stencil.compareMask = 0xFF;
+    stencil.writeMask = 0xFF;
+    stencil.reference = CHECKERBOARD_STENCIL_TRACED;
+    depthStencilInfo.stencilTestEnable = true;
+    depthStencilInfo.front = stencil;
+    depthStencilInfo.back = stencil;
+
+    return depthStencilInfo;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <optional>
+#include "engine/pipeline/pipeline.hpp"
+#include "engine/resource/shader_module.hpp"
+
+// Must match the stencil reference the tracer is drawn with to skip pixels outside this frame's checkerboard
+#define CHECKERBOARD_STENCIL_TRACED 1
+
+// Writes this frame's half of the checkerboard into the geometry pass' stencil, without touching its color targets.
+// The layout matches the tracer's push constants, so those stay valid between the two draws.
+class CheckerboardMaskPipeline : public APipeline
+{
+private:
+    std::optional<ShaderModule> vertexModule;
+    std::optional<ShaderModule> fragmentModule;
+
+    std::vector<vk::PipelineColorBlendAttachmentState> colorBlendAttachments;
+
+    std::optional<vk::PushConstantRange> pushConstantRange;
+
+protected:
+    CheckerboardMaskPipeline(const std::shared_ptr<Engine>& engine, const vk::RenderPass& pass) : APipeline(engine, pass) {};
+
+public:
+    static CheckerboardMaskPipeline build(const std::shared_ptr<Engine>& engine, const vk::RenderPass& pass);
+
+protected:
+    virtual std::vector<vk::PipelineShaderStageCreateInfo> buildShaderStages() override;
+    virtual vk::PipelineVertexInputStateCreateInfo buildVertexInputInfo() override;
+    virtual vk::PipelineInputAssemblyStateCreateInfo buildInputAssembly() override;
+    virtual vk::PipelineLayoutCreateInfo buildPipelineLayout() override;
+    virtual vk::PipelineColorBlendStateCreateInfo buildColorBlendAttachment() override;
+    virtual vk::PipelineDepthStencilStateCreateInfo buildDepthStencil() override;
+};
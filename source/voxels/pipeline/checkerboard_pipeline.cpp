@@ -0,0 +1,57 @@
+#include "checkerboard_pipeline.hpp"
+
+#include "engine/engine.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+CheckerboardPipeline CheckerboardPipeline::build(const std::shared_ptr<Engine>& engine)
+{
+    CheckerboardPipeline pipeline(engine);
+    pipeline.buildAll();
+    return pipeline;
+}
+
+vk::PipelineShaderStageCreateInfo CheckerboardPipeline::buildShaderStage()
+{
+    computeModule = ShaderModule(engine, "../shader/checkerboard.comp.spv", vk::ShaderStageFlagBits::eCompute);
+
+    pipelineDeletionQueue.push_group([=]() {
+        computeModule->destroy();
+    });
+
+    return computeModule->buildStageCreateInfo();
+}
+
+vk::PipelineLayoutCreateInfo CheckerboardPipeline::buildPipelineLayout()
+{
+    pushConstantRange = vk::PushConstantRange();
+    pushConstantRange->offset = 0;
+    pushConstantRange->size = sizeof(ScreenQuadPush);
+    pushConstantRange->stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    // The G-buffer, last frame's color, depth and normals, the reprojection parameters, and this frame's history
+    auto localDescriptorSet = DescriptorSetBuilder(engine)
+        .storageImage(0, vk::ShaderStageFlagBits::eCompute)
+        .storageImage(1, vk::ShaderStageFlagBits::eCompute)
+        .storageImage(2, vk::ShaderStageFlagBits::eCompute)
+        .storageImage(3, vk::ShaderStageFlagBits::eCompute)
+        .storageImage(4, vk::ShaderStageFlagBits::eCompute)
+        .image(5, vk::ShaderStageFlagBits::eCompute)
+        .image(6, vk::ShaderStageFlagBits::eCompute)
+        .image(7, vk::ShaderStageFlagBits::eCompute)
+        .buffer(8, vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eUniformBufferDynamic)
+        .storageImage(9, vk::ShaderStageFlagBits::eCompute)
+        .build("Checkerboard Descriptor Set");
+    descriptorSet = localDescriptorSet;
+    pushDeletor([=](const std::shared_ptr<Engine>&) {
+        localDescriptorSet.destroy();
+    });
+
+    // Actual layout
+    vk::PipelineLayoutCreateInfo layoutInfo;
+    layoutInfo.pPushConstantRanges = &pushConstantRange.value();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &descriptorSet->layout;
+
+    return layoutInfo;
+}
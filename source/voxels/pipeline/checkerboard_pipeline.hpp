@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include "engine/pipeline/compute_pipeline.hpp"
+#include "engine/resource/shader_module.hpp"
+#include "engine/pipeline/descriptor_set.hpp"
+
+// Fills in the half of the G-buffer left out of a checkerboard frame from reprojected history and its traced neighbours.
+class CheckerboardPipeline : public AComputePipeline
+{
+public:
+    std::optional<DescriptorSet> descriptorSet;
+
+private:
+    std::optional<ShaderModule> computeModule;
+
+    std::optional<vk::PushConstantRange> pushConstantRange;
+
+protected:
+    explicit CheckerboardPipeline(const std::shared_ptr<Engine>& engine) : AComputePipeline(engine) {};
+
+public:
+    static CheckerboardPipeline build(const std::shared_ptr<Engine>& engine);
+
+protected:
+    virtual vk::PipelineShaderStageCreateInfo buildShaderStage() override;
+    virtual vk::PipelineLayoutCreateInfo buildPipelineLayout() override;
+};
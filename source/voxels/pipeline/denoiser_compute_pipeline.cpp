@@ -0,0 +1,54 @@
+#include "denoiser_compute_pipeline.hpp"
+
+#include "engine/engine.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+DenoiserComputePipeline DenoiserComputePipeline::build(const std::shared_ptr<Engine>& engine)
+{
+    DenoiserComputePipeline pipeline(engine);
+    pipeline.buildAll();
+    return pipeline;
+}
+
+vk::PipelineShaderStageCreateInfo DenoiserComputePipeline::buildShaderStage()
+{
+    computeModule = ShaderModule(engine, "../shader/denoiser.comp.spv", vk::ShaderStageFlagBits::eCompute);
+
+    pipelineDeletionQueue.push_group([=]() {
+        computeModule->destroy();
+    });
+
+    return computeModule->buildStageCreateInfo();
+}
+
+vk::PipelineLayoutCreateInfo DenoiserComputePipeline::buildPipelineLayout()
+{
+    // Screen push constants, followed by the iteration's parameters
+    pushConstantRange = vk::PushConstantRange();
+    pushConstantRange->offset = 0;
+    pushConstantRange->size = sizeof(DenoiserPush);
+    pushConstantRange->stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    // Shader uniforms
+    auto localDescriptorSet = DescriptorSetBuilder(engine)
+        .image(0, vk::ShaderStageFlagBits::eCompute)
+        .image(1, vk::ShaderStageFlagBits::eCompute)
+        .image(2, vk::ShaderStageFlagBits::eCompute)
+        .storageImage(3, vk::ShaderStageFlagBits::eCompute)
+        .storageImage(4, vk::ShaderStageFlagBits::eCompute)
+        .image(5, vk::ShaderStageFlagBits::eCompute)
+        .build("Denoiser Compute Descriptor Set");
+    descriptorSet = localDescriptorSet;
+    pushDeletor([=](const std::shared_ptr<Engine>&) {
+        localDescriptorSet.destroy();
+    });
+
+    // Actual layout
+    vk::PipelineLayoutCreateInfo layoutInfo;
+    layoutInfo.pPushConstantRanges = &pushConstantRange.value();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &descriptorSet->layout;
+
+    return layoutInfo;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include "engine/pipeline/compute_pipeline.hpp"
+#include "engine/resource/shader_module.hpp"
+#include "engine/pipeline/descriptor_set.hpp"
+
+// Runs every denoiser iteration from one descriptor set, filtering between the ping-pong storage images.
+class DenoiserComputePipeline : public AComputePipeline
+{
+public:
+    std::optional<DescriptorSet> descriptorSet;
+
+private:
+    std::optional<ShaderModule> computeModule;
+
+    std::optional<vk::PushConstantRange> pushConstantRange;
+
+protected:
+    explicit DenoiserComputePipeline(const std::shared_ptr<Engine>& engine) : AComputePipeline(engine) {};
+
+public:
+    static DenoiserComputePipeline build(const std::shared_ptr<Engine>& engine);
+
+protected:
+    virtual vk::PipelineShaderStageCreateInfo buildShaderStage() override;
+    virtual vk::PipelineLayoutCreateInfo buildPipelineLayout() override;
+};
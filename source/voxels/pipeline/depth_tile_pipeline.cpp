@@ -0,0 +1,53 @@
+#include "depth_tile_pipeline.hpp"
+
+#include "engine/engine.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+DepthTilePipeline DepthTilePipeline::build(const std::shared_ptr<Engine>& engine)
+{
+    DepthTilePipeline pipeline(engine);
+    pipeline.buildAll();
+    return pipeline;
+}
+
+vk::PipelineShaderStageCreateInfo DepthTilePipeline::buildShaderStage()
+{
+    computeModule = ShaderModule(engine, "../shader/depth_tiles.comp.spv", vk::ShaderStageFlagBits::eCompute);
+
+    pipelineDeletionQueue.push_group([=]() {
+        computeModule->destroy();
+    });
+
+    return computeModule->buildStageCreateInfo();
+}
+
+vk::PipelineLayoutCreateInfo DepthTilePipeline::buildPipelineLayout()
+{
+    // Screen push constants, followed by which of the three dispatches is running
+    pushConstantRange = vk::PushConstantRange();
+    pushConstantRange->offset = 0;
+    pushConstantRange->size = sizeof(DepthTilePush);
+    pushConstantRange->stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    // Previous depth, both cameras, and the bounds the tiles are resolved from
+    auto localDescriptorSet = DescriptorSetBuilder(engine)
+        .image(0, vk::ShaderStageFlagBits::eCompute)
+        .buffer(1, vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(2, vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eUniformBufferDynamic)
+        .storageImage(3, vk::ShaderStageFlagBits::eCompute)
+        .storageImage(4, vk::ShaderStageFlagBits::eCompute)
+        .build("Depth Tile Descriptor Set");
+    descriptorSet = localDescriptorSet;
+    pushDeletor([=](const std::shared_ptr<Engine>&) {
+        localDescriptorSet.destroy();
+    });
+
+    // Actual layout
+    vk::PipelineLayoutCreateInfo layoutInfo;
+    layoutInfo.pPushConstantRanges = &pushConstantRange.value();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &descriptorSet->layout;
+
+    return layoutInfo;
+}
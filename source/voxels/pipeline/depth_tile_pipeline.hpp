@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include "engine/pipeline/compute_pipeline.hpp"
+#include "engine/resource/shader_module.hpp"
+#include "engine/pipeline/descriptor_set.hpp"
+
+// Reprojects the previous frame's depth into tiles bounding where this frame's primary rays can first hit.
+class DepthTilePipeline : public AComputePipeline
+{
+public:
+    std::optional<DescriptorSet> descriptorSet;
+
+private:
+    std::optional<ShaderModule> computeModule;
+
+    std::optional<vk::PushConstantRange> pushConstantRange;
+
+protected:
+    explicit DepthTilePipeline(const std::shared_ptr<Engine>& engine) : AComputePipeline(engine) {};
+
+public:
+    static DepthTilePipeline build(const std::shared_ptr<Engine>& engine);
+
+protected:
+    virtual vk::PipelineShaderStageCreateInfo buildShaderStage() override;
+    virtual vk::PipelineLayoutCreateInfo buildPipelineLayout() override;
+};
@@ -0,0 +1,52 @@
+#include "sample_map_pipeline.hpp"
+
+#include "engine/engine.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+SampleMapPipeline SampleMapPipeline::build(const std::shared_ptr<Engine>& engine)
+{
+    SampleMapPipeline pipeline(engine);
+    pipeline.buildAll();
+    return pipeline;
+}
+
+vk::PipelineShaderStageCreateInfo SampleMapPipeline::buildShaderStage()
+{
+    computeModule = ShaderModule(engine, "../shader/sample_map.comp.spv", vk::ShaderStageFlagBits::eCompute);
+
+    pipelineDeletionQueue.push_group([=]() {
+        computeModule->destroy();
+    });
+
+    return computeModule->buildStageCreateInfo();
+}
+
+vk::PipelineLayoutCreateInfo SampleMapPipeline::buildPipelineLayout()
+{
+    // Screen push constants, followed by the budget and which of the two dispatches is running
+    pushConstantRange = vk::PushConstantRange();
+    pushConstantRange->offset = 0;
+    pushConstantRange->size = sizeof(SampleMapPush);
+    pushConstantRange->stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    // Previous moments and depth, the counters, and the map
+    auto localDescriptorSet = DescriptorSetBuilder(engine)
+        .image(0, vk::ShaderStageFlagBits::eCompute)
+        .image(1, vk::ShaderStageFlagBits::eCompute)
+        .buffer(2, vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eStorageBuffer)
+        .storageImage(3, vk::ShaderStageFlagBits::eCompute)
+        .build("Sample Map Descriptor Set");
+    descriptorSet = localDescriptorSet;
+    pushDeletor([=](const std::shared_ptr<Engine>&) {
+        localDescriptorSet.destroy();
+    });
+
+    // Actual layout
+    vk::PipelineLayoutCreateInfo layoutInfo;
+    layoutInfo.pPushConstantRanges = &pushConstantRange.value();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &descriptorSet->layout;
+
+    return layoutInfo;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include "engine/pipeline/compute_pipeline.hpp"
+#include "engine/resource/shader_module.hpp"
+#include "engine/pipeline/descriptor_set.hpp"
+
+// Distributes the ambient sample budget between pixels by the noise of the previous frame's accumulated color.
+class SampleMapPipeline : public AComputePipeline
+{
+public:
+    std::optional<DescriptorSet> descriptorSet;
+
+private:
+    std::optional<ShaderModule> computeModule;
+
+    std::optional<vk::PushConstantRange> pushConstantRange;
+
+protected:
+    explicit SampleMapPipeline(const std::shared_ptr<Engine>& engine) : AComputePipeline(engine) {};
+
+public:
+    static SampleMapPipeline build(const std::shared_ptr<Engine>& engine);
+
+protected:
+    virtual vk::PipelineShaderStageCreateInfo buildShaderStage() override;
+    virtual vk::PipelineLayoutCreateInfo buildPipelineLayout() override;
+};
@@ -0,0 +1,40 @@
+#include "secondary_ray_pipeline.hpp"
+
+#include "engine/engine.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+SecondaryRayPipeline SecondaryRayPipeline::build(const std::shared_ptr<Engine>& engine, const std::string& shaderPath, const vk::DescriptorSetLayout& setLayout)
+{
+    SecondaryRayPipeline pipeline(engine, shaderPath, setLayout);
+    pipeline.buildAll();
+    return pipeline;
+}
+
+vk::PipelineShaderStageCreateInfo SecondaryRayPipeline::buildShaderStage()
+{
+    computeModule = ShaderModule(engine, _shaderPath, vk::ShaderStageFlagBits::eCompute);
+
+    pipelineDeletionQueue.push_group([=]() {
+        computeModule->destroy();
+    });
+
+    return computeModule->buildStageCreateInfo();
+}
+
+vk::PipelineLayoutCreateInfo SecondaryRayPipeline::buildPipelineLayout()
+{
+    // Screen push constants, followed by the effects' scales and the effect being traced
+    pushConstantRange = vk::PushConstantRange();
+    pushConstantRange->offset = 0;
+    pushConstantRange->size = sizeof(SecondaryRayPush);
+    pushConstantRange->stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    // Actual layout
+    vk::PipelineLayoutCreateInfo layoutInfo;
+    layoutInfo.pPushConstantRanges = &pushConstantRange.value();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &_setLayout;
+
+    return layoutInfo;
+}
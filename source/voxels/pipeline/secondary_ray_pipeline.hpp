@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include "engine/pipeline/compute_pipeline.hpp"
+#include "engine/resource/shader_module.hpp"
+
+// One kernel of the reduced resolution secondary rays.
+// Both kernels share a single descriptor set layout, owned by the secondary ray stage.
+class SecondaryRayPipeline : public AComputePipeline
+{
+private:
+    std::string _shaderPath;
+    vk::DescriptorSetLayout _setLayout;
+
+    std::optional<ShaderModule> computeModule;
+
+    std::optional<vk::PushConstantRange> pushConstantRange;
+
+protected:
+    SecondaryRayPipeline(const std::shared_ptr<Engine>& engine, const std::string& shaderPath, const vk::DescriptorSetLayout& setLayout)
+        : AComputePipeline(engine), _shaderPath(shaderPath), _setLayout(setLayout) {};
+
+public:
+    static SecondaryRayPipeline build(const std::shared_ptr<Engine>& engine, const std::string& shaderPath, const vk::DescriptorSetLayout& setLayout);
+
+protected:
+    virtual vk::PipelineShaderStageCreateInfo buildShaderStage() override;
+    virtual vk::PipelineLayoutCreateInfo buildPipelineLayout() override;
+};
@@ -0,0 +1,119 @@
+#include "sky_pipeline.hpp"
+
+#include "engine/engine.hpp"
+#include "engine/resource/shader_module.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+SkyPipeline SkyPipeline::build(const std::shared_ptr<Engine>& engine, const vk::RenderPass& pass, const vk::DescriptorSetLayout& setLayout)
+{
+    SkyPipeline pipeline(engine, pass, setLayout);
+    pipeline.buildAll();
+    return pipeline;
+}
+
+std::vector<vk::PipelineShaderStageCreateInfo> SkyPipeline::buildShaderStages()
+{
+    vertexModule = ShaderModule(engine, "../shader/screen_quad.vert.spv", vk::ShaderStageFlagBits::eVertex);
+    fragmentModule = ShaderModule(engine, "../shader/sky.frag.spv", vk::ShaderStageFlagBits::eFragment);
+
+    pipelineDeletionQueue.push_group([=]() {
+        vertexModule->destroy();
+        fragmentModule->destroy();
+    });
+
+    return
+    {
+        vertexModule->buildStageCreateInfo(),
+        fragmentModule->buildStageCreateInfo()
+    };
+}
+
+vk::PipelineVertexInputStateCreateInfo SkyPipeline::buildVertexInputInfo()
+{
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+    vertexInputInfo.vertexBindingDescriptionCount = 0;
+    vertexInputInfo.vertexAttributeDescriptionCount = 0;
+
+    return vertexInputInfo;
+}
+
+vk::PipelineInputAssemblyStateCreateInfo SkyPipeline::buildInputAssembly()
+{
+    // Triangle list with no restart
+    vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
+    inputAssemblyInfo.topology = vk::PrimitiveTopology::eTriangleList;
+    inputAssemblyInfo.primitiveRestartEnable = false;
+    return inputAssemblyInfo;
+}
+
+vk::PipelineLayoutCreateInfo SkyPipeline::buildPipelineLayout()
+{
+    // Screen push constants, with the same range as the tracer's
+    pushConstantRange = vk::PushConstantRange();
+    pushConstantRange->offset = 0;
+    pushConstantRange->size = sizeof(ScreenQuadPush);
+    pushConstantRange->stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
+
+    // The tracer's set, of which only the skybox and camera are read
+    vk::PipelineLayoutCreateInfo layoutInfo;
+    layoutInfo.pPushConstantRanges = &pushConstantRange.value();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &_setLayout;
+
+    return layoutInfo;
+}
+
+vk::PipelineColorBlendStateCreateInfo SkyPipeline::buildColorBlendAttachment()
+{
+    // Color, depth, motion, mask and normal, all written as by the tracer
+    colorBlendAttachments = {};
+
+    vk::PipelineColorBlendAttachmentState blendState;
+    blendState.colorWriteMask = vk::ColorComponentFlagBits::eR
+            | vk::ColorComponentFlagBits::eG
+            | vk::ColorComponentFlagBits::eB
+            | vk::ColorComponentFlagBits::eA;
+    blendState.blendEnable = false;
+    for (size_t i = 0; i < 5; i++)
+        colorBlendAttachments.push_back(blendState);
+
+    vk::PipelineColorBlendStateCreateInfo colorBlendInfo;
+    colorBlendInfo.logicOpEnable = false;
+    colorBlendInfo.logicOp = vk::LogicOp::eCopy;
+    colorBlendInfo.attachmentCount = static_cast<uint32_t>(colorBlendAttachments.size());
+    colorBlendInfo.pAttachments = colorBlendAttachments.data();
+
+    return colorBlendInfo;
+}
+
+vk::PipelineDepthStencilStateCreateInfo SkyPipeline::buildDepthStencil()
+{
+    vk::PipelineDepthStencilStateCreateInfo depthStencilInfo = APipeline::buildDepthStencil();
+
+    // Only pixels the tracer would trace are considered, and those which survive the shader's discard
+    // are moved off the tracer's reference. The shader discards, so the stencil is written after it runs.
+    vk::StencilOpState stencil;
+    stencil.failOp = vk::StencilOp::eKeep;
+    stencil.passOp = vk::StencilOp::eIncrementAndClamp;
+    stencil.depthFailOp = vk::StencilOp::eKeep;
+    stencil.compareOp = vk::CompareOp::eEqual;
+    stencil.compareMask = 0xFF;
+    stencil.writeMask = 0xFF;
+    depthStencilInfo.stencilTestEnable = true;
+    depthStencilInfo.front = stencil;
+    depthStencilInfo.back = stencil;
+
+    return depthStencilInfo;
+}
+
+vk::PipelineDynamicStateCreateInfo SkyPipeline::buildDynamicState()
+{
+    // Shares the tracer's dynamic stencil reference
+    _dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor, vk::DynamicState::eStencilReference };
+
+    vk::PipelineDynamicStateCreateInfo dynamicStateInfo;
+    dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(_dynamicStates.size());
+    dynamicStateInfo.pDynamicStates = _dynamicStates.data();
+    return dynamicStateInfo;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <optional>
+#include "engine/pipeline/pipeline.hpp"
+#include "engine/resource/shader_module.hpp"
+
+// Fills the pixels whose primary rays miss the volume with the sky, ahead of the fragment tracer in the geometry pass.
+// Filled pixels have their stencil incremented past the tracer's reference, so the tracer's early stencil test skips them.
+// The layout matches the tracer's, so its descriptor set and push constants stay bound for both draws.
+class SkyPipeline : public APipeline
+{
+private:
+    vk::DescriptorSetLayout _setLayout;
+
+    std::optional<ShaderModule> vertexModule;
+    std::optional<ShaderModule> fragmentModule;
+
+    std::vector<vk::PipelineColorBlendAttachmentState> colorBlendAttachments;
+
+    std::optional<vk::PushConstantRange> pushConstantRange;
+
+protected:
+    SkyPipeline(const std::shared_ptr<Engine>& engine, const vk::RenderPass& pass, const vk::DescriptorSetLayout& setLayout)
+        : APipeline(engine, pass), _setLayout(setLayout) {};
+
+public:
+    static SkyPipeline build(const std::shared_ptr<Engine>& engine, const vk::RenderPass& pass, const vk::DescriptorSetLayout& setLayout);
+
+protected:
+    virtual std::vector<vk::PipelineShaderStageCreateInfo> buildShaderStages() override;
+    virtual vk::PipelineVertexInputStateCreateInfo buildVertexInputInfo() override;
+    virtual vk::PipelineInputAssemblyStateCreateInfo buildInputAssembly() override;
+    virtual vk::PipelineLayoutCreateInfo buildPipelineLayout() override;
+    virtual vk::PipelineColorBlendStateCreateInfo buildColorBlendAttachment() override;
+    virtual vk::PipelineDepthStencilStateCreateInfo buildDepthStencil() override;
+    virtual vk::PipelineDynamicStateCreateInfo buildDynamicState() override;
+};
@@ -0,0 +1,51 @@
+#include "sun_visibility_pipeline.hpp"
+
+#include "engine/engine.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+SunVisibilityPipeline SunVisibilityPipeline::build(const std::shared_ptr<Engine>& engine)
+{
+    SunVisibilityPipeline pipeline(engine);
+    pipeline.buildAll();
+    return pipeline;
+}
+
+vk::PipelineShaderStageCreateInfo SunVisibilityPipeline::buildShaderStage()
+{
+    computeModule = ShaderModule(engine, "../shader/sun_visibility.comp.spv", vk::ShaderStageFlagBits::eCompute);
+
+    pipelineDeletionQueue.push_group([=]() {
+        computeModule->destroy();
+    });
+
+    return computeModule->buildStageCreateInfo();
+}
+
+vk::PipelineLayoutCreateInfo SunVisibilityPipeline::buildPipelineLayout()
+{
+    // Screen push constants, followed by the light direction and slice range
+    pushConstantRange = vk::PushConstantRange();
+    pushConstantRange->offset = 0;
+    pushConstantRange->size = sizeof(SunVisibilityPush);
+    pushConstantRange->stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    // Shader uniforms, numbered as in the fragment tracer
+    auto localDescriptorSet = DescriptorSetBuilder(engine)
+        .image(0, vk::ShaderStageFlagBits::eCompute)
+        .buffer(8, vk::ShaderStageFlagBits::eCompute, vk::DescriptorType::eStorageBuffer)
+        .storageImage(9, vk::ShaderStageFlagBits::eCompute)
+        .build("Sun Visibility Descriptor Set");
+    descriptorSet = localDescriptorSet;
+    pushDeletor([=](const std::shared_ptr<Engine>&) {
+        localDescriptorSet.destroy();
+    });
+
+    // Actual layout
+    vk::PipelineLayoutCreateInfo layoutInfo;
+    layoutInfo.pPushConstantRanges = &pushConstantRange.value();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &descriptorSet->layout;
+
+    return layoutInfo;
+}
@@ -0,0 +1,40 @@
+#include "temporal_upscaler_pipeline.hpp"
+
+#include "engine/engine.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+TemporalUpscalerPipeline TemporalUpscalerPipeline::build(const std::shared_ptr<Engine>& engine, const std::string& shaderPath, const vk::DescriptorSetLayout& setLayout)
+{
+    TemporalUpscalerPipeline pipeline(engine, shaderPath, setLayout);
+    pipeline.buildAll();
+    return pipeline;
+}
+
+vk::PipelineShaderStageCreateInfo TemporalUpscalerPipeline::buildShaderStage()
+{
+    computeModule = ShaderModule(engine, _shaderPath, vk::ShaderStageFlagBits::eCompute);
+
+    pipelineDeletionQueue.push_group([=]() {
+        computeModule->destroy();
+    });
+
+    return computeModule->buildStageCreateInfo();
+}
+
+vk::PipelineLayoutCreateInfo TemporalUpscalerPipeline::buildPipelineLayout()
+{
+    // Screen push constants, followed by the target size and history state
+    pushConstantRange = vk::PushConstantRange();
+    pushConstantRange->offset = 0;
+    pushConstantRange->size = sizeof(UpscalerPush);
+    pushConstantRange->stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    // Actual layout
+    vk::PipelineLayoutCreateInfo layoutInfo;
+    layoutInfo.pPushConstantRanges = &pushConstantRange.value();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &_setLayout;
+
+    return layoutInfo;
+}
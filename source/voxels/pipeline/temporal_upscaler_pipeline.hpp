@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include "engine/pipeline/compute_pipeline.hpp"
+#include "engine/resource/shader_module.hpp"
+
+// One kernel of the built-in temporal upscaler.
+// Both kernels share a single descriptor set layout, owned by the upscaler stage.
+class TemporalUpscalerPipeline : public AComputePipeline
+{
+private:
+    std::string _shaderPath;
+    vk::DescriptorSetLayout _setLayout;
+
+    std::optional<ShaderModule> computeModule;
+
+    std::optional<vk::PushConstantRange> pushConstantRange;
+
+protected:
+    TemporalUpscalerPipeline(const std::shared_ptr<Engine>& engine, const std::string& shaderPath, const vk::DescriptorSetLayout& setLayout)
+        : AComputePipeline(engine), _shaderPath(shaderPath), _setLayout(setLayout) {};
+
+public:
+    static TemporalUpscalerPipeline build(const std::shared_ptr<Engine>& engine, const std::string& shaderPath, const vk::DescriptorSetLayout& setLayout);
+
+protected:
+    virtual vk::PipelineShaderStageCreateInfo buildShaderStage() override;
+    virtual vk::PipelineLayoutCreateInfo buildPipelineLayout() override;
+};
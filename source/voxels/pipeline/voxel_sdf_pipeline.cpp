@@ -4,9 +4,31 @@
 #include "engine/resource/shader_module.hpp"
 #include "voxels/resource/screen_quad_push.hpp"
 
-VoxelSDFPipeline VoxelSDFPipeline::build(const std::shared_ptr<Engine>& engine, const vk::RenderPass& pass)
+bool TracerVariant::operator==(const TracerVariant& other) const
+{
+    return maxRaySteps == other.maxRaySteps
+        && maxReflections == other.maxReflections
+        && aoSamples == other.aoSamples
+        && hasMetallic == other.hasMetallic;
+}
+
+size_t TracerVariantHash::operator()(const TracerVariant& variant) const
+{
+    size_t hash = std::hash<uint32_t>()(variant.maxRaySteps);
+    hash = hash * 31 + std::hash<uint32_t>()(variant.maxReflections);
+    hash = hash * 31 + std::hash<uint32_t>()(variant.aoSamples);
+    hash = hash * 31 + std::hash<bool>()(variant.hasMetallic);
+    return hash;
+}
+
+VoxelSDFPipeline VoxelSDFPipeline::build(const std::shared_ptr<Engine>& engine, const vk::RenderPass& pass, const TracerVariant& variant)
 {
     VoxelSDFPipeline pipeline(engine, pass);
+    pipeline._specialization
+        .set<uint32_t>(0, variant.maxRaySteps)
+        .set<uint32_t>(1, variant.maxReflections)
+        .set<uint32_t>(2, variant.aoSamples)
+        .set<vk::Bool32>(3, variant.hasMetallic ? VK_TRUE : VK_FALSE);
     pipeline.buildAll();
     return pipeline;
 }
@@ -59,10 +81,16 @@ vk::PipelineLayoutCreateInfo VoxelSDFPipeline::buildPipelineLayout()
         .image(0, vk::ShaderStageFlagBits::eFragment)
         .buffer(1, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eUniformBuffer)
         .image(2, vk::ShaderStageFlagBits::eFragment)
-        .image(3, vk::ShaderStageFlagBits::eFragment)
-        .buffer(4, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eUniformBuffer)
-        .buffer(5, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eUniformBuffer)
+        .buffer(4, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(5, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eUniformBufferDynamic)
         .image(6, vk::ShaderStageFlagBits::eFragment)
+        .buffer(7, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(8, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eStorageBuffer)
+        .image(9, vk::ShaderStageFlagBits::eFragment)
+        .buffer(10, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eStorageBuffer)
+        .image(11, vk::ShaderStageFlagBits::eFragment)
+        .image(12, vk::ShaderStageFlagBits::eFragment)
+        .image(13, vk::ShaderStageFlagBits::eFragment)
         .build("Geometry Descriptor Set");
     descriptorSet = localDescriptorSet;
     pushDeletor([=](const std::shared_ptr<Engine>&) {
@@ -90,7 +118,8 @@ vk::PipelineColorBlendStateCreateInfo VoxelSDFPipeline::buildColorBlendAttachmen
             | vk::ColorComponentFlagBits::eB
             | vk::ColorComponentFlagBits::eA;
     blendState.blendEnable = false;
-    for (size_t i = 0; i < 6; i++)
+    // Color, depth, motion, mask and normal
+    for (size_t i = 0; i < 5; i++)
         colorBlendAttachments.push_back(blendState);
 
     // No blending ops needed
@@ -102,3 +131,33 @@ vk::PipelineColorBlendStateCreateInfo VoxelSDFPipeline::buildColorBlendAttachmen
 
     return colorBlendInfo;
 }
+
+vk::PipelineDepthStencilStateCreateInfo VoxelSDFPipeline::buildDepthStencil()
+{
+    vk::PipelineDepthStencilStateCreateInfo depthStencilInfo = APipeline::buildDepthStencil();
+
+    // Only pixels whose stencil matches the dynamic reference are traced, which lets checkerboard rendering reject
+    // the other half before shading, while a reference of 0 passes everything the stencil was cleared to
+    vk::StencilOpState stencil;
+    stencil.failOp = vk::StencilOp::eKeep;
+    stencil.passOp = vk::StencilOp::eKeep;
+    stencil.depthFailOp = vk::StencilOp::eKeep;
+    stencil.compareOp = vk::CompareOp::eEqual;
+    stencil.compareMask = 0xFF;
+    stencil.writeMask = 0;
+    depthStencilInfo.stencilTestEnable = true;
+    depthStencilInfo.front = stencil;
+    depthStencilInfo.back = stencil;
+
+    return depthStencilInfo;
+}
+
+vk::PipelineDynamicStateCreateInfo VoxelSDFPipeline::buildDynamicState()
+{
+    _dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor, vk::DynamicState::eStencilReference };
+
+    vk::PipelineDynamicStateCreateInfo dynamicStateInfo;
+    dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(_dynamicStates.size());
+    dynamicStateInfo.pDynamicStates = _dynamicStates.data();
+    return dynamicStateInfo;
+}
@@ -7,6 +7,26 @@
 #include "util/resource_ring.hpp"
 #include "engine/pipeline/descriptor_set.hpp"
 
+// Matches AO_SAMPLES_DYNAMIC in voxel_volume.frag
+#define TRACER_AO_SAMPLES_DYNAMIC 0xFFFFFFFF
+
+// Tracer settings baked into the fragment shader as specialization constants.
+// The default values match the shader's own, giving a generic pipeline which works for any settings.
+struct TracerVariant
+{
+    uint32_t maxRaySteps = 512;
+    uint32_t maxReflections = 5;
+    uint32_t aoSamples = TRACER_AO_SAMPLES_DYNAMIC;
+    bool hasMetallic = true;
+
+    bool operator==(const TracerVariant& other) const;
+};
+
+struct TracerVariantHash
+{
+    size_t operator()(const TracerVariant& variant) const;
+};
+
 class VoxelSDFPipeline : public APipeline
 {
 public:
@@ -24,7 +44,7 @@ protected:
     VoxelSDFPipeline(const std::shared_ptr<Engine>& engine, const vk::RenderPass& pass) : APipeline(engine, pass) {};
 
 public:
-    static VoxelSDFPipeline build(const std::shared_ptr<Engine>& engine, const vk::RenderPass& pass);
+    static VoxelSDFPipeline build(const std::shared_ptr<Engine>& engine, const vk::RenderPass& pass, const TracerVariant& variant = {});
 
 protected:
     virtual std::vector<vk::PipelineShaderStageCreateInfo> buildShaderStages() override;
@@ -32,4 +52,6 @@ protected:
     virtual vk::PipelineInputAssemblyStateCreateInfo buildInputAssembly() override;
     virtual vk::PipelineLayoutCreateInfo buildPipelineLayout() override;
     virtual vk::PipelineColorBlendStateCreateInfo buildColorBlendAttachment() override;
+    virtual vk::PipelineDepthStencilStateCreateInfo buildDepthStencil() override;
+    virtual vk::PipelineDynamicStateCreateInfo buildDynamicState() override;
 };
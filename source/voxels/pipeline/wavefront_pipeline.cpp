@@ -0,0 +1,40 @@
+#include "wavefront_pipeline.hpp"
+
+#include "engine/engine.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+WavefrontPipeline WavefrontPipeline::build(const std::shared_ptr<Engine>& engine, const std::string& shaderPath, const vk::DescriptorSetLayout& setLayout)
+{
+    WavefrontPipeline pipeline(engine, shaderPath, setLayout);
+    pipeline.buildAll();
+    return pipeline;
+}
+
+vk::PipelineShaderStageCreateInfo WavefrontPipeline::buildShaderStage()
+{
+    computeModule = ShaderModule(engine, _shaderPath, vk::ShaderStageFlagBits::eCompute);
+
+    pipelineDeletionQueue.push_group([=]() {
+        computeModule->destroy();
+    });
+
+    return computeModule->buildStageCreateInfo();
+}
+
+vk::PipelineLayoutCreateInfo WavefrontPipeline::buildPipelineLayout()
+{
+    // Screen push constants, followed by the bounce depth
+    pushConstantRange = vk::PushConstantRange();
+    pushConstantRange->offset = 0;
+    pushConstantRange->size = sizeof(WavefrontPush);
+    pushConstantRange->stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+    // Actual layout
+    vk::PipelineLayoutCreateInfo layoutInfo;
+    layoutInfo.pPushConstantRanges = &pushConstantRange.value();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &_setLayout;
+
+    return layoutInfo;
+}
@@ -0,0 +1,43 @@
+#include "ambient_cache.hpp"
+
+#include "engine/engine.hpp"
+#include "engine/commands/command_util.hpp"
+#include "voxels/resource/parameters.hpp"
+
+AmbientCache::AmbientCache(const std::shared_ptr<Engine>& engine) : AResource(engine)
+{
+    _buffer = Buffer(engine, AO_CACHE_CAPACITY * sizeof(AoCacheEntry), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                     VMA_MEMORY_USAGE_GPU_ONLY, "Ambient Cache Buffer");
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _buffer->destroy();
+    });
+}
+
+void AmbientCache::begin(const vk::CommandBuffer& cmd)
+{
+    if (!_cleared)
+    {
+        cmd.fillBuffer(_buffer->buffer, 0, VK_WHOLE_SIZE, 0);
+        cmdutil::memoryBarrier(
+            cmd,
+            vk::AccessFlagBits::eTransferWrite,
+            vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader);
+        _cleared = true;
+        return;
+    }
+
+    // Frames in flight share the table, so the previous frame's updates must land first
+    cmdutil::memoryBarrier(
+        cmd,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader);
+}
+
+const Buffer& AmbientCache::buffer() const
+{
+    return *_buffer;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vulkan/vulkan.hpp>
+#include "engine/resource.hpp"
+#include "engine/resource/buffer.hpp"
+
+// World-space hash table of ambient occlusion, keyed by voxel face.
+// Both tracers look faces up in it, with the first lookup of a face each frame adding a few samples,
+// so occlusion costs rays per visible face rather than per pixel.
+// Occlusion only depends on the scene, so the table lives as long as the scene does.
+class AmbientCache : public AResource
+{
+private:
+    std::optional<Buffer> _buffer;
+    bool _cleared = false;
+
+public:
+    explicit AmbientCache(const std::shared_ptr<Engine>& engine);
+
+    // Clears the table on first use, and orders this frame's lookups after the last frame's.
+    // Must be recorded outside of a render pass.
+    void begin(const vk::CommandBuffer& cmd);
+
+    const Buffer& buffer() const;
+};
@@ -43,6 +43,33 @@ void CameraController::update(float delta)
     updateDirectionVectors();
 }
 
+glm::mat4 CameraController::viewProjection(glm::uvec2 screenSize) const
+{
+    // View space uses the same basis as the tracer's camera planes
+    glm::mat4 view(1.0f);
+    view[0][0] = right.x;
+    view[1][0] = right.y;
+    view[2][0] = right.z;
+    view[0][1] = up.x;
+    view[1][1] = up.y;
+    view[2][1] = up.z;
+    view[0][2] = normalDir.x;
+    view[1][2] = normalDir.y;
+    view[2][2] = normalDir.z;
+    view[3][0] = -glm::dot(right, position);
+    view[3][1] = -glm::dot(up, position);
+    view[3][2] = -glm::dot(normalDir, position);
+
+    // Rays are generated as dir + x * right + y * up * (height / width),
+    // so screen position is the view position divided by its depth along dir
+    glm::mat4 projection(0.0f);
+    projection[0][0] = 1.0f;
+    projection[1][1] = static_cast<float>(screenSize.x) / static_cast<float>(screenSize.y);
+    projection[2][3] = 1.0f;
+
+    return projection * view;
+}
+
 void CameraController::mouseCallback(GLFWwindow* window, double cursorX, double cursorY)
 {
     if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS)
@@ -32,6 +32,9 @@ public:
     void update(float delta);
     void mouseCallback(GLFWwindow* window, double xpos, double ypos);
 
+    // Builds a matrix projecting world positions onto the screen, matching the rays generated by the tracer.
+    glm::mat4 viewProjection(glm::uvec2 screenSize) const;
+
 private:
     void updateDirectionVectors();
 };
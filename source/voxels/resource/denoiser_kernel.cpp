@@ -0,0 +1,31 @@
+#include "denoiser_kernel.hpp"
+
+#include <glm/gtx/functions.hpp>
+#include "voxels/voxel_render_settings.hpp"
+
+DenoiserKernel DenoiserKernel::build()
+{
+    DenoiserKernel kernel;
+    for (int i = 0, y = -DENOISER_KERNEL_RADIUS; y <= DENOISER_KERNEL_RADIUS; y++)
+    {
+        for (int x = -DENOISER_KERNEL_RADIUS; x <= DENOISER_KERNEL_RADIUS; x++, i++)
+        {
+            kernel.offsets[i] = glm::vec4(x, y, 0.0f, 0.0f);
+            kernel.weights[i] = glm::vec4(glm::gauss(glm::vec2(x, y), glm::vec2(0, 0), glm::vec2(2.0, 2.0)), 0.0f, 0.0f, 0.0f);
+        }
+    }
+    return kernel;
+}
+
+DenoiserParams denoiserIterationParams(const DenoiserSettings& settings, bool varianceGuided, uint32_t iteration)
+{
+    DenoiserParams params = {};
+    params.phiColor = 1.0f / (iteration + 1) * settings.phiColor0;
+    params.phiNormal = 1.0f / (iteration + 1) * settings.phiNormal0;
+    params.phiPos = 1.0f / (iteration + 1) * settings.phiPos0;
+    params.stepWidth = iteration * settings.stepWidth + 1.0f;
+    params.phiLuminance = settings.phiLuminance;
+    params.varianceGuided = varianceGuided ? 1 : 0;
+    params.iteration = iteration;
+    return params;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#define DENOISER_KERNEL_RADIUS 1
+#define DENOISER_KERNEL_SIZE ((DENOISER_KERNEL_RADIUS + DENOISER_KERNEL_RADIUS + 1) * (DENOISER_KERNEL_RADIUS + DENOISER_KERNEL_RADIUS + 1))
+
+struct DenoiserSettings;
+
+// Parameters of one à-trous iteration, as uploaded for the fragment denoiser
+struct DenoiserParams
+{
+    float phiColor;
+    float phiNormal;
+    float phiPos;
+    float stepWidth;
+    float phiLuminance;
+    uint32_t varianceGuided;
+    uint32_t iteration;
+};
+
+// Taps of the à-trous kernel in row-major order, each padded to the std140 array stride
+struct DenoiserKernel
+{
+    // Tap offsets in units of the step width, in xy
+    std::array<glm::vec4, DENOISER_KERNEL_SIZE> offsets;
+    // Gaussian tap weights, in x
+    std::array<glm::vec4, DENOISER_KERNEL_SIZE> weights;
+
+    static DenoiserKernel build();
+};
+
+// Filter parameters of the given iteration, widening the kernel and relaxing the edge stops as iterations go on.
+// Variance-guided luminance weights instead tighten on their own, as each iteration filters the variance too.
+DenoiserParams denoiserIterationParams(const DenoiserSettings& settings, bool varianceGuided, uint32_t iteration);
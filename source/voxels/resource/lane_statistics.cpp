@@ -0,0 +1,54 @@
+#include "lane_statistics.hpp"
+
+#include <algorithm>
+#include "engine/engine.hpp"
+#include "engine/resource/buffer.hpp"
+#include "engine/commands/command_util.hpp"
+
+LaneStatistics::LaneStatistics(const std::shared_ptr<Engine>& engine) : AResource(engine)
+{
+    _buffers = ResourceRing<Buffer>::fromFunc(MAX_FRAMES_IN_FLIGHT, [&](uint32_t i) {
+        return Buffer(engine, sizeof(LaneCounters), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                      VMA_MEMORY_USAGE_GPU_TO_CPU, fmt::format("Lane Statistics Buffer {}", i));
+    });
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _buffers.destroy([&](const Buffer& buffer) {
+            buffer.destroy();
+        });
+    });
+
+    _written = std::vector<bool>(MAX_FRAMES_IN_FLIGHT, false);
+}
+
+void LaneStatistics::begin(const vk::CommandBuffer& cmd, uint32_t flightFrame)
+{
+    // The fence for this flight frame has already been waited on, so its counters are final
+    if (_written[flightFrame])
+    {
+        LaneCounters counters = {};
+        _buffers[flightFrame].readData(&counters, sizeof(LaneCounters));
+        for (size_t i = 0; i < LANE_STATS_KERNELS; i++)
+        {
+            utilization[i] = counters.issuedSteps[i] > 0 ? static_cast<float>(counters.activeSteps[i]) / static_cast<float>(counters.issuedSteps[i]) : 0.0f;
+        }
+        float rays = static_cast<float>(std::max(counters.primaryRays, 1u));
+        primary.stepsPerRay = static_cast<float>(counters.activeSteps[0]) / rays;
+        primary.skippedStepsPerRay = static_cast<float>(counters.skippedSteps) / rays;
+        primary.startMissRate = static_cast<float>(counters.startMisses) / rays;
+        valid = true;
+    }
+
+    cmd.fillBuffer(_buffers[flightFrame].buffer, 0, sizeof(LaneCounters), 0);
+    cmdutil::memoryBarrier(
+        cmd,
+        vk::AccessFlagBits::eTransferWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader);
+    _written[flightFrame] = true;
+}
+
+const Buffer& LaneStatistics::buffer(uint32_t flightFrame) const
+{
+    return _buffers[flightFrame];
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <array>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "engine/resource.hpp"
+#include "util/resource_ring.hpp"
+#include "voxels/resource/parameters.hpp"
+
+class Buffer;
+
+// Traversal of primary rays, and what starting them from the depth tiles saved
+struct PrimaryRayStatistics
+{
+    float stepsPerRay = 0.0f;
+    // Steps between entering the volume and each ray's start, which weren't traced
+    float skippedStepsPerRay = 0.0f;
+    // Fraction of rays which started inside a voxel and were traced in full
+    float startMissRate = 0.0f;
+};
+
+// Collects how many subgroup lanes did useful traversal work in each kind of ray.
+// Counters are written by the tracers and read back one flight frame later.
+class LaneStatistics : public AResource
+{
+public:
+    // Fraction of lanes doing useful work for primary, shadow, ambient and reflection rays
+    std::array<float, LANE_STATS_KERNELS> utilization = {};
+    PrimaryRayStatistics primary;
+    bool valid = false;
+
+private:
+    ResourceRing<Buffer> _buffers;
+    std::vector<bool> _written;
+
+public:
+    explicit LaneStatistics(const std::shared_ptr<Engine>& engine);
+
+    // Reads back the previous results for this flight frame, then clears its counters.
+    // Must be recorded outside of a render pass.
+    void begin(const vk::CommandBuffer& cmd, uint32_t flightFrame);
+
+    const Buffer& buffer(uint32_t flightFrame) const;
+};
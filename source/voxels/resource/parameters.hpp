@@ -1,11 +1,113 @@
 #pragma once
 
+#include <array>
 #include <glm/glm.hpp>
 
 struct VolumeParameters
 {
     uint32_t aoSamples = 4;
     float ambientIntensity = 1.0f;
+    uint32_t collectLaneStats = 0;
+    // Whether ambient occlusion is shared between pixels through the world-space cache
+    uint32_t aoCacheEnabled = 1;
+    // Whether ambient occlusion is cone traced through the occupancy mips instead of sampled with rays
+    uint32_t aoCones = 0;
+    // Whether each pixel's ambient sample count is read from the adaptive sample map
+    uint32_t aoAdaptive = 0;
+    // Effects left out of primary hits by the tracers, for the secondary ray stage to add at reduced resolution
+    uint32_t deferredSecondary = 0;
+    // Whether only the checkerboard half of pixels given by the frame index is traced
+    uint32_t checkerboard = 0;
+    // Whether primary rays may start from the depth tiles, which are only written while the previous frame's depth is valid
+    uint32_t depthTilesValid = 0;
+    // Whether pixels which can't reach the volume are filled with the sky ahead of tracing, and left out of primary rays
+    uint32_t tileClassification = 0;
+    // Whether reflection chains are ended by Russian roulette, with simplified lighting past the first reflection
+    uint32_t reflectionRoulette = 0;
+};
+
+// Bits of deferredSecondary, matching DEFER_SHADOW and DEFER_AMBIENT in voxel_types.glsl
+#define SECONDARY_DEFER_SHADOW 1u
+#define SECONDARY_DEFER_AMBIENT 2u
+
+struct CameraParameters
+{
+    glm::mat4 viewProjection;
+    glm::mat4 prevViewProjection;
+};
+
+// Dynamic offsets of the tracers' VolumeParameters, Light and CameraParameters uniforms, in binding order
+using VolumeUniformOffsets = std::array<uint32_t, 3>;
+
+struct TemporalParameters
+{
+    float blendFactor = 0.1f;
+    float positionThreshold = 0.02f;
+    float normalThreshold = 0.9f;
+    uint32_t reset = 1;
+    // Render resolution the history was written at
+    glm::ivec2 prevScreenSize = {};
+    // Camera the history was written with, which its positions are reconstructed from
+    glm::vec2 prevCameraJitter = {};
+    glm::vec4 prevCamPos = {};
+    glm::vec4 prevCamDir = {};
+    glm::vec4 prevCamRight = {};
+    glm::vec4 prevCamUp = {};
+};
+
+// Must match MAX_REFLECTIONS in voxel_types.glsl, plus one for primary rays
+#define WAVEFRONT_MAX_DEPTH 6
+
+// Queue lengths and indirect dispatch sizes for the wavefront tracer
+struct WavefrontQueues
+{
+    uint32_t hitCount[WAVEFRONT_MAX_DEPTH];
+    uint32_t rayCount[WAVEFRONT_MAX_DEPTH];
+    glm::uvec4 hitArgs[WAVEFRONT_MAX_DEPTH];
+    glm::uvec4 rayArgs[WAVEFRONT_MAX_DEPTH];
+    // Indirect dispatch size of the primary kernel, over the tiles classified as able to reach the volume
+    glm::uvec4 tileArgs;
+};
+
+// Must match AO_CACHE_CAPACITY in ambient_cache.glsl, and stay a power of two
+#define AO_CACHE_CAPACITY (1u << 20)
+
+// One voxel face's ambient occlusion samples, matching AoCacheEntry in voxel_types.glsl
+struct AoCacheEntry
+{
+    // Voxel index * 6 + face, plus one so that 0 marks free slots
+    uint32_t key;
+    // Frame the face was last looked up in, plus one
+    uint32_t lastFrame;
+    // Samples which hit geometry, out of all samples taken
+    uint32_t hits;
+    uint32_t samples;
+};
+
+// Traversal steps counted by the tracers for each kind of ray
+#define LANE_STATS_KERNELS 4
+struct LaneCounters
+{
+    uint32_t activeSteps[LANE_STATS_KERNELS];
+    uint32_t issuedSteps[LANE_STATS_KERNELS];
+    // Primary rays traced, the steps starting from the depth tiles saved them, and how many started behind a surface
+    uint32_t primaryRays;
+    uint32_t skippedSteps;
+    uint32_t startMisses;
+};
+
+// Must match SAMPLE_MAP_FIXED_POINT in sample_map.comp
+#define SAMPLE_MAP_FIXED_POINT 64.0f
+
+// Totals of the pixels seeing geometry, gathered by the sample map kernels
+struct SampleMapCounters
+{
+    // Sums of each pixel's weight and relative noise, in fixed point
+    uint32_t weightSum;
+    uint32_t noiseSum;
+    uint32_t pixels;
+    // Ambient samples allocated by the map
+    uint32_t samples;
 };
 
 struct BlitOffsets
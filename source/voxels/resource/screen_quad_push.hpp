@@ -13,3 +13,84 @@ struct ScreenQuadPush
     glm::ivec2 screenSize;
     glm::vec2 cameraJitter;
 };
+
+// Push constants for the wavefront tracer kernels
+struct WavefrontPush
+{
+    ScreenQuadPush screen;
+    // Bounce being processed, with 0 for primary rays
+    uint32_t depth;
+};
+
+// Push constants for one iteration of the compute denoiser
+struct DenoiserPush
+{
+    ScreenQuadPush screen;
+    float phiColor;
+    float phiNormal;
+    float phiPos;
+    // Distance between taps in pixels, rounded as groups are interleaved by it
+    int32_t stepWidth;
+    uint32_t iteration;
+    float phiLuminance;
+    // Whether luminance weights are scaled by the temporal variance, which needs temporal accumulation
+    uint32_t varianceGuided;
+};
+
+// Push constants for the built-in temporal upscaler, with the screen's size and jitter at render resolution
+struct UpscalerPush
+{
+    ScreenQuadPush screen;
+    glm::ivec2 targetSize;
+    // Whether the history is discarded rather than reprojected
+    uint32_t reset;
+    float sharpness;
+};
+
+// Push constants for baking a batch of the sun visibility volume
+struct SunVisibilityPush
+{
+    ScreenQuadPush screen;
+    glm::vec4 lightDirection;
+    // Range of z slices baked by the dispatch
+    uint32_t sliceBegin;
+    uint32_t sliceEnd;
+};
+
+// Push constants for the adaptive sample map kernels
+struct SampleMapPush
+{
+    ScreenQuadPush screen;
+    // Average ambient samples per surface pixel, which the map redistributes by noise
+    uint32_t budget;
+    uint32_t maxSamples;
+    // Whether the dispatch totals the frame's noise, rather than writing the map from the totals
+    uint32_t reduce;
+};
+
+// Push constants for the depth tile kernels
+struct DepthTilePush
+{
+    ScreenQuadPush screen;
+    // Which of the clear, scatter and resolve dispatches is running
+    uint32_t step;
+};
+
+// Push constants for the coarse beam prepass
+struct BeamPrepassPush
+{
+    ScreenQuadPush screen;
+    // Whether the tiles already hold reprojected bounds to combine with
+    uint32_t combine;
+};
+
+// Push constants for the reduced resolution secondary ray kernels
+struct SecondaryRayPush
+{
+    ScreenQuadPush screen;
+    // Pixels per reduced texel along each axis, for each effect
+    uint32_t shadowScale;
+    uint32_t ambientScale;
+    // Effect traced by the dispatch, as one of the SECONDARY_DEFER bits
+    uint32_t effect;
+};
@@ -30,6 +30,76 @@ static glm::ivec3 apply_vox_transform(const ogt_vox_transform& ogtTransform, con
     return apply_transform(ogtMat, pos, pivot);
 }
 
+// Builds the full mip chain of occupancy, each mip packed after the last and averaging 2x2x2 blocks of the one before
+static std::vector<uint8_t> buildOccupancyMips(const std::vector<uint8_t>& sceneData, uint32_t width, uint32_t height, uint32_t depth, uint32_t& mipLevels)
+{
+    std::vector<float> level(sceneData.size());
+    for (size_t i = 0; i < sceneData.size(); i++)
+        level[i] = sceneData[i] != 0 ? 1.0f : 0.0f;
+
+    std::vector<uint8_t> mips;
+    glm::uvec3 size(width, height, depth);
+    mipLevels = 0;
+    while (true)
+    {
+        for (float occupancy : level)
+            mips.push_back(static_cast<uint8_t>(occupancy * 255.0f + 0.5f));
+        mipLevels++;
+        if (size == glm::uvec3(1))
+            break;
+
+        // Odd sizes fold their last voxel into the last block
+        glm::uvec3 mipSize = glm::max(size / 2u, glm::uvec3(1));
+        glm::uvec3 ratio = size / mipSize;
+        std::vector<float> mip(static_cast<size_t>(mipSize.x) * mipSize.y * mipSize.z);
+        for (uint32_t z = 0; z < mipSize.z; z++)
+        {
+            for (uint32_t y = 0; y < mipSize.y; y++)
+            {
+                for (uint32_t x = 0; x < mipSize.x; x++)
+                {
+                    glm::uvec3 begin = glm::uvec3(x, y, z) * ratio;
+                    glm::uvec3 end = begin + ratio;
+                    end = glm::uvec3(x + 1 == mipSize.x ? size.x : end.x, y + 1 == mipSize.y ? size.y : end.y, z + 1 == mipSize.z ? size.z : end.z);
+
+                    float sum = 0.0f;
+                    for (uint32_t sz = begin.z; sz < end.z; sz++)
+                        for (uint32_t sy = begin.y; sy < end.y; sy++)
+                            for (uint32_t sx = begin.x; sx < end.x; sx++)
+                                sum += level[(static_cast<size_t>(sz) * size.y + sy) * size.x + sx];
+                    glm::uvec3 count = end - begin;
+                    mip[(static_cast<size_t>(z) * mipSize.y + y) * mipSize.x + x] = sum / static_cast<float>(count.x * count.y * count.z);
+                }
+            }
+        }
+        level = std::move(mip);
+        size = mipSize;
+    }
+    return mips;
+}
+
+// Marks each cell of the coarse grid holding any solid voxel, with the grid rounded up to cover partial cells at the edges.
+// Unlike the averaged mips, a single voxel in a large block is never rounded away.
+static std::vector<uint8_t> buildCoarseOccupancy(const std::vector<uint8_t>& sceneData, uint32_t width, uint32_t height, uint32_t depth, glm::uvec3& coarseSize)
+{
+    coarseSize = (glm::uvec3(width, height, depth) + glm::uvec3(COARSE_OCCUPANCY_CELL - 1)) / glm::uvec3(COARSE_OCCUPANCY_CELL);
+    std::vector<uint8_t> coarse(static_cast<size_t>(coarseSize.x) * coarseSize.y * coarseSize.z, 0);
+    for (uint32_t z = 0; z < depth; z++)
+    {
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                if (sceneData[(static_cast<size_t>(z) * height + y) * width + x] == 0)
+                    continue;
+                glm::uvec3 cell = glm::uvec3(x, y, z) / glm::uvec3(COARSE_OCCUPANCY_CELL);
+                coarse[(static_cast<size_t>(cell.z) * coarseSize.y + cell.y) * coarseSize.x + cell.x] = 255;
+            }
+        }
+    }
+    return coarse;
+}
+
 VoxelScene::VoxelScene(const std::shared_ptr<Engine>& engine, const std::string& filename, const std::string& skyboxFilename) : AResource(engine)
 {
     // Read in .vox file
@@ -114,20 +184,22 @@ VoxelScene::VoxelScene(const std::shared_ptr<Engine>& engine, const std::string&
         paletteMaterials[m].diffuse = glm::vec4(color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f);
         paletteMaterials[m].diffuse = glm::pow(paletteMaterials[m].diffuse, glm::vec4(2.2f));
         paletteMaterials[m].metallic = metallic;
+        hasMetallic |= metallic > 0.0f;
     }
 
     ogt_vox_destroy_scene(voxScene);
 
     // Copy scene data and palette onto GPU
     sceneTexture = Texture3D(engine, sceneData.data(), width, height, depth, 1, vk::Format::eR8Uint);
+    uint32_t occupancyLevels;
+    std::vector<uint8_t> occupancyData = buildOccupancyMips(sceneData, width, height, depth, occupancyLevels);
+    occupancyTexture = Texture3D(engine, occupancyData.data(), width, height, depth, 1, vk::Format::eR8Unorm, occupancyLevels);
+    glm::uvec3 coarseSize;
+    std::vector<uint8_t> coarseData = buildCoarseOccupancy(sceneData, width, height, depth, coarseSize);
+    coarseOccupancyTexture = Texture3D(engine, coarseData.data(), coarseSize.x, coarseSize.y, coarseSize.z, 1, vk::Format::eR8Unorm);
     paletteBuffer = Buffer(engine, paletteMaterials.size() * sizeof(Material), vk::BufferUsageFlagBits::eUniformBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU, "Palette Buffer");
     paletteBuffer->copyData(paletteMaterials.data(), paletteMaterials.size() * sizeof(Material));
 
-    // Copy light to buffer
-    Light light = {};
-    lightBuffer = Buffer(engine, sizeof(Light), vk::BufferUsageFlagBits::eUniformBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU, "Light Buffer");
-    lightBuffer->copyData(&light, sizeof(Light));
-
     // Load skybox texture
     skyboxTexture = std::make_unique<Texture2D>(engine, skyboxFilename, 4, vk::Format::eR32G32B32A32Sfloat);
 }
@@ -7,6 +7,9 @@
 
 class Texture2D;
 
+// Voxels along each side of a cell of the coarse occupancy grid, matching COARSE_CELL in beam_prepass.comp
+#define COARSE_OCCUPANCY_CELL 4
+
 struct Light
 {
     glm::vec3 direction = glm::normalize(glm::vec3(1.0f, 1.0f, 1.0f));
@@ -21,12 +24,16 @@ public:
     uint32_t width, height, depth;
     // The 3D scene texture
     std::optional<Texture3D> sceneTexture;
+    // Fraction of each voxel, and of each mip's larger blocks, which is solid, for cone traced occlusion
+    std::optional<Texture3D> occupancyTexture;
+    // Whether each cell of COARSE_OCCUPANCY_CELL voxels along each side holds any solid voxel, for conservative beam tracing
+    std::optional<Texture3D> coarseOccupancyTexture;
     // The skybox texture
     std::unique_ptr<Texture2D> skyboxTexture;
     // The buffer holding the material palette
     std::optional<Buffer> paletteBuffer;
-    // The buffer holding the light
-    std::optional<Buffer> lightBuffer;
+    // Whether any palette material is metallic, so reflections can be compiled out otherwise
+    bool hasMetallic = false;
 
 public:
     // Loads a new voxel scene from the given file
@@ -0,0 +1,96 @@
+#include "checkerboard_stage.hpp"
+
+#include "engine/resource/buffer.hpp"
+#include "engine/pipeline/descriptor_set.hpp"
+#include "engine/resource/render_image.hpp"
+#include "engine/engine.hpp"
+#include "engine/graph/render_graph.hpp"
+#include "voxels/pipeline/checkerboard_pipeline.hpp"
+#include "voxels/stages/geometry_stage.hpp"
+#include "voxels/voxel_render_settings.hpp"
+
+CheckerboardStage::CheckerboardStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph)
+    : AVoxelRenderStage(engine, settings, graph)
+{
+    uint32_t recreatorId = engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE, [&]() {
+        _historyTargets = ResourceRing<RenderImage>::fromFunc(2, [&](uint32_t i) {
+            return RenderImage(engine, _settings->maxRenderResolution().x, _settings->maxRenderResolution().y, vk::Format::eR8G8B8A8Unorm,
+                               vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor, fmt::format("Checkerboard History {}", i));
+        });
+        _historyValid = false;
+
+        return [=](const std::shared_ptr<Engine>&) {
+            _historyTargets.destroy([&](const RenderImage& image) {
+                _graph->forgetExternal(image);
+                image.destroy();
+            });
+        };
+    });
+    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
+        delEngine->recreationQueue->remove(recreatorId);
+    });
+
+    _pipeline = std::make_unique<CheckerboardPipeline>(CheckerboardPipeline::build(engine));
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _pipeline->destroy();
+    });
+}
+
+void CheckerboardStage::resetHistory()
+{
+    _historyValid = false;
+}
+
+void CheckerboardStage::record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const GeometryBuffer& gBuffer, const ScreenQuadPush& screen)
+{
+    uint32_t altFrame = (flightFrame + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT;
+    bool historyValid = _historyValid && gBuffer.historyValid;
+
+    _graph->bindExternal("Checkerboard History", _historyTargets[flightFrame]);
+    _graph->bindExternal("Previous Checkerboard History", _historyTargets[altFrame]);
+
+    // History is validated the same way as temporal accumulation's, but never blended
+    _parameters.positionThreshold = _settings->checkerboard.positionThreshold;
+    _parameters.normalThreshold = 0.9f;
+    _parameters.reset = historyValid ? 0 : 1;
+    const ScreenQuadPush& prevScreen = historyValid ? _prevScreen : screen;
+    _parameters.prevScreenSize = prevScreen.screenSize;
+    _parameters.prevCameraJitter = prevScreen.cameraJitter;
+    _parameters.prevCamPos = prevScreen.camPos;
+    _parameters.prevCamDir = prevScreen.camDir;
+    _parameters.prevCamRight = prevScreen.camRight;
+    _parameters.prevCamUp = prevScreen.camUp;
+    _prevScreen = screen;
+    uint32_t parametersOffset = engine->uniforms->push(_parameters);
+
+    const RenderImage& color = gBuffer.color;
+    const RenderImage& depth = gBuffer.depth;
+    const RenderImage& motion = gBuffer.motion;
+    const RenderImage& mask = gBuffer.mask;
+    const RenderImage& normal = gBuffer.normal;
+    const RenderImage& previousDepth = gBuffer.previousDepth;
+    const RenderImage& previousNormal = gBuffer.previousNormal;
+    DescriptorBindings bindings;
+    bindings.storageImage(0, color.imageView)
+        .storageImage(1, depth.imageView)
+        .storageImage(2, motion.imageView)
+        .storageImage(3, mask.imageView)
+        .storageImage(4, normal.imageView)
+        .image(5, _historyTargets[altFrame].imageView, _historyTargets[altFrame].sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(6, previousDepth.imageView, previousDepth.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(7, previousNormal.imageView, previousNormal.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(8, engine->uniforms->buffer, sizeof(TemporalParameters), vk::DescriptorType::eUniformBufferDynamic)
+        .storageImage(9, _historyTargets[flightFrame].imageView);
+
+    _graph->beginPass(cmd, "Checkerboard");
+    glm::uvec2 groups = (glm::uvec2(screen.screenSize) + CHECKERBOARD_GROUP_SIZE - 1u) / static_cast<uint32_t>(CHECKERBOARD_GROUP_SIZE);
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _pipeline->pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _pipeline->layout,
+        0, 1,
+        _pipeline->descriptorSet->getSet(bindings),
+        1, &parametersOffset);
+    cmd.pushConstants(_pipeline->layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(ScreenQuadPush), &screen);
+    cmd.dispatch(groups.x, groups.y, 1);
+
+    _historyValid = true;
+}
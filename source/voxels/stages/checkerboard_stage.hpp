@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <vulkan/vulkan.hpp>
+#include "util/resource_ring.hpp"
+#include "voxels/voxel_render_stage.hpp"
+#include "voxels/resource/parameters.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+class CheckerboardPipeline;
+class RenderImage;
+struct GeometryBuffer;
+
+// Must match the local size of checkerboard.comp
+#define CHECKERBOARD_GROUP_SIZE 8
+
+// Completes a G-buffer of which the tracers only filled in one half of a checkerboard, alternating every frame.
+// Each missing pixel takes the depth, normal and motion of its nearest traced neighbour, and its color from last frame's complete color,
+// reprojected and clamped to the neighbours on its surface, or their average where the history is rejected.
+class CheckerboardStage : public AVoxelRenderStage
+{
+private:
+    TemporalParameters _parameters = {};
+
+    // Complete color of each frame, which the next frame's missing pixels are reprojected from
+    ResourceRing<RenderImage> _historyTargets;
+
+    std::unique_ptr<CheckerboardPipeline> _pipeline;
+
+    bool _historyValid = false;
+    // Screen constants the history was rendered with
+    ScreenQuadPush _prevScreen = {};
+
+public:
+    CheckerboardStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph);
+
+    // Discards the history, e.g. after the scene changes.
+    void resetHistory();
+
+    // Fills in the pixels the tracers left out this frame, within the graph's checkerboard pass.
+    void record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const GeometryBuffer& gBuffer, const ScreenQuadPush& screen);
+};
@@ -1,25 +1,32 @@
 #include "denoiser_stage.hpp"
 
-#include <glm/gtx/functions.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
 #include <glm/glm.hpp>
 #include "engine/resource/buffer.hpp"
-#include "engine/commands/command_util.hpp"
 #include "engine/pipeline/descriptor_set.hpp"
 #include "engine/pipeline/render_pass.hpp"
 #include "voxels/pipeline/denoiser_pipeline.hpp"
+#include "voxels/pipeline/denoiser_compute_pipeline.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
 #include "engine/resource/render_image.hpp"
 #include "engine/pipeline/framebuffer.hpp"
 #include "engine/engine.hpp"
+#include "engine/graph/render_graph.hpp"
 
-struct DenoiserParams
+// Targets alternate between iterations, starting from ping
+static const std::array<std::string, 2> PING_PONG = { "Denoiser Ping", "Denoiser Pong" };
+
+// Variance guidance needs the moments from temporal accumulation
+static DenoiserParams iterationParams(const VoxelRenderSettings& settings, uint32_t i)
 {
-    float phiColor;
-    float phiNormal;
-    float phiPos;
-    float stepWidth;
-};
+    return denoiserIterationParams(settings.denoiserSettings, settings.denoiserSettings.varianceGuided && settings.temporalSettings.enable, i);
+}
 
-DenoiserStage::DenoiserStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings) : AVoxelRenderStage(engine, settings)
+DenoiserStage::DenoiserStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph)
+    : AVoxelRenderStage(engine, settings, graph)
 {
     // Denoise parameters
     _iterationParamsBuffers.reserve(MAX_DENOISER_PASSES);
@@ -33,77 +40,24 @@ DenoiserStage::DenoiserStage(const std::shared_ptr<Engine>& engine, const std::s
             buffer.destroy();
     });
 
-    // Kernel offsets
-    glm::vec2 offsets[DENOISER_KERNEL_SIZE];
-    for (int i = 0, y = -DENOISER_KERNEL_RADIUS; y <= DENOISER_KERNEL_RADIUS; y++)
-    {
-        for (int x = -DENOISER_KERNEL_RADIUS; x <= DENOISER_KERNEL_RADIUS; x++, i++)
-        {
-            offsets[i] = glm::vec2(x, y);
-        }
-    }
-    _offsetBuffer = std::make_unique<Buffer>(engine, sizeof(offsets), vk::BufferUsageFlagBits::eUniformBuffer, VmaMemoryUsage::VMA_MEMORY_USAGE_CPU_TO_GPU, "Denoiser Offsets Buffer");
-    _offsetBuffer->copyData(offsets, _offsetBuffer->size);
+    // Kernel offsets and weights
+    DenoiserKernel kernel = DenoiserKernel::build();
+    _offsetBuffer = std::make_unique<Buffer>(engine, sizeof(kernel.offsets), vk::BufferUsageFlagBits::eUniformBuffer, VmaMemoryUsage::VMA_MEMORY_USAGE_CPU_TO_GPU, "Denoiser Offsets Buffer");
+    _offsetBuffer->copyData(kernel.offsets.data(), _offsetBuffer->size);
     pushDeletor([&](const std::shared_ptr<Engine>&) {
         _offsetBuffer->destroy();
     });
 
-    // Kernel weights
-    float weights[DENOISER_KERNEL_SIZE];
-    for (int i = 0, y = -DENOISER_KERNEL_RADIUS; y <= DENOISER_KERNEL_RADIUS; y++)
-    {
-        for (int x = -DENOISER_KERNEL_RADIUS; x <= DENOISER_KERNEL_RADIUS; x++, i++)
-        {
-            weights[i] = glm::gauss(glm::vec2(x, y), glm::vec2(0, 0), glm::vec2(2.0, 2.0));
-        }
-    }
-    _kernelBuffer = std::make_unique<Buffer>(engine, sizeof(weights), vk::BufferUsageFlagBits::eUniformBuffer, VmaMemoryUsage::VMA_MEMORY_USAGE_CPU_TO_GPU, "Denoiser Kernel Buffer");
-    _kernelBuffer->copyData(weights, _kernelBuffer->size);
+    _kernelBuffer = std::make_unique<Buffer>(engine, sizeof(kernel.weights), vk::BufferUsageFlagBits::eUniformBuffer, VmaMemoryUsage::VMA_MEMORY_USAGE_CPU_TO_GPU, "Denoiser Kernel Buffer");
+    _kernelBuffer->copyData(kernel.weights.data(), _kernelBuffer->size);
     pushDeletor([&](const std::shared_ptr<Engine>&) {
         _kernelBuffer->destroy();
     });
 
-    // Descriptor sets
-    _iterationDescriptors.reserve(MAX_DENOISER_PASSES);
-    for (uint32_t i = 0; i < MAX_DENOISER_PASSES; i++)
-    {
-        _iterationDescriptors.push_back(DescriptorSetBuilder(engine)
-            .image(0, vk::ShaderStageFlagBits::eFragment)
-            .image(1, vk::ShaderStageFlagBits::eFragment)
-            .image(2, vk::ShaderStageFlagBits::eFragment)
-            .buffer(3, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eUniformBuffer)
-            .buffer(4, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eUniformBuffer)
-            .buffer(5, vk::ShaderStageFlagBits::eFragment, vk::DescriptorType::eUniformBuffer)
-            .build("Denoiser Iteration Descriptor Set"));
-    }
-    for (uint32_t i = 0; i < MAX_DENOISER_PASSES; i++)
-    {
-        _iterationDescriptors[i].initBuffer(3, _iterationParamsBuffers[i].buffer, _iterationParamsBuffers[i].size, vk::DescriptorType::eUniformBuffer);
-        _iterationDescriptors[i].initBuffer(4, _kernelBuffer->buffer, _kernelBuffer->size, vk::DescriptorType::eUniformBuffer);
-        _iterationDescriptors[i].initBuffer(5, _offsetBuffer->buffer, _offsetBuffer->size, vk::DescriptorType::eUniformBuffer);
-    }
-    pushDeletor([&](const std::shared_ptr<Engine>&) {
-        for (const DescriptorSet& set : _iterationDescriptors)
-            set.destroy();
-    });
-
-    engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE, [&]() {
-        _colorTargets = ResourceRing<RenderImage>::fromFunc(2, [&](int i) {
-            return RenderImage(engine, _settings->renderResolution().x, _settings->renderResolution().y, vk::Format::eR8G8B8A8Unorm,
-                               vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor, fmt::format("Denoiser Target {}", i));
-        });
-
-        return [=](const std::shared_ptr<Engine>&) {
-            _colorTargets.destroy([&](const RenderImage& image) {
-                image.destroy();
-            });
-        };
-    });
-
     engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE, [&]() {
         _renderPasses = ResourceRing<RenderPass>::fromFunc(10, [&](uint32_t i) {
             return RenderPassBuilder(engine)
-                .color(0, _colorTargets[i % 2].format, glm::vec4(0.0f))
+                .color(0, _graph->image(PING_PONG[i % 2]).format, glm::vec4(0.0f))
                 .build(fmt::format("Denoiser Iteration Render Pass {}", i));
         });
 
@@ -114,10 +68,10 @@ DenoiserStage::DenoiserStage(const std::shared_ptr<Engine>& engine, const std::s
         };
     });
 
-    engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE, [&]() {
+    engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE | RecreationEventFlags::RENDER_GRAPH, [&]() {
         _framebuffers = ResourceRing<Framebuffer>::fromFunc(10, [&](uint32_t n) {
-            return FramebufferBuilder(engine, _renderPasses[n].renderPass, _settings->renderResolution())
-                .color(_colorTargets[n % 2].imageView)
+            return FramebufferBuilder(engine, _renderPasses[n].renderPass, _settings->maxRenderResolution())
+                .color(_graph->image(PING_PONG[n % 2]).imageView)
                 .build("Denoiser Iteration Framebuffer");
         });
 
@@ -133,7 +87,13 @@ DenoiserStage::DenoiserStage(const std::shared_ptr<Engine>& engine, const std::s
         _pipeline->destroy();
     });
 
-    engine->recreationQueue->push(RecreationEventFlags::DENOISER_SETTINGS, [&]() {
+    _computePipeline = std::make_unique<DenoiserComputePipeline>(DenoiserComputePipeline::build(engine));
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _computePipeline->destroy();
+    });
+
+    // Variance guidance depends on whether temporal accumulation is part of the graph
+    engine->recreationQueue->push(RecreationEventFlags::DENOISER_SETTINGS | RecreationEventFlags::RENDER_GRAPH, [&]() {
         updateParameters();
 
         return [=](const std::shared_ptr<Engine>&) {};
@@ -142,117 +102,101 @@ DenoiserStage::DenoiserStage(const std::shared_ptr<Engine>& engine, const std::s
 
 void DenoiserStage::updateParameters() const
 {
-    for (size_t i = 0; i < MAX_DENOISER_PASSES; i++)
+    for (uint32_t i = 0; i < MAX_DENOISER_PASSES; i++)
     {
-        DenoiserParams params = {};
-        params.phiColor = 1.0f / i * _settings->denoiserSettings.phiColor0;
-        params.phiNormal = 1.0f / i * _settings->denoiserSettings.phiNormal0;
-        params.phiPos = 1.0f / i * _settings->denoiserSettings.phiPos0;
-        params.stepWidth = i * _settings->denoiserSettings.stepWidth + 1.0f;
+        DenoiserParams params = iterationParams(*_settings, i);
         _iterationParamsBuffers[i].copyData(&params, sizeof(DenoiserParams));
     }
 }
 
-const RenderImage& DenoiserStage::record(const vk::CommandBuffer& cmd, uint32_t flightFrame,
-                                         const RenderImage& colorInput, const RenderImage& normalInput, const RenderImage& posInput) const
+const RenderImage& DenoiserStage::record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const ScreenQuadPush& screen,
+                                         const RenderImage& colorInput, const RenderImage& normalInput, const RenderImage& depthInput,
+                                         const RenderImage* momentsInput) const
 {
-    cmdutil::imageMemoryBarrier(
-        cmd,
-        posInput.image,
-        vk::AccessFlagBits::eColorAttachmentWrite,
-        vk::AccessFlagBits::eShaderRead,
-        vk::ImageLayout::eColorAttachmentOptimal,
-        vk::ImageLayout::eShaderReadOnlyOptimal,
-        vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        vk::PipelineStageFlagBits::eFragmentShader,
-        vk::ImageAspectFlagBits::eColor);
-
-    cmdutil::imageMemoryBarrier(
-        cmd,
-        normalInput.image,
-        vk::AccessFlagBits::eColorAttachmentWrite,
-        vk::AccessFlagBits::eShaderRead,
-        vk::ImageLayout::eColorAttachmentOptimal,
-        vk::ImageLayout::eShaderReadOnlyOptimal,
-        vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        vk::PipelineStageFlagBits::eFragmentShader,
-        vk::ImageAspectFlagBits::eColor);
-
-    cmdutil::imageMemoryBarrier(
-        cmd,
-        _colorTargets[0].image,
-        vk::AccessFlagBits::eNone,
-        vk::AccessFlagBits::eColorAttachmentWrite,
-        vk::ImageLayout::eUndefined,
-        vk::ImageLayout::eColorAttachmentOptimal,
-        vk::PipelineStageFlagBits::eTopOfPipe,
-        vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        vk::ImageAspectFlagBits::eColor);
-
-    cmdutil::imageMemoryBarrier(
-        cmd,
-        _colorTargets[1].image,
-        vk::AccessFlagBits::eNone,
-        vk::AccessFlagBits::eColorAttachmentWrite,
-        vk::ImageLayout::eUndefined,
-        vk::ImageLayout::eColorAttachmentOptimal,
-        vk::PipelineStageFlagBits::eTopOfPipe,
-        vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        vk::ImageAspectFlagBits::eColor);
+    // Without moments the shaders never read them, but the binding still needs a valid image
+    const RenderImage& moments = momentsInput != nullptr ? *momentsInput : colorInput;
+    if (_settings->denoiserSettings.compute)
+        recordCompute(cmd, screen, colorInput, normalInput, depthInput, moments);
+    else
+        recordFragment(cmd, colorInput, normalInput, depthInput, moments);
+
+    return _graph->image(PING_PONG[(_settings->denoiserSettings.iterations - 1) % 2]);
+}
 
-    int lastOutput = 0;
+void DenoiserStage::recordFragment(const vk::CommandBuffer& cmd, const RenderImage& colorInput, const RenderImage& normalInput, const RenderImage& depthInput,
+                                   const RenderImage& momentsInput) const
+{
+    const RenderImage* output = &colorInput;
     for (int i = 0; i < _settings->denoiserSettings.iterations; i++)
     {
-        int ping = i % 2;
-
-        if (i > 1)
-        {
-            cmdutil::imageMemoryBarrier(
-                cmd,
-                _colorTargets[ping].image,
-                vk::AccessFlagBits::eShaderRead,
-                vk::AccessFlagBits::eColorAttachmentWrite,
-                vk::ImageLayout::eShaderReadOnlyOptimal,
-                vk::ImageLayout::eColorAttachmentOptimal,
-                vk::PipelineStageFlagBits::eFragmentShader,
-                vk::PipelineStageFlagBits::eColorAttachmentOutput,
-                vk::ImageAspectFlagBits::eColor);
-        }
-
         // Use color input on first iteration, last denoiser pass otherwise
-        if (i == 0)
-            _iterationDescriptors[i].writeImage(0, flightFrame, colorInput.imageView, colorInput.sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
-        else
-            _iterationDescriptors[i].writeImage(0, flightFrame, _colorTargets[lastOutput].imageView, _colorTargets[lastOutput].sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
-        // Normal and position inputs
-        _iterationDescriptors[i].writeImage(1, flightFrame, normalInput.imageView, normalInput.sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
-        _iterationDescriptors[i].writeImage(2, flightFrame, posInput.imageView, posInput.sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
-        // Parameters
-        _iterationDescriptors[i].writeBuffer(3, flightFrame, _iterationParamsBuffers[i].buffer, _iterationParamsBuffers[i].size, vk::DescriptorType::eUniformBuffer);
+        const RenderImage& input = *output;
+        DescriptorBindings bindings;
+        bindings.image(0, input.imageView, input.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+            .image(1, normalInput.imageView, normalInput.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+            .image(2, depthInput.imageView, depthInput.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+            .buffer(3, _iterationParamsBuffers[i].buffer, _iterationParamsBuffers[i].size, vk::DescriptorType::eUniformBuffer)
+            .buffer(4, _kernelBuffer->buffer, _kernelBuffer->size, vk::DescriptorType::eUniformBuffer)
+            .buffer(5, _offsetBuffer->buffer, _offsetBuffer->size, vk::DescriptorType::eUniformBuffer)
+            .image(6, momentsInput.imageView, momentsInput.sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
 
         // Start denoise renderpass
+        _graph->beginPass(cmd, fmt::format("Denoiser {}", i));
         _renderPasses[i].recordBegin(cmd, _framebuffers[i]);
         cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, _pipeline->pipeline);
         cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _pipeline->layout,
            0, 1,
-           _iterationDescriptors[i].getSet(flightFrame),
+           _pipeline->descriptorSet->getSet(bindings),
            0, nullptr);
         cmd.draw(3, 1, 0, 0);
         cmd.endRenderPass();
 
-        cmdutil::imageMemoryBarrier(
-            cmd,
-            _colorTargets[ping].image,
-            vk::AccessFlagBits::eColorAttachmentWrite,
-            vk::AccessFlagBits::eShaderRead,
-            vk::ImageLayout::eColorAttachmentOptimal,
-            vk::ImageLayout::eShaderReadOnlyOptimal,
-            vk::PipelineStageFlagBits::eColorAttachmentOutput,
-            vk::PipelineStageFlagBits::eFragmentShader,
-            vk::ImageAspectFlagBits::eColor);
-
-        lastOutput = ping;
+        output = &_graph->image(PING_PONG[i % 2]);
     }
+}
 
-    return _colorTargets[lastOutput];
+void DenoiserStage::recordCompute(const vk::CommandBuffer& cmd, const ScreenQuadPush& screen,
+                                  const RenderImage& colorInput, const RenderImage& normalInput, const RenderImage& depthInput,
+                                  const RenderImage& momentsInput) const
+{
+    // Iterations only differ in their push constants, so they all share one set
+    const RenderImage& ping = _graph->image(PING_PONG[0]);
+    const RenderImage& pong = _graph->image(PING_PONG[1]);
+    DescriptorBindings bindings;
+    bindings.image(0, colorInput.imageView, colorInput.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(1, normalInput.imageView, normalInput.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(2, depthInput.imageView, depthInput.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .storageImage(3, ping.imageView)
+        .storageImage(4, pong.imageView)
+        .image(5, momentsInput.imageView, momentsInput.sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _computePipeline->pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _computePipeline->layout,
+        0, 1,
+        _computePipeline->descriptorSet->getSet(bindings),
+        0, nullptr);
+
+    for (int i = 0; i < _settings->denoiserSettings.iterations; i++)
+    {
+        DenoiserParams params = iterationParams(*_settings, i);
+
+        DenoiserPush push;
+        push.screen = screen;
+        push.phiColor = params.phiColor;
+        push.phiNormal = params.phiNormal;
+        push.phiPos = params.phiPos;
+        push.stepWidth = std::max(static_cast<int32_t>(std::round(params.stepWidth)), 1);
+        push.iteration = i;
+        push.phiLuminance = params.phiLuminance;
+        push.varianceGuided = params.varianceGuided;
+
+        // Groups are interleaved by the step, each covering a tile of every step-th pixel
+        glm::uvec2 step(push.stepWidth);
+        glm::uvec2 strided = (glm::uvec2(screen.screenSize) + step - 1u) / step;
+        glm::uvec2 groups = step * ((strided + glm::uvec2(DENOISER_TILE_SIZE - 1)) / glm::uvec2(DENOISER_TILE_SIZE));
+
+        _graph->beginPass(cmd, fmt::format("Denoiser {}", i));
+        cmd.pushConstants(_computePipeline->layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(DenoiserPush), &push);
+        cmd.dispatch(groups.x, groups.y, 1);
+    }
 }
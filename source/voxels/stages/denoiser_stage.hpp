@@ -5,15 +5,17 @@
 #include <vulkan/vulkan.hpp>
 #include "util/resource_ring.hpp"
 #include "voxels/voxel_render_stage.hpp"
+#include "voxels/resource/denoiser_kernel.hpp"
 
 #define MAX_DENOISER_PASSES 10
-#define DENOISER_KERNEL_RADIUS 1
-#define DENOISER_KERNEL_SIZE ((DENOISER_KERNEL_RADIUS + DENOISER_KERNEL_RADIUS + 1) * (DENOISER_KERNEL_RADIUS + DENOISER_KERNEL_RADIUS + 1))
+// Pixels per side of the compute denoiser's work groups
+#define DENOISER_TILE_SIZE 8
 
 class VoxelRenderSettings;
 class DenoiserPipeline;
+class DenoiserComputePipeline;
+struct ScreenQuadPush;
 class Buffer;
-class DescriptorSet;
 class RenderImage;
 class RenderPass;
 class Framebuffer;
@@ -27,21 +29,30 @@ private:
 
     // Per-iteration resources
     std::vector<Buffer> _iterationParamsBuffers;
-    std::vector<DescriptorSet> _iterationDescriptors;
 
-    // Ping-pong buffers
-    ResourceRing<RenderImage> _colorTargets;
+    // Passes and framebuffers for each iteration, alternating between the graph's ping-pong targets
     ResourceRing<RenderPass> _renderPasses;
     ResourceRing<Framebuffer> _framebuffers;
 
     // Render pipeline
     std::unique_ptr<DenoiserPipeline> _pipeline;
+    // Compute pipeline, which runs every iteration from one descriptor set
+    std::unique_ptr<DenoiserComputePipeline> _computePipeline;
 
 public:
-    DenoiserStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings);
+    DenoiserStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph);
 
     void updateParameters() const;
 
-    const RenderImage& record(const vk::CommandBuffer& cmd, uint32_t flightFrame,
-                              const RenderImage& colorInput, const RenderImage& normalInput, const RenderImage& posInput) const;
+    // Moments are the temporal stage's luminance moments, or null without temporal accumulation, which disables variance guidance.
+    const RenderImage& record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const ScreenQuadPush& screen,
+                              const RenderImage& colorInput, const RenderImage& normalInput, const RenderImage& depthInput,
+                              const RenderImage* momentsInput) const;
+
+private:
+    void recordFragment(const vk::CommandBuffer& cmd, const RenderImage& colorInput, const RenderImage& normalInput, const RenderImage& depthInput,
+                        const RenderImage& momentsInput) const;
+    void recordCompute(const vk::CommandBuffer& cmd, const ScreenQuadPush& screen,
+                       const RenderImage& colorInput, const RenderImage& normalInput, const RenderImage& depthInput,
+                       const RenderImage& momentsInput) const;
 };
@@ -0,0 +1,129 @@
+#include "depth_tile_stage.hpp"
+
+#include "engine/engine.hpp"
+#include "engine/resource/buffer.hpp"
+#include "engine/resource/render_image.hpp"
+#include "engine/resource/texture_3d.hpp"
+#include "engine/commands/command_util.hpp"
+#include "engine/graph/render_graph.hpp"
+#include "voxels/voxel_render_settings.hpp"
+#include "voxels/pipeline/depth_tile_pipeline.hpp"
+#include "voxels/pipeline/beam_prepass_pipeline.hpp"
+#include "voxels/resource/voxel_scene.hpp"
+
+DepthTileStage::DepthTileStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph,
+                               const std::shared_ptr<VoxelScene>& scene) : AVoxelRenderStage(engine, settings, graph), _scene(scene)
+{
+    _pipeline = std::make_unique<DepthTilePipeline>(DepthTilePipeline::build(engine));
+    _beamPipeline = std::make_unique<BeamPrepassPipeline>(BeamPrepassPipeline::build(engine));
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _pipeline->destroy();
+        _beamPipeline->destroy();
+    });
+}
+
+bool DepthTileStage::record(const vk::CommandBuffer& cmd, const ScreenQuadPush& screen, const CameraParameters& camera,
+                            const RenderImage& previousDepth, bool historyValid)
+{
+    ScreenQuadPush prevScreen = _prevScreen;
+    _prevScreen = screen;
+    bool reprojected = _settings->tracerSettings.reprojectedStart && historyValid;
+    if (reprojected)
+        recordReprojection(cmd, screen, prevScreen, camera, previousDepth);
+    if (_settings->tracerSettings.beamPrepass)
+        recordBeams(cmd, screen, reprojected);
+    return reprojected || _settings->tracerSettings.beamPrepass;
+}
+
+void DepthTileStage::recordReprojection(const vk::CommandBuffer& cmd, const ScreenQuadPush& screen, const ScreenQuadPush& prevScreen,
+                                        const CameraParameters& camera, const RenderImage& previousDepth)
+{
+
+    _parameters.reset = 0;
+    _parameters.prevScreenSize = prevScreen.screenSize;
+    _parameters.prevCameraJitter = prevScreen.cameraJitter;
+    _parameters.prevCamPos = prevScreen.camPos;
+    _parameters.prevCamDir = prevScreen.camDir;
+    _parameters.prevCamRight = prevScreen.camRight;
+    _parameters.prevCamUp = prevScreen.camUp;
+    std::array<uint32_t, 2> uniformOffsets = {
+        engine->uniforms->push(camera),
+        engine->uniforms->push(_parameters)
+    };
+
+    const RenderImage& bounds = _graph->image("Depth Tile Bounds");
+    const RenderImage& tiles = _graph->image("Depth Tiles");
+    DescriptorBindings bindings;
+    bindings.image(0, previousDepth.imageView, previousDepth.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(1, engine->uniforms->buffer, sizeof(CameraParameters), vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(2, engine->uniforms->buffer, sizeof(TemporalParameters), vk::DescriptorType::eUniformBufferDynamic)
+        .storageImage(3, bounds.imageView)
+        .storageImage(4, tiles.imageView);
+
+    _graph->beginPass(cmd, "Depth Tiles");
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _pipeline->pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _pipeline->layout,
+        0, 1,
+        _pipeline->descriptorSet->getSet(bindings),
+        static_cast<uint32_t>(uniformOffsets.size()), uniformOffsets.data());
+
+    // Clearing and resolving run per tile, while scattering runs per pixel of the previous frame
+    glm::uvec2 tileCount = (glm::uvec2(screen.screenSize) + DEPTH_TILE_SIZE - 1u) / static_cast<uint32_t>(DEPTH_TILE_SIZE);
+    glm::uvec2 tileGroups = (tileCount + DEPTH_TILE_GROUP_SIZE - 1u) / static_cast<uint32_t>(DEPTH_TILE_GROUP_SIZE);
+    glm::uvec2 pixelGroups = (glm::uvec2(prevScreen.screenSize) + DEPTH_TILE_GROUP_SIZE - 1u) / static_cast<uint32_t>(DEPTH_TILE_GROUP_SIZE);
+    DepthTilePush push;
+    push.screen = screen;
+    for (uint32_t step = 0; step < 3; step++)
+    {
+        // Each step consumes everything the last one wrote
+        if (step > 0)
+        {
+            cmdutil::memoryBarrier(
+                cmd,
+                vk::AccessFlagBits::eShaderWrite,
+                vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+                vk::PipelineStageFlagBits::eComputeShader,
+                vk::PipelineStageFlagBits::eComputeShader);
+        }
+
+        push.step = step;
+        glm::uvec2 groups = step == 1 ? pixelGroups : tileGroups;
+        cmd.pushConstants(_pipeline->layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(DepthTilePush), &push);
+        cmd.dispatch(groups.x, groups.y, 1);
+    }
+}
+
+void DepthTileStage::recordBeams(const vk::CommandBuffer& cmd, const ScreenQuadPush& screen, bool combine)
+{
+    // The reprojected bounds must be resolved before they're combined with the beams
+    if (combine)
+    {
+        cmdutil::memoryBarrier(
+            cmd,
+            vk::AccessFlagBits::eShaderWrite,
+            vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+            vk::PipelineStageFlagBits::eComputeShader,
+            vk::PipelineStageFlagBits::eComputeShader);
+    }
+
+    const RenderImage& tiles = _graph->image("Depth Tiles");
+    DescriptorBindings bindings;
+    bindings.image(0, _scene->coarseOccupancyTexture->imageView, _scene->coarseOccupancyTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .storageImage(1, tiles.imageView);
+
+    _graph->beginPass(cmd, "Beam Prepass");
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _beamPipeline->pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _beamPipeline->layout,
+        0, 1,
+        _beamPipeline->descriptorSet->getSet(bindings),
+        0, nullptr);
+
+    // One beam per tile
+    BeamPrepassPush push;
+    push.screen = screen;
+    push.combine = combine ? 1 : 0;
+    glm::uvec2 tileCount = (glm::uvec2(screen.screenSize) + DEPTH_TILE_SIZE - 1u) / static_cast<uint32_t>(DEPTH_TILE_SIZE);
+    glm::uvec2 groups = (tileCount + DEPTH_TILE_GROUP_SIZE - 1u) / static_cast<uint32_t>(DEPTH_TILE_GROUP_SIZE);
+    cmd.pushConstants(_beamPipeline->layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(BeamPrepassPush), &push);
+    cmd.dispatch(groups.x, groups.y, 1);
+}
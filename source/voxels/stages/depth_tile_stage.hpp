@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <vulkan/vulkan.hpp>
+#include "voxels/voxel_render_stage.hpp"
+#include "voxels/resource/parameters.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+class RenderImage;
+class VoxelScene;
+class DepthTilePipeline;
+class BeamPrepassPipeline;
+
+// Must match the local size of depth_tiles.comp
+#define DEPTH_TILE_GROUP_SIZE 8
+// Pixels along each side of a depth tile, matching DEPTH_TILE_SIZE in depth_tiles.comp and primary_start.glsl
+#define DEPTH_TILE_SIZE 8
+
+// Bounds where each tile's primary rays can first hit, so the tracers can start them there instead of at the volume.
+// Every surface in the previous frame's depth is reprojected into this frame's tiles, keeping the nearest distance from the camera,
+// and each tile takes the nearest bound of its neighbours. Tiles near anything the previous frame didn't see aren't bounded.
+// Separately, a beam covering each tile can be traced through the scene's coarse occupancy, which bounds tiles without any history.
+class DepthTileStage : public AVoxelRenderStage
+{
+private:
+    std::shared_ptr<VoxelScene> _scene;
+
+    TemporalParameters _parameters = {};
+
+    std::unique_ptr<DepthTilePipeline> _pipeline;
+    std::unique_ptr<BeamPrepassPipeline> _beamPipeline;
+
+    // Screen constants the previous depth was rendered with
+    ScreenQuadPush _prevScreen = {};
+
+public:
+    DepthTileStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph,
+                   const std::shared_ptr<VoxelScene>& scene);
+
+    // Builds the tiles from the previous frame's depth, if enabled and that depth is valid, then from the beam prepass if enabled.
+    // Must be recorded every frame, to keep track of the camera the depth was rendered with.
+    // Returns whether the tiles were written, and so may be read by the tracers this frame.
+    bool record(const vk::CommandBuffer& cmd, const ScreenQuadPush& screen, const CameraParameters& camera,
+                const RenderImage& previousDepth, bool historyValid);
+
+private:
+    void recordReprojection(const vk::CommandBuffer& cmd, const ScreenQuadPush& screen, const ScreenQuadPush& prevScreen,
+                            const CameraParameters& camera, const RenderImage& previousDepth);
+    // Takes the further of each tile's beam and reprojected bounds when combining, as both are conservative
+    void recordBeams(const vk::CommandBuffer& cmd, const ScreenQuadPush& screen, bool combine);
+};
@@ -9,71 +9,89 @@
 #include "voxels/pipeline/voxel_sdf_pipeline.hpp"
 #include "voxels/resource/voxel_scene.hpp"
 #include "engine/resource/texture_2d.hpp"
-#include "engine/commands/command_util.hpp"
+#include "voxels/stages/wavefront_stage.hpp"
+#include "voxels/stages/sun_visibility_stage.hpp"
+#include "voxels/resource/lane_statistics.hpp"
+#include "voxels/resource/ambient_cache.hpp"
+#include "voxels/stages/sample_map_stage.hpp"
+#include "voxels/stages/secondary_ray_stage.hpp"
+#include "voxels/stages/checkerboard_stage.hpp"
+#include "voxels/stages/depth_tile_stage.hpp"
+#include "voxels/pipeline/checkerboard_mask_pipeline.hpp"
+#include "voxels/pipeline/sky_pipeline.hpp"
+#include "engine/graph/render_graph.hpp"
 
-GeometryStage::GeometryStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<VoxelScene>& scene, const std::shared_ptr<Texture2D>& noise) : AVoxelRenderStage(engine, settings), _scene(scene)
+// The smallest stencil format the device can render to, as no depth is needed
+static vk::Format stencilFormat(const std::shared_ptr<Engine>& engine)
 {
-    _parametersBuffer = std::make_unique<Buffer>(engine, sizeof(VolumeParameters), vk::BufferUsageFlagBits::eUniformBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU, "G-Pass Parameters Buffer");
-    _parametersBuffer->copyData(&_parameters, sizeof(VolumeParameters));
+    for (vk::Format format : { vk::Format::eS8Uint, vk::Format::eD24UnormS8Uint, vk::Format::eD32SfloatS8Uint })
+    {
+        vk::FormatProperties properties = engine->physicalDevice.getFormatProperties(format);
+        if (properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment)
+            return format;
+    }
+    throw std::runtime_error("No supported stencil attachment format");
+}
 
+GeometryStage::GeometryStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph,
+                             const std::shared_ptr<VoxelScene>& scene, const std::shared_ptr<Texture2D>& noise) : AVoxelRenderStage(engine, settings, graph), _scene(scene), _noise(noise)
+{
     uint32_t recreatorId = engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE, [&]() {
-        glm::uvec2 renderRes = settings->renderResolution();
-
-        _colorTarget = std::make_unique<RenderImage>(engine, renderRes.x, renderRes.y, vk::Format::eR8G8B8A8Unorm,
-                                   vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor, "Color Target");
-        _depthTarget = std::make_unique<RenderImage>(engine, renderRes.x, renderRes.y, vk::Format::eR32Sfloat,
-                                   vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor, "Depth Target");
-        _motionTarget = std::make_unique<RenderImage>(engine, renderRes.x, renderRes.y, vk::Format::eR32G32Sfloat,
-                                    vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor, "Motion Target");
-        _maskTarget = std::make_unique<RenderImage>(engine, renderRes.x, renderRes.y, vk::Format::eR8Unorm,
-                                  vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor, "Mask Target");
-        _positionTargets = ResourceRing<RenderImage>::fromArgs(2, engine, renderRes.x, renderRes.y, vk::Format::eR32G32B32A32Sfloat,
-                                                               vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor, "Position Target");
-        _normalTarget = std::make_unique<RenderImage>(engine, renderRes.x, renderRes.y, vk::Format::eR8G8B8A8Snorm,
-                                    vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor, "Normal Target");
+        glm::uvec2 renderRes = settings->maxRenderResolution();
+
+        _depthTargets = ResourceRing<RenderImage>::fromArgs(2, engine, renderRes.x, renderRes.y, vk::Format::eR32Sfloat,
+                                                            vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage, vk::ImageAspectFlagBits::eColor, "Depth Target");
+        // Axis-aligned normals are stored as a face index
+        _normalTargets = ResourceRing<RenderImage>::fromArgs(2, engine, renderRes.x, renderRes.y, vk::Format::eR8Unorm,
+                                                             vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage, vk::ImageAspectFlagBits::eColor, "Normal Target");
+        // Only used within the pass, to mask out pixels before they're shaded
+        vk::Format format = stencilFormat(engine);
+        vk::ImageAspectFlags aspect = format == vk::Format::eS8Uint ? vk::ImageAspectFlags(vk::ImageAspectFlagBits::eStencil)
+                                                                    : vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+        _stencilTargets = ResourceRing<RenderImage>::fromArgs(2, engine, renderRes.x, renderRes.y, format,
+                                                              vk::ImageUsageFlagBits::eDepthStencilAttachment, aspect, "Stencil Target");
+        _historyValid = false;
 
         return [=](const std::shared_ptr<Engine>&) {
-            _colorTarget->destroy();
-            _depthTarget->destroy();
-            _maskTarget->destroy();
-            _maskTarget->destroy();
-            _positionTargets.destroy([=](const RenderImage& image) {
+            _depthTargets.destroy([=](const RenderImage& image) {
+                _graph->forgetExternal(image);
+                image.destroy();
+            });
+            _normalTargets.destroy([=](const RenderImage& image) {
+                _graph->forgetExternal(image);
+                image.destroy();
+            });
+            _stencilTargets.destroy([=](const RenderImage& image) {
                 image.destroy();
             });
-            _normalTarget->destroy();
         };
     });
     pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
         delEngine->recreationQueue->remove(recreatorId);
     });
 
-    recreatorId = engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE, [&]() {
-        _renderPass = RenderPassBuilder(engine)
-            .color(0, _colorTarget->format, glm::vec4(0.0))
-            .color(1, _depthTarget->format, glm::vec4(0.0))
-            .color(2, _motionTarget->format, glm::vec4(0.0))
-            .color(3, _maskTarget->format, glm::vec4(0.0))
-            .color(4, _positionTargets[0].format, glm::vec4(0.0))
-            .color(5, _normalTarget->format, glm::vec4(0.0))
-            .buildUnique("Geometry Render Pass");
-
-        return [=](const std::shared_ptr<Engine>&) {
-            _renderPass->destroy();
-        };
-    });
-    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
-        delEngine->recreationQueue->remove(recreatorId);
+    // Target formats never change, so the render pass outlives target recreation and can be used by pipeline builds on worker threads
+    _renderPass = RenderPassBuilder(engine)
+        .color(0, graph->image("Color").format, glm::vec4(0.0))
+        .color(1, _depthTargets[0].format, glm::vec4(0.0))
+        .color(2, graph->image("Motion").format, glm::vec4(0.0))
+        .color(3, graph->image("Mask").format, glm::vec4(0.0))
+        .color(4, _normalTargets[0].format, glm::vec4(0.0))
+        .depthStencil(5, _stencilTargets[0].format, 0.0f, 0)
+        .buildUnique("Geometry Render Pass");
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _renderPass->destroy();
     });
 
-    recreatorId = engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE, [&]() {
+    recreatorId = engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE | RecreationEventFlags::RENDER_GRAPH, [&]() {
         _framebuffers = ResourceRing<Framebuffer>::fromFunc(2, [&](uint32_t n) {
-            return FramebufferBuilder(engine, _renderPass->renderPass, settings->renderResolution())
-                .color(_colorTarget->imageView)
-                .color(_depthTarget->imageView)
-                .color(_motionTarget->imageView)
-                .color(_maskTarget->imageView)
-                .color(_positionTargets[n].imageView)
-                .color(_normalTarget->imageView)
+            return FramebufferBuilder(engine, _renderPass->renderPass, settings->maxRenderResolution())
+                .color(_graph->image("Color").imageView)
+                .color(_depthTargets[n].imageView)
+                .color(_graph->image("Motion").imageView)
+                .color(_graph->image("Mask").imageView)
+                .color(_normalTargets[n].imageView)
+                .depthStencil(_stencilTargets[n].imageView)
                 .build("Geometry Framebuffer");
         });
 
@@ -87,92 +105,211 @@ GeometryStage::GeometryStage(const std::shared_ptr<Engine>& engine, const std::s
         delEngine->recreationQueue->remove(recreatorId);
     });
 
+    _laneStatistics = std::make_unique<LaneStatistics>(engine);
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _laneStatistics->destroy();
+    });
+
     _pipeline = std::make_unique<VoxelSDFPipeline>(VoxelSDFPipeline::build(engine, _renderPass->renderPass));
+    vk::RenderPass pass = _renderPass->renderPass;
+    _variants = std::make_unique<PipelineVariantCache<TracerVariant, VoxelSDFPipeline, TracerVariantHash>>([engine, pass](const TracerVariant& variant) {
+        return VoxelSDFPipeline::build(engine, pass, variant);
+    }, 8, MAX_FRAMES_IN_FLIGHT);
+    _maskPipeline = std::make_unique<CheckerboardMaskPipeline>(CheckerboardMaskPipeline::build(engine, _renderPass->renderPass));
+    _skyPipeline = std::make_unique<SkyPipeline>(SkyPipeline::build(engine, _renderPass->renderPass, _pipeline->descriptorSet->layout));
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _pipeline->destroy();
+        _variants->destroy();
+        _maskPipeline->destroy();
+        _skyPipeline->destroy();
+    });
 
-    recreatorId = engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE, [&]() {
-        _pipeline->descriptorSet->initImage(0, scene->sceneTexture->imageView, scene->sceneTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
-        _pipeline->descriptorSet->initBuffer(1, scene->paletteBuffer->buffer, scene->paletteBuffer->size, vk::DescriptorType::eUniformBuffer);
-        _pipeline->descriptorSet->initImage(2, noise->imageView, noise->sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
-        _pipeline->descriptorSet->initBuffer(5, scene->lightBuffer->buffer, scene->lightBuffer->size, vk::DescriptorType::eUniformBuffer);
-        _pipeline->descriptorSet->initImage(6, scene->skyboxTexture->imageView, scene->skyboxTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
+    _wavefrontStage = std::make_unique<WavefrontStage>(engine, settings, graph, scene, noise);
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _wavefrontStage->destroy();
+    });
 
-        return [=](const std::shared_ptr<Engine>&) {};
+    _sunVisibilityStage = std::make_unique<SunVisibilityStage>(engine, settings, graph, scene);
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _sunVisibilityStage->destroy();
     });
-    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
-        delEngine->recreationQueue->remove(recreatorId);
+
+    _ambientCache = std::make_unique<AmbientCache>(engine);
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _ambientCache->destroy();
+    });
+
+    _sampleMapStage = std::make_unique<SampleMapStage>(engine, settings, graph);
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _sampleMapStage->destroy();
+    });
+
+    _depthTileStage = std::make_unique<DepthTileStage>(engine, settings, graph, scene);
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _depthTileStage->destroy();
+    });
+
+    _secondaryRayStage = std::make_unique<SecondaryRayStage>(engine, settings, graph, scene, noise);
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _secondaryRayStage->destroy();
+    });
+
+    _checkerboardStage = std::make_unique<CheckerboardStage>(engine, settings, graph);
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _checkerboardStage->destroy();
     });
 }
 
-GeometryBuffer GeometryStage::record(const vk::CommandBuffer& cmd, uint32_t flightFrame)
+GeometryBuffer GeometryStage::record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const CameraParameters& camera, const ScreenQuadPush& screen,
+                                     const RenderImage* previousMoments, bool momentsValid)
 {
-    uint32_t altFrame = (flightFrame + 1) % 2;
-    cmdutil::imageMemoryBarrier(
-        cmd,
-        _positionTargets[flightFrame].image,
-        vk::AccessFlagBits::eShaderRead,
-        vk::AccessFlagBits::eColorAttachmentWrite,
-        vk::ImageLayout::eUndefined,
-        vk::ImageLayout::eColorAttachmentOptimal,
-        vk::PipelineStageFlagBits::eFragmentShader,
-        vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        vk::ImageAspectFlagBits::eColor);
-    cmdutil::imageMemoryBarrier(
-        cmd,
-        _positionTargets[altFrame].image,
-        vk::AccessFlagBits::eColorAttachmentWrite,
-        vk::AccessFlagBits::eShaderRead,
-        vk::ImageLayout::eUndefined,
-        vk::ImageLayout::eShaderReadOnlyOptimal,
-        vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        vk::PipelineStageFlagBits::eFragmentShader,
-        vk::ImageAspectFlagBits::eColor);
+    uint32_t altFrame = (flightFrame + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT;
+    bool historyValid = _historyValid;
+    _historyValid = true;
 
-    // Start color renderpass
-    _renderPass->recordBegin(cmd, _framebuffers[flightFrame]);
-    // Bind pipeline
-    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, _pipeline->pipeline);
-    // Set parameters buffer
+    _laneStatistics->begin(cmd, flightFrame);
+
+    _graph->bindExternal("Depth", _depthTargets[flightFrame]);
+    _graph->bindExternal("Normal", _normalTargets[flightFrame]);
+    _graph->bindExternal("Previous Depth", _depthTargets[altFrame]);
+    _graph->bindExternal("Previous Normal", _normalTargets[altFrame]);
+
+    // Sample counts follow last frame's noise, which is only meaningful where last frame's depth is
+    bool adaptive = _sampleMapStage->record(cmd, flightFrame, screen, _depthTargets[altFrame], previousMoments, momentsValid && historyValid);
+    bool depthTiles = _depthTileStage->record(cmd, screen, camera, _depthTargets[altFrame], historyValid);
+
+    // Push this frame's uniforms
     _parameters.aoSamples = _settings->occlusionSettings.numSamples;
     _parameters.ambientIntensity = _settings->occlusionSettings.intensity;
-    _parametersBuffer->copyData(&_parameters, sizeof(VolumeParameters));
+    _parameters.collectLaneStats = _settings->tracerSettings.collectLaneStats ? 1 : 0;
+    _parameters.aoCacheEnabled = _settings->occlusionSettings.cache ? 1 : 0;
+    _parameters.aoCones = _settings->occlusionSettings.mode == AmbientOcclusionMode::CONES ? 1 : 0;
+    _parameters.aoAdaptive = adaptive ? 1 : 0;
+    _parameters.deferredSecondary = _secondaryRayStage->deferred();
+    _parameters.checkerboard = _settings->checkerboard.enable ? 1 : 0;
+    _parameters.depthTilesValid = depthTiles ? 1 : 0;
+    _parameters.tileClassification = _settings->tracerSettings.tileClassification ? 1 : 0;
+    _parameters.reflectionRoulette = _settings->tracerSettings.reflectionRoulette ? 1 : 0;
     Light light = {};
     light.intensity = _settings->lightSettings.intensity;
     light.direction = _settings->lightSettings.direction;
     light.color = _settings->lightSettings.color;
-    _scene->lightBuffer->copyData(&light, sizeof(Light));
-    _pipeline->descriptorSet->writeImage(3, flightFrame, _positionTargets[altFrame].imageView, _positionTargets[altFrame].sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
-    _pipeline->descriptorSet->writeBuffer(4, flightFrame, _parametersBuffer->buffer, sizeof(VolumeParameters), vk::DescriptorType::eUniformBuffer);
-    _pipeline->descriptorSet->writeBuffer(5, flightFrame, _scene->lightBuffer->buffer, _scene->lightBuffer->size, vk::DescriptorType::eUniformBuffer);
+    VolumeUniformOffsets uniformOffsets = {
+        engine->uniforms->push(_parameters),
+        engine->uniforms->push(light),
+        engine->uniforms->push(camera)
+    };
+
+    GeometryBuffer gBuffer = {
+        std::cref(_graph->image("Color")),
+        std::cref(_depthTargets[flightFrame]),
+        std::cref(_graph->image("Motion")),
+        std::cref(_graph->image("Mask")),
+        std::cref(_normalTargets[flightFrame]),
+        std::cref(_depthTargets[altFrame]),
+        std::cref(_normalTargets[altFrame]),
+        historyValid
+    };
+
+    // The volume isn't a graph image, so the bake orders itself against the tracers
+    _sunVisibilityStage->record(cmd, screen, _laneStatistics->buffer(flightFrame));
+    const Texture3D& sunVisibility = _sunVisibilityStage->volume();
+    _ambientCache->begin(cmd);
+    const Buffer& ambientCache = _ambientCache->buffer();
+    const RenderImage& sampleMap = _graph->image("Sample Map");
+    const RenderImage& depthTileMap = _graph->image("Depth Tiles");
+
+    _graph->beginPass(cmd, "Geometry");
+
+    if (_settings->tracerSettings.wavefront)
+        _wavefrontStage->record(cmd, flightFrame, gBuffer, screen, uniformOffsets, _laneStatistics->buffer(flightFrame), sunVisibility, ambientCache, sampleMap, depthTileMap);
+    else
+        recordFragment(cmd, flightFrame, uniformOffsets, sunVisibility, ambientCache, sampleMap, depthTileMap);
+
+    _secondaryRayStage->record(cmd, gBuffer, screen, uniformOffsets, _laneStatistics->buffer(flightFrame), sunVisibility, ambientCache);
+
+    // Missing pixels are filled in last, so they take the deferred effects from history along with the rest of their color
+    if (_settings->checkerboard.enable)
+        _checkerboardStage->record(cmd, flightFrame, gBuffer, screen);
+    else
+        _checkerboardStage->resetHistory();
+
+    return gBuffer;
+}
+
+void GeometryStage::recordFragment(const vk::CommandBuffer& cmd, uint32_t flightFrame, const VolumeUniformOffsets& uniformOffsets,
+                                   const Texture3D& sunVisibility, const Buffer& ambientCache, const RenderImage& sampleMap, const RenderImage& depthTiles)
+{
+    // Fall back to the generic pipeline until the variant for the current settings is built
+    VoxelSDFPipeline* pipeline = _variants->get(currentVariant());
+    if (pipeline == nullptr)
+        pipeline = _pipeline.get();
+
+    // Start color renderpass
+    _renderPass->recordBegin(cmd, _framebuffers[flightFrame]);
+    // Mark the pixels to trace, so the rest are rejected by the early stencil test instead of idling in the tracer's warps
+    bool checkerboard = _settings->checkerboard.enable;
+    if (checkerboard)
+    {
+        cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, _maskPipeline->pipeline);
+        cmd.draw(3, 1, 0, 0);
+    }
+    // Variant layouts are defined identically to the generic one, so its sets are compatible with every variant
+    DescriptorBindings bindings;
+    bindings.image(0, _scene->sceneTexture->imageView, _scene->sceneTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(1, _scene->paletteBuffer->buffer, _scene->paletteBuffer->size, vk::DescriptorType::eUniformBuffer)
+        .image(2, _noise->imageView, _noise->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(4, engine->uniforms->buffer, sizeof(VolumeParameters), vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(5, engine->uniforms->buffer, sizeof(Light), vk::DescriptorType::eUniformBufferDynamic)
+        .image(6, _scene->skyboxTexture->imageView, _scene->skyboxTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(7, engine->uniforms->buffer, sizeof(CameraParameters), vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(8, _laneStatistics->buffer(flightFrame).buffer, sizeof(LaneCounters), vk::DescriptorType::eStorageBuffer)
+        .image(9, sunVisibility.imageView, sunVisibility.sampler, vk::ImageLayout::eGeneral)
+        .buffer(10, ambientCache.buffer, ambientCache.size, vk::DescriptorType::eStorageBuffer)
+        .image(11, _scene->occupancyTexture->imageView, _scene->occupancyTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(12, sampleMap.imageView, sampleMap.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(13, depthTiles.imageView, depthTiles.sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
     // Bind descriptor sets
-    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _pipeline->layout,
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline->layout,
         0, 1,
-        _pipeline->descriptorSet->getSet(flightFrame),
-        0, nullptr);
+        _pipeline->descriptorSet->getSet(bindings),
+        static_cast<uint32_t>(uniformOffsets.size()), uniformOffsets.data());
+    cmd.setStencilReference(vk::StencilFaceFlagBits::eFrontAndBack, checkerboard ? CHECKERBOARD_STENCIL_TRACED : 0);
+    // Pixels whose rays can't reach the volume only need the sky, and are moved off the reference so the tracer skips them
+    if (_settings->tracerSettings.tileClassification)
+    {
+        cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, _skyPipeline->pipeline);
+        cmd.draw(3, 1, 0, 0);
+    }
+    // Bind pipeline
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline->pipeline);
     cmd.draw(3, 1, 0, 0);
     // End color renderpass
     cmd.endRenderPass();
+}
 
-    cmdutil::imageMemoryBarrier(
-        cmd,
-        _colorTarget->image,
-        vk::AccessFlagBits::eColorAttachmentWrite,
-        vk::AccessFlagBits::eShaderRead,
-        vk::ImageLayout::eColorAttachmentOptimal,
-        vk::ImageLayout::eShaderReadOnlyOptimal,
-        vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        vk::PipelineStageFlagBits::eFragmentShader,
-        vk::ImageAspectFlagBits::eColor);
-
-    return {
-        std::cref(*_colorTarget),
-        std::cref(*_depthTarget),
-        std::cref(*_motionTarget),
-        std::cref(*_maskTarget),
-        std::cref(*_normalTarget),
-        std::cref(_positionTargets[flightFrame])
-    };
+const LaneStatistics& GeometryStage::laneStatistics() const
+{
+    return *_laneStatistics;
+}
+
+const SampleMapStatistics& GeometryStage::sampleMapStatistics() const
+{
+    return _sampleMapStage->statistics;
+}
+
+TracerVariant GeometryStage::currentVariant() const
+{
+    TracerVariant variant;
+    variant.maxRaySteps = static_cast<uint32_t>(_settings->tracerSettings.maxRaySteps);
+    variant.maxReflections = static_cast<uint32_t>(_settings->tracerSettings.maxReflections);
+    // Adaptive counts vary per pixel, so can't be specialized
+    variant.aoSamples = _sampleMapStage->adaptive() ? TRACER_AO_SAMPLES_DYNAMIC : static_cast<uint32_t>(_settings->occlusionSettings.numSamples);
+    variant.hasMetallic = _scene->hasMetallic;
+    return variant;
 }
 
+// Push constant ranges are identical across variants, so the generic layout is compatible with all of them
 const vk::PipelineLayout& GeometryStage::getPipelineLayout() const
 {
     return _pipeline->layout;
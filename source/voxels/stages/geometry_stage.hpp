@@ -6,15 +6,29 @@
 #include "voxels/voxel_render_stage.hpp"
 #include "util/resource_ring.hpp"
 #include "voxels/resource/parameters.hpp"
+#include "voxels/pipeline/voxel_sdf_pipeline.hpp"
+#include "engine/pipeline/pipeline_variant_cache.hpp"
 
 class RenderImage;
 class RenderPass;
 class Framebuffer;
 class VoxelScene;
 class Texture2D;
+class Texture3D;
 class Buffer;
 class VoxelRenderSettings;
-class VoxelSDFPipeline;
+class WavefrontStage;
+class SunVisibilityStage;
+class LaneStatistics;
+class AmbientCache;
+class SampleMapStage;
+class SecondaryRayStage;
+class DepthTileStage;
+class CheckerboardStage;
+class CheckerboardMaskPipeline;
+class SkyPipeline;
+struct SampleMapStatistics;
+struct ScreenQuadPush;
 
 struct GeometryBuffer
 {
@@ -23,34 +37,73 @@ struct GeometryBuffer
     std::reference_wrapper<const RenderImage> motion;
     std::reference_wrapper<const RenderImage> mask;
     std::reference_wrapper<const RenderImage> normal;
-    std::reference_wrapper<const RenderImage> position;
+    std::reference_wrapper<const RenderImage> previousDepth;
+    std::reference_wrapper<const RenderImage> previousNormal;
+    // Whether the previous depth and normal targets hold data from the last frame
+    bool historyValid;
 };
 
 class GeometryStage : public AVoxelRenderStage
 {
 private:
     std::shared_ptr<VoxelScene> _scene;
+    std::shared_ptr<Texture2D> _noise;
 
     VolumeParameters _parameters = {};
-    std::unique_ptr<Buffer> _parametersBuffer;
 
-    std::unique_ptr<RenderImage> _colorTarget;
-    std::unique_ptr<RenderImage> _depthTarget;
-    std::unique_ptr<RenderImage> _motionTarget;
-    std::unique_ptr<RenderImage> _maskTarget;
-    std::unique_ptr<RenderImage> _normalTarget;
-    ResourceRing<RenderImage> _positionTargets;
+    // Kept across frames for reprojection, so owned here rather than by the render graph
+    // Positions aren't stored, but reconstructed from depth, which holds the distance along each primary ray
+    ResourceRing<RenderImage> _depthTargets;
+    ResourceRing<RenderImage> _normalTargets;
+    // Marks the pixels traced by the fragment tracer under checkerboard rendering, and those already filled with the sky
+    ResourceRing<RenderImage> _stencilTargets;
+    bool _historyValid = false;
 
     std::unique_ptr<RenderPass> _renderPass;
 
     ResourceRing<Framebuffer> _framebuffers;
 
+    // Generic pipeline, used while the variant for the current settings is being built
     std::unique_ptr<VoxelSDFPipeline> _pipeline;
+    std::unique_ptr<PipelineVariantCache<TracerVariant, VoxelSDFPipeline, TracerVariantHash>> _variants;
+    std::unique_ptr<CheckerboardMaskPipeline> _maskPipeline;
+    // Fills pixels which can't reach the volume before the tracer, under tile classification
+    std::unique_ptr<SkyPipeline> _skyPipeline;
+
+    // Compute alternative to the fragment tracer, selected by the tracer settings
+    std::unique_ptr<WavefrontStage> _wavefrontStage;
+    // Shadows baked per voxel face, which both tracers look up
+    std::unique_ptr<SunVisibilityStage> _sunVisibilityStage;
+    // Ambient occlusion per voxel face, which both tracers share
+    std::unique_ptr<AmbientCache> _ambientCache;
+    // Per-pixel ambient sample counts, steered by the previous frame's noise
+    std::unique_ptr<SampleMapStage> _sampleMapStage;
+    // Bounds on where primary rays first hit, reprojected from the previous frame's depth or traced through coarse occupancy
+    std::unique_ptr<DepthTileStage> _depthTileStage;
+    // Shadows and ambient occlusion of primary hits, when traced below full resolution
+    std::unique_ptr<SecondaryRayStage> _secondaryRayStage;
+    // Fills in the pixels left out under checkerboard rendering
+    std::unique_ptr<CheckerboardStage> _checkerboardStage;
+    std::unique_ptr<LaneStatistics> _laneStatistics;
 
 public:
-    GeometryStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<VoxelScene>& scene, const std::shared_ptr<Texture2D>& noise);
+    GeometryStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph,
+                  const std::shared_ptr<VoxelScene>& scene, const std::shared_ptr<Texture2D>& noise);
+
+    // Previous moments are the temporal stage's, or null without temporal accumulation.
+    GeometryBuffer record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const CameraParameters& camera, const ScreenQuadPush& screen,
+                          const RenderImage* previousMoments, bool momentsValid);
+
+    const LaneStatistics& laneStatistics() const;
+    const SampleMapStatistics& sampleMapStatistics() const;
 
-    GeometryBuffer record(const vk::CommandBuffer& cmd, uint32_t flightFrame);
+    // The specialization constants matching the current settings and scene
+    TracerVariant currentVariant() const;
 
     const vk::PipelineLayout& getPipelineLayout() const;
+
+private:
+    // Traces the G-buffer with the fragment tracer, within the graph's geometry pass
+    void recordFragment(const vk::CommandBuffer& cmd, uint32_t flightFrame, const VolumeUniformOffsets& uniformOffsets,
+                        const Texture3D& sunVisibility, const Buffer& ambientCache, const RenderImage& sampleMap, const RenderImage& depthTiles);
 };
@@ -0,0 +1,111 @@
+#include "sample_map_stage.hpp"
+
+#include <algorithm>
+#include "engine/engine.hpp"
+#include "engine/resource/buffer.hpp"
+#include "engine/resource/render_image.hpp"
+#include "engine/commands/command_util.hpp"
+#include "engine/graph/render_graph.hpp"
+#include "voxels/voxel_render_settings.hpp"
+#include "voxels/pipeline/sample_map_pipeline.hpp"
+#include "voxels/resource/parameters.hpp"
+
+SampleMapStage::SampleMapStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph)
+    : AVoxelRenderStage(engine, settings, graph)
+{
+    _counters = ResourceRing<Buffer>::fromFunc(MAX_FRAMES_IN_FLIGHT, [&](uint32_t i) {
+        return Buffer(engine, sizeof(SampleMapCounters), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                      VMA_MEMORY_USAGE_GPU_TO_CPU, fmt::format("Sample Map Counters {}", i));
+    });
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _counters.destroy([&](const Buffer& buffer) {
+            buffer.destroy();
+        });
+    });
+    _written = std::vector<bool>(MAX_FRAMES_IN_FLIGHT, false);
+    _budgets = std::vector<uint32_t>(MAX_FRAMES_IN_FLIGHT, 0);
+
+    _pipeline = std::make_unique<SampleMapPipeline>(SampleMapPipeline::build(engine));
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _pipeline->destroy();
+    });
+}
+
+bool SampleMapStage::adaptive() const
+{
+    return _settings->occlusionSettings.adaptive && _settings->adaptiveSamplesUnavailable() == nullptr;
+}
+
+bool SampleMapStage::record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const ScreenQuadPush& screen,
+                            const RenderImage& previousDepth, const RenderImage* previousMoments, bool historyValid)
+{
+    // The fence for this flight frame has already been waited on, so its counters are final
+    if (_written[flightFrame])
+    {
+        SampleMapCounters counters = {};
+        _counters[flightFrame].readData(&counters, sizeof(SampleMapCounters));
+        statistics.uniformRaysPerFrame = counters.pixels * _budgets[flightFrame];
+        statistics.raysPerFrame = counters.samples > 0 ? counters.samples : statistics.uniformRaysPerFrame;
+        statistics.meanNoise = counters.pixels > 0 ? static_cast<float>(counters.noiseSum) / (SAMPLE_MAP_FIXED_POINT * static_cast<float>(counters.pixels)) : 0.0f;
+        statistics.valid = true;
+        _written[flightFrame] = false;
+    }
+
+    const AmbientOcclusionSettings& occlusion = _settings->occlusionSettings;
+    if (previousMoments == nullptr || !historyValid || occlusion.mode != AmbientOcclusionMode::RAYS || occlusion.numSamples <= 0)
+    {
+        statistics.valid = false;
+        return false;
+    }
+
+    _graph->bindExternal("Previous Temporal Moments", *previousMoments);
+    _graph->beginPass(cmd, "Sample Map");
+
+    const Buffer& counters = _counters[flightFrame];
+    cmd.fillBuffer(counters.buffer, 0, sizeof(SampleMapCounters), 0);
+    cmdutil::memoryBarrier(
+        cmd,
+        vk::AccessFlagBits::eTransferWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eComputeShader);
+
+    const RenderImage& sampleMap = _graph->image("Sample Map");
+    DescriptorBindings bindings;
+    bindings.image(0, previousMoments->imageView, previousMoments->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(1, previousDepth.imageView, previousDepth.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(2, counters.buffer, sizeof(SampleMapCounters), vk::DescriptorType::eStorageBuffer)
+        .storageImage(3, sampleMap.imageView);
+
+    SampleMapPush push;
+    push.screen = screen;
+    push.budget = static_cast<uint32_t>(occlusion.numSamples);
+    push.maxSamples = static_cast<uint32_t>(std::clamp(std::max(occlusion.maxAdaptiveSamples, occlusion.numSamples), 1, SAMPLE_MAP_MAX_SAMPLES));
+    push.reduce = 1;
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _pipeline->pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _pipeline->layout,
+        0, 1,
+        _pipeline->descriptorSet->getSet(bindings),
+        0, nullptr);
+    cmd.pushConstants(_pipeline->layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(SampleMapPush), &push);
+    glm::uvec2 groups = (glm::uvec2(screen.screenSize) + glm::uvec2(SAMPLE_MAP_GROUP_SIZE - 1)) / glm::uvec2(SAMPLE_MAP_GROUP_SIZE);
+    cmd.dispatch(groups.x, groups.y, 1);
+
+    _written[flightFrame] = true;
+    _budgets[flightFrame] = push.budget;
+    if (!adaptive())
+        return false;
+
+    // Shares are only known once every pixel's weight is totalled
+    cmdutil::memoryBarrier(
+        cmd,
+        vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eComputeShader);
+    push.reduce = 0;
+    cmd.pushConstants(_pipeline->layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(SampleMapPush), &push);
+    cmd.dispatch(groups.x, groups.y, 1);
+    return true;
+}
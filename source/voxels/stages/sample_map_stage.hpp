@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "util/resource_ring.hpp"
+#include "voxels/voxel_render_stage.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+class Buffer;
+class RenderImage;
+class SampleMapPipeline;
+
+// Must match the local size of sample_map.comp
+#define SAMPLE_MAP_GROUP_SIZE 8
+// Most samples a pixel can be given, as the map stores counts as unorm bytes
+#define SAMPLE_MAP_MAX_SAMPLES 255
+
+// Ambient sampling of the pixels which saw geometry, read back one flight frame later
+struct SampleMapStatistics
+{
+    bool valid = false;
+    // Ambient rays allocated per frame, and what uniform sampling would cast
+    uint32_t raysPerFrame = 0;
+    uint32_t uniformRaysPerFrame = 0;
+    // Mean standard deviation of luminance, relative to its mean
+    float meanNoise = 0.0f;
+};
+
+// Builds a per-pixel ambient sample count map before tracing, from the noise in the previous frame's temporal moments.
+// The frame's budget of numSamples per surface pixel is kept, with each pixel taking at least one sample and the rest following the noise.
+// Noise is measured whenever temporal accumulation runs, so uniform and adaptive sampling can be compared.
+class SampleMapStage : public AVoxelRenderStage
+{
+public:
+    SampleMapStatistics statistics;
+
+private:
+    ResourceRing<Buffer> _counters;
+    std::vector<bool> _written;
+    // Budget each flight frame's counters were gathered with
+    std::vector<uint32_t> _budgets;
+
+    std::unique_ptr<SampleMapPipeline> _pipeline;
+
+public:
+    SampleMapStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph);
+
+    // Whether the settings ask for the tracers to read the map
+    bool adaptive() const;
+
+    // Measures the previous frame's noise, and builds the map if adaptive.
+    // Moments are null without temporal accumulation, in which case nothing is recorded.
+    // Returns whether the map was written, and so may be read by the tracers this frame.
+    bool record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const ScreenQuadPush& screen,
+                const RenderImage& previousDepth, const RenderImage* previousMoments, bool historyValid);
+};
@@ -0,0 +1,129 @@
+#include "secondary_ray_stage.hpp"
+
+#include "engine/engine.hpp"
+#include "engine/resource/buffer.hpp"
+#include "engine/resource/render_image.hpp"
+#include "engine/resource/texture_2d.hpp"
+#include "engine/resource/texture_3d.hpp"
+#include "engine/commands/command_util.hpp"
+#include "engine/graph/render_graph.hpp"
+#include "voxels/pipeline/secondary_ray_pipeline.hpp"
+#include "voxels/resource/voxel_scene.hpp"
+#include "voxels/stages/geometry_stage.hpp"
+#include "voxels/voxel_render_settings.hpp"
+
+SecondaryRayStage::SecondaryRayStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph,
+                                     const std::shared_ptr<VoxelScene>& scene, const std::shared_ptr<Texture2D>& noise) : AVoxelRenderStage(engine, settings, graph), _scene(scene), _noise(noise)
+{
+    vk::ShaderStageFlags stage = vk::ShaderStageFlagBits::eCompute;
+    DescriptorSet localDescriptorSet = DescriptorSetBuilder(engine)
+        .image(0, stage)
+        .buffer(1, stage, vk::DescriptorType::eUniformBuffer)
+        .image(2, stage)
+        .buffer(4, stage, vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(5, stage, vk::DescriptorType::eUniformBufferDynamic)
+        .image(6, stage)
+        .buffer(7, stage, vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(8, stage, vk::DescriptorType::eStorageBuffer)
+        .image(9, stage)
+        .buffer(10, stage, vk::DescriptorType::eStorageBuffer)
+        .image(11, stage)
+        .storageImage(12, stage)
+        .image(13, stage)
+        .image(14, stage)
+        .storageImage(15, stage)
+        .storageImage(16, stage)
+        .build("Secondary Ray Descriptor Set");
+    _descriptorSet = localDescriptorSet;
+    pushDeletor([=](const std::shared_ptr<Engine>&) {
+        localDescriptorSet.destroy();
+    });
+
+    vk::DescriptorSetLayout setLayout = _descriptorSet->layout;
+    _tracePipeline = std::make_unique<SecondaryRayPipeline>(SecondaryRayPipeline::build(engine, "../shader/secondary_trace.comp.spv", setLayout));
+    _upsamplePipeline = std::make_unique<SecondaryRayPipeline>(SecondaryRayPipeline::build(engine, "../shader/secondary_upsample.comp.spv", setLayout));
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _tracePipeline->destroy();
+        _upsamplePipeline->destroy();
+    });
+}
+
+uint32_t SecondaryRayStage::deferred() const
+{
+    uint32_t effects = 0;
+    if (_settings->lightSettings.shadowResolution != SecondaryResolution::FULL)
+        effects |= SECONDARY_DEFER_SHADOW;
+    if (_settings->occlusionSettings.resolution != SecondaryResolution::FULL)
+        effects |= SECONDARY_DEFER_AMBIENT;
+    return effects;
+}
+
+void SecondaryRayStage::record(const vk::CommandBuffer& cmd, const GeometryBuffer& gBuffer, const ScreenQuadPush& screen,
+                               const VolumeUniformOffsets& uniforms, const Buffer& laneStats, const Texture3D& sunVisibility, const Buffer& ambientCache)
+{
+    uint32_t effects = deferred();
+    if (effects == 0)
+        return;
+
+    // The tracers' cache updates and lane counts must land before these kernels add to them
+    cmdutil::memoryBarrier(
+        cmd,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eComputeShader);
+
+    const RenderImage& color = gBuffer.color;
+    const RenderImage& depth = gBuffer.depth;
+    const RenderImage& normal = gBuffer.normal;
+    const RenderImage& shadow = _graph->image("Secondary Shadow");
+    const RenderImage& ambient = _graph->image("Secondary Ambient");
+    DescriptorBindings bindings;
+    bindings.image(0, _scene->sceneTexture->imageView, _scene->sceneTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(1, _scene->paletteBuffer->buffer, _scene->paletteBuffer->size, vk::DescriptorType::eUniformBuffer)
+        .image(2, _noise->imageView, _noise->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(4, engine->uniforms->buffer, sizeof(VolumeParameters), vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(5, engine->uniforms->buffer, sizeof(Light), vk::DescriptorType::eUniformBufferDynamic)
+        .image(6, _scene->skyboxTexture->imageView, _scene->skyboxTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(7, engine->uniforms->buffer, sizeof(CameraParameters), vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(8, laneStats.buffer, laneStats.size, vk::DescriptorType::eStorageBuffer)
+        .image(9, sunVisibility.imageView, sunVisibility.sampler, vk::ImageLayout::eGeneral)
+        .buffer(10, ambientCache.buffer, ambientCache.size, vk::DescriptorType::eStorageBuffer)
+        .image(11, _scene->occupancyTexture->imageView, _scene->occupancyTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .storageImage(12, color.imageView)
+        .image(13, depth.imageView, depth.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(14, normal.imageView, normal.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .storageImage(15, shadow.imageView)
+        .storageImage(16, ambient.imageView);
+
+    SecondaryRayPush push;
+    push.screen = screen;
+    push.shadowScale = static_cast<uint32_t>(_settings->lightSettings.shadowResolution);
+    push.ambientScale = static_cast<uint32_t>(_settings->occlusionSettings.resolution);
+
+    // Both kernels share the same layout, so the set only needs binding once
+    _graph->beginPass(cmd, "Secondary Rays");
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _tracePipeline->pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _tracePipeline->layout,
+        0, 1,
+        _descriptorSet->getSet(bindings),
+        static_cast<uint32_t>(uniforms.size()), uniforms.data());
+    for (uint32_t effect : { SECONDARY_DEFER_SHADOW, SECONDARY_DEFER_AMBIENT })
+    {
+        if ((effects & effect) == 0)
+            continue;
+
+        // One invocation per reduced texel
+        uint32_t scale = effect == SECONDARY_DEFER_SHADOW ? push.shadowScale : push.ambientScale;
+        glm::uvec2 reduced = (glm::uvec2(screen.screenSize) + scale - 1u) / scale;
+        glm::uvec2 groups = (reduced + SECONDARY_RAY_GROUP_SIZE - 1u) / static_cast<uint32_t>(SECONDARY_RAY_GROUP_SIZE);
+        push.effect = effect;
+        cmd.pushConstants(_tracePipeline->layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(SecondaryRayPush), &push);
+        cmd.dispatch(groups.x, groups.y, 1);
+    }
+
+    _graph->beginPass(cmd, "Secondary Upsample");
+    glm::uvec2 groups = (glm::uvec2(screen.screenSize) + SECONDARY_RAY_GROUP_SIZE - 1u) / static_cast<uint32_t>(SECONDARY_RAY_GROUP_SIZE);
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _upsamplePipeline->pipeline);
+    cmd.dispatch(groups.x, groups.y, 1);
+}
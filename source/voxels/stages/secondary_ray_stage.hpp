@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vulkan/vulkan.hpp>
+#include "engine/pipeline/descriptor_set.hpp"
+#include "voxels/voxel_render_stage.hpp"
+#include "voxels/resource/parameters.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+class Buffer;
+class VoxelScene;
+class Texture2D;
+class Texture3D;
+class SecondaryRayPipeline;
+struct GeometryBuffer;
+
+// Must match the local sizes of secondary_trace.comp and secondary_upsample.comp
+#define SECONDARY_RAY_GROUP_SIZE 8
+
+// Traces shadow and ambient rays for primary hits below full resolution, after the tracers have left them out,
+// then adds them to the color target with a joint bilateral upsample guided by the G-buffer's depth and normals.
+// Reflections and their bounces are still shaded by the tracers at full resolution.
+class SecondaryRayStage : public AVoxelRenderStage
+{
+private:
+    std::shared_ptr<VoxelScene> _scene;
+    std::shared_ptr<Texture2D> _noise;
+
+    std::optional<DescriptorSet> _descriptorSet;
+    std::unique_ptr<SecondaryRayPipeline> _tracePipeline;
+    std::unique_ptr<SecondaryRayPipeline> _upsamplePipeline;
+
+public:
+    SecondaryRayStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph,
+                      const std::shared_ptr<VoxelScene>& scene, const std::shared_ptr<Texture2D>& noise);
+
+    // Effects the settings trace below full resolution, as SECONDARY_DEFER bits for the tracers to leave out
+    uint32_t deferred() const;
+
+    // Traces the deferred effects and adds them to the G-buffer's color, after the geometry pass.
+    void record(const vk::CommandBuffer& cmd, const GeometryBuffer& gBuffer, const ScreenQuadPush& screen,
+                const VolumeUniformOffsets& uniforms, const Buffer& laneStats, const Texture3D& sunVisibility, const Buffer& ambientCache);
+};
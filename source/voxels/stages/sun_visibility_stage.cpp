@@ -0,0 +1,123 @@
+#include "sun_visibility_stage.hpp"
+
+#include <algorithm>
+#include "engine/engine.hpp"
+#include "engine/resource/buffer.hpp"
+#include "engine/commands/command_util.hpp"
+#include "voxels/pipeline/sun_visibility_pipeline.hpp"
+#include "voxels/resource/voxel_scene.hpp"
+#include "voxels/resource/parameters.hpp"
+
+SunVisibilityStage::SunVisibilityStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph,
+                                       const std::shared_ptr<VoxelScene>& scene) : AVoxelRenderStage(engine, settings, graph), _scene(scene)
+{
+    _volume = Texture3D(engine, scene->width, scene->height, scene->depth, vk::Format::eR8G8B8A8Unorm,
+                        vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst);
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _volume->destroy();
+    });
+
+    _pipeline = std::make_unique<SunVisibilityPipeline>(SunVisibilityPipeline::build(engine));
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _pipeline->destroy();
+    });
+}
+
+void SunVisibilityStage::clear(const vk::CommandBuffer& cmd)
+{
+    // Earlier frames' tracers and bakes may still be using the volume
+    cmdutil::memoryBarrier(
+        cmd,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eTransferWrite,
+        vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eTransfer);
+
+    vk::ImageSubresourceRange range;
+    range.aspectMask = vk::ImageAspectFlagBits::eColor;
+    range.baseMipLevel = 0;
+    range.levelCount = 1;
+    range.baseArrayLayer = 0;
+    range.layerCount = 1;
+    cmd.clearColorImage(_volume->image, vk::ImageLayout::eGeneral, vk::ClearColorValue(std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f }), range);
+
+    cmdutil::memoryBarrier(
+        cmd,
+        vk::AccessFlagBits::eTransferWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader);
+}
+
+void SunVisibilityStage::record(const vk::CommandBuffer& cmd, const ScreenQuadPush& screen, const Buffer& laneStats)
+{
+    if (!_volumeInitialized)
+    {
+        cmdutil::imageMemoryBarrier(
+            cmd,
+            _volume->image,
+            vk::AccessFlagBits::eNone,
+            vk::AccessFlagBits::eTransferWrite,
+            vk::ImageLayout::eUndefined,
+            vk::ImageLayout::eGeneral,
+            vk::PipelineStageFlagBits::eTopOfPipe,
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::ImageAspectFlagBits::eColor);
+        _volumeInitialized = true;
+        _bakedDirection.reset();
+        clear(cmd);
+    }
+
+    // Any change of the light invalidates everything baked so far, leaving the tracers to cast rays until it's rebaked
+    std::optional<glm::vec3> direction;
+    if (_settings->lightSettings.bakedVisibility)
+        direction = _settings->lightSettings.direction;
+    // The GUI renormalizes the direction every frame, so only count changes beyond rounding
+    bool changed = direction.has_value() != _bakedDirection.has_value()
+        || (direction.has_value() && glm::length(*direction - *_bakedDirection) > 1e-5f);
+    if (changed)
+    {
+        if (_bakedDirection.has_value())
+            clear(cmd);
+        _bakedDirection = direction;
+        _nextSlice = 0;
+    }
+
+    if (!_bakedDirection.has_value() || _nextSlice >= _scene->depth)
+        return;
+
+    SunVisibilityPush push;
+    push.screen = screen;
+    push.lightDirection = glm::vec4(*_bakedDirection, 0.0f);
+    push.sliceBegin = _nextSlice;
+    push.sliceEnd = std::min(_nextSlice + static_cast<uint32_t>(std::max(_settings->lightSettings.bakeSlicesPerFrame, 1)), _scene->depth);
+    _nextSlice = push.sliceEnd;
+
+    DescriptorBindings bindings;
+    bindings.image(0, _scene->sceneTexture->imageView, _scene->sceneTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(8, laneStats.buffer, sizeof(LaneCounters), vk::DescriptorType::eStorageBuffer)
+        .storageImage(9, _volume->imageView);
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _pipeline->pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _pipeline->layout,
+        0, 1,
+        _pipeline->descriptorSet->getSet(bindings),
+        0, nullptr);
+    cmd.pushConstants(_pipeline->layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(SunVisibilityPush), &push);
+    cmd.dispatch((_scene->width + SUN_VISIBILITY_GROUP_SIZE - 1) / SUN_VISIBILITY_GROUP_SIZE,
+                 (_scene->height + SUN_VISIBILITY_GROUP_SIZE - 1) / SUN_VISIBILITY_GROUP_SIZE,
+                 push.sliceEnd - push.sliceBegin);
+
+    // This frame's tracers already read the new slices
+    cmdutil::memoryBarrier(
+        cmd,
+        vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eShaderRead,
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader);
+}
+
+const Texture3D& SunVisibilityStage::volume() const
+{
+    return *_volume;
+}
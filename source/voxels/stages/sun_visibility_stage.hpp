@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+#include "voxels/voxel_render_stage.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+#include "engine/resource/texture_3d.hpp"
+
+class Buffer;
+class VoxelScene;
+class SunVisibilityPipeline;
+
+// Must match the local size of sun_visibility.comp
+#define SUN_VISIBILITY_GROUP_SIZE 8
+
+// Caches the visibility of the directional light from every voxel face, so the tracers look shadows up rather than tracing them.
+// The volume is cleared whenever the light moves, and rebaked a batch of slices per frame,
+// with the tracers casting shadow rays from voxels which haven't been baked yet.
+class SunVisibilityStage : public AVoxelRenderStage
+{
+private:
+    std::shared_ptr<VoxelScene> _scene;
+
+    // Visibility of each voxel's face towards the light along each axis, with alpha set once baked
+    std::optional<Texture3D> _volume;
+    bool _volumeInitialized = false;
+    // Light direction the volume holds, or is being baked for, if baking is enabled
+    std::optional<glm::vec3> _bakedDirection;
+    uint32_t _nextSlice = 0;
+
+    std::unique_ptr<SunVisibilityPipeline> _pipeline;
+
+public:
+    SunVisibilityStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph,
+                       const std::shared_ptr<VoxelScene>& scene);
+
+    // Bakes the next batch of slices, before the tracers read the volume.
+    void record(const vk::CommandBuffer& cmd, const ScreenQuadPush& screen, const Buffer& laneStats);
+
+    // Kept in the general layout, as it's both written and sampled
+    const Texture3D& volume() const;
+
+private:
+    void clear(const vk::CommandBuffer& cmd);
+};
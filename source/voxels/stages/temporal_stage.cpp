@@ -0,0 +1,145 @@
+#include "temporal_stage.hpp"
+
+#include "engine/resource/buffer.hpp"
+#include "engine/pipeline/descriptor_set.hpp"
+#include "engine/pipeline/render_pass.hpp"
+#include "engine/pipeline/framebuffer.hpp"
+#include "engine/resource/render_image.hpp"
+#include "engine/engine.hpp"
+#include "engine/graph/render_graph.hpp"
+#include "voxels/pipeline/temporal_pipeline.hpp"
+#include "voxels/stages/geometry_stage.hpp"
+
+TemporalStage::TemporalStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph)
+    : AVoxelRenderStage(engine, settings, graph)
+{
+    engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE, [&]() {
+        _historyTargets = ResourceRing<RenderImage>::fromFunc(2, [&](uint32_t i) {
+            return RenderImage(engine, _settings->maxRenderResolution().x, _settings->maxRenderResolution().y, vk::Format::eR16G16B16A16Sfloat,
+                               vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor, fmt::format("Temporal History Target {}", i));
+        });
+        _momentsTargets = ResourceRing<RenderImage>::fromFunc(2, [&](uint32_t i) {
+            return RenderImage(engine, _settings->maxRenderResolution().x, _settings->maxRenderResolution().y, vk::Format::eR16G16B16A16Sfloat,
+                               vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor, fmt::format("Temporal Moments Target {}", i));
+        });
+        _historyValid = false;
+
+        return [=](const std::shared_ptr<Engine>&) {
+            _historyTargets.destroy([&](const RenderImage& image) {
+                _graph->forgetExternal(image);
+                image.destroy();
+            });
+            _momentsTargets.destroy([&](const RenderImage& image) {
+                _graph->forgetExternal(image);
+                image.destroy();
+            });
+        };
+    });
+
+    engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE, [&]() {
+        _renderPass = RenderPassBuilder(engine)
+            .color(0, _historyTargets[0].format, glm::vec4(0.0f))
+            .color(1, _momentsTargets[0].format, glm::vec4(0.0f))
+            .buildUnique("Temporal Render Pass");
+
+        return [=](const std::shared_ptr<Engine>&) {
+            _renderPass->destroy();
+        };
+    });
+
+    engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE, [&]() {
+        _framebuffers = ResourceRing<Framebuffer>::fromFunc(2, [&](uint32_t n) {
+            return FramebufferBuilder(engine, _renderPass->renderPass, _settings->maxRenderResolution())
+                .color(_historyTargets[n].imageView)
+                .color(_momentsTargets[n].imageView)
+                .build("Temporal Framebuffer");
+        });
+
+        return [=](const std::shared_ptr<Engine>&) {
+            _framebuffers.destroy([&](const Framebuffer& framebuffer) {
+                framebuffer.destroy();
+            });
+        };
+    });
+
+    _pipeline = std::make_unique<TemporalPipeline>(TemporalPipeline::build(engine, _renderPass->renderPass));
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _pipeline->destroy();
+    });
+}
+
+void TemporalStage::resetHistory()
+{
+    _historyValid = false;
+}
+
+const RenderImage& TemporalStage::record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const GeometryBuffer& gBuffer, const ScreenQuadPush& screen)
+{
+    uint32_t altFrame = (flightFrame + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT;
+    bool historyValid = _historyValid && gBuffer.historyValid;
+
+    _graph->bindExternal("Temporal History", _historyTargets[flightFrame]);
+    _graph->bindExternal("Previous Temporal History", _historyTargets[altFrame]);
+    _graph->bindExternal("Temporal Moments", _momentsTargets[flightFrame]);
+    _graph->bindExternal("Previous Temporal Moments", _momentsTargets[altFrame]);
+
+    _parameters.blendFactor = _settings->temporalSettings.blendFactor;
+    _parameters.positionThreshold = _settings->temporalSettings.positionThreshold;
+    _parameters.normalThreshold = _settings->temporalSettings.normalThreshold;
+    _parameters.reset = historyValid ? 0 : 1;
+    const ScreenQuadPush& prevScreen = historyValid ? _prevScreen : screen;
+    _parameters.prevScreenSize = prevScreen.screenSize;
+    _parameters.prevCameraJitter = prevScreen.cameraJitter;
+    _parameters.prevCamPos = prevScreen.camPos;
+    _parameters.prevCamDir = prevScreen.camDir;
+    _parameters.prevCamRight = prevScreen.camRight;
+    _parameters.prevCamUp = prevScreen.camUp;
+    _prevScreen = screen;
+    uint32_t parametersOffset = engine->uniforms->push(_parameters);
+
+    const RenderImage& color = gBuffer.color;
+    const RenderImage& depth = gBuffer.depth;
+    const RenderImage& normal = gBuffer.normal;
+    const RenderImage& previousDepth = gBuffer.previousDepth;
+    const RenderImage& previousNormal = gBuffer.previousNormal;
+    const RenderImage& motion = gBuffer.motion;
+    DescriptorBindings bindings;
+    bindings.image(0, color.imageView, color.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(1, depth.imageView, depth.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(2, normal.imageView, normal.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(3, _historyTargets[altFrame].imageView, _historyTargets[altFrame].sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(4, previousDepth.imageView, previousDepth.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(5, previousNormal.imageView, previousNormal.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(6, engine->uniforms->buffer, sizeof(TemporalParameters), vk::DescriptorType::eUniformBufferDynamic)
+        .image(7, motion.imageView, motion.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(8, _momentsTargets[altFrame].imageView, _momentsTargets[altFrame].sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    _graph->beginPass(cmd, "Temporal");
+    _renderPass->recordBegin(cmd, _framebuffers[flightFrame]);
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, _pipeline->pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _pipeline->layout,
+        0, 1,
+        _pipeline->descriptorSet->getSet(bindings),
+        1, &parametersOffset);
+    cmd.draw(3, 1, 0, 0);
+    cmd.endRenderPass();
+
+    _historyValid = true;
+
+    return _historyTargets[flightFrame];
+}
+
+const RenderImage& TemporalStage::moments(uint32_t flightFrame) const
+{
+    return _momentsTargets[flightFrame];
+}
+
+const RenderImage& TemporalStage::previousMoments(uint32_t flightFrame) const
+{
+    return _momentsTargets[(flightFrame + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT];
+}
+
+bool TemporalStage::historyValid() const
+{
+    return _historyValid;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+#include "util/resource_ring.hpp"
+#include "voxels/voxel_render_stage.hpp"
+#include "voxels/resource/parameters.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+
+class VoxelRenderSettings;
+class TemporalPipeline;
+class RenderImage;
+class RenderPass;
+class Framebuffer;
+struct GeometryBuffer;
+
+// Accumulates lighting over time by reprojecting the previous frame's result along the G-buffer's motion vectors.
+// History is rejected wherever the reprojected position or normal disagrees with the current frame,
+// with positions reconstructed from each frame's depth and camera.
+// Luminance moments are accumulated alongside the color, giving the denoiser a per-pixel variance estimate.
+class TemporalStage : public AVoxelRenderStage
+{
+private:
+    TemporalParameters _parameters = {};
+
+    // Accumulated color for each frame, with history length stored in alpha
+    ResourceRing<RenderImage> _historyTargets;
+    // Accumulated luminance moments for each frame, and the variance derived from them
+    ResourceRing<RenderImage> _momentsTargets;
+    std::unique_ptr<RenderPass> _renderPass;
+    ResourceRing<Framebuffer> _framebuffers;
+
+    std::unique_ptr<TemporalPipeline> _pipeline;
+
+    bool _historyValid = false;
+    // Screen constants the history was rendered with
+    ScreenQuadPush _prevScreen = {};
+
+public:
+    TemporalStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph);
+
+    // Discards accumulated history, e.g. after the scene changes.
+    void resetHistory();
+
+    const RenderImage& record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const GeometryBuffer& gBuffer, const ScreenQuadPush& screen);
+
+    // Luminance moments written by the last recorded frame, with the variance of the accumulated color in z.
+    const RenderImage& moments(uint32_t flightFrame) const;
+    // Moments written by the frame before, which are only meaningful while the history is valid.
+    const RenderImage& previousMoments(uint32_t flightFrame) const;
+    bool historyValid() const;
+};
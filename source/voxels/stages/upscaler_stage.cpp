@@ -1,57 +1,111 @@
 #include "upscaler_stage.hpp"
 
+#include <cmath>
+#ifdef VOXELS_ENABLE_FSR2
 #include <vk/ffx_fsr2_vk.h>
+#endif
 #include "engine/engine.hpp"
 #include "engine/resource/render_image.hpp"
-#include "engine/commands/command_util.hpp"
+#include "engine/graph/render_graph.hpp"
+#include "voxels/pipeline/temporal_upscaler_pipeline.hpp"
+#include "voxels/stages/geometry_stage.hpp"
 
-UpscalerStage::UpscalerStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings) : AVoxelRenderStage(engine, settings)
+// Element of the Halton low-discrepancy sequence in the given base, from 0 to 1
+static float halton(int32_t index, int32_t base)
 {
+    float fraction = 1.0f;
+    float result = 0.0f;
+    while (index > 0)
+    {
+        fraction /= static_cast<float>(base);
+        result += fraction * static_cast<float>(index % base);
+        index /= base;
+    }
+    return result;
+}
+
+UpscalerStage::UpscalerStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph)
+    : AVoxelRenderStage(engine, settings, graph)
+{
+    vk::ShaderStageFlags stage = vk::ShaderStageFlagBits::eCompute;
+    DescriptorSet localDescriptorSet = DescriptorSetBuilder(engine)
+        .image(0, stage)
+        .image(1, stage)
+        .image(2, stage)
+        .image(3, stage)
+        .storageImage(4, stage)
+        .storageImage(5, stage)
+        .build("Temporal Upscaler Descriptor Set");
+    _descriptorSet = localDescriptorSet;
+    pushDeletor([=](const std::shared_ptr<Engine>&) {
+        localDescriptorSet.destroy();
+    });
+
+    vk::DescriptorSetLayout setLayout = _descriptorSet->layout;
+    _accumulatePipeline = std::make_unique<TemporalUpscalerPipeline>(TemporalUpscalerPipeline::build(engine, "../shader/temporal_upscale.comp.spv", setLayout));
+    _sharpenPipeline = std::make_unique<TemporalUpscalerPipeline>(TemporalUpscalerPipeline::build(engine, "../shader/temporal_sharpen.comp.spv", setLayout));
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _accumulatePipeline->destroy();
+        _sharpenPipeline->destroy();
+    });
+
+    // Only the selected backend's resources are created, as both are sized for the target resolution
     engine->recreationQueue->push(RecreationEventFlags::TARGET_RESIZE, [&]() {
-        _fsrInterface = static_cast<FfxFsr2Interface*>(malloc(sizeof(FfxFsr2Interface)));
-        _fsrContext = static_cast<FfxFsr2Context*>(malloc(sizeof(FfxFsr2Context)));
-
-        // Allocate scratch buffer
-        size_t memorySize = ffxFsr2GetScratchMemorySizeVK(engine->physicalDevice);
-        _fsrScratchBuffer = malloc(memorySize);
-
-        // Get Vulkan interface for FSR
-        FfxErrorCode errorCode = ffxFsr2GetInterfaceVK(_fsrInterface, _fsrScratchBuffer, memorySize, engine->physicalDevice, engine->getDeviceProcAddr);
-        FFX_ASSERT(errorCode == FFX_OK);
-
-        // Create FSR context
-        FfxFsr2ContextDescription contextDesc = {};
-        contextDesc.flags = 0;
-        contextDesc.maxRenderSize = { settings->targetResolution.x, settings->targetResolution.y };
-        contextDesc.displaySize = { settings->targetResolution.x, settings->targetResolution.y };
-        contextDesc.device = engine->device;
-        contextDesc.callbacks = *_fsrInterface;
-        contextDesc.flags = FFX_FSR2_ENABLE_DEPTH_INVERTED | FFX_FSR2_ENABLE_DEPTH_INFINITE;
-        errorCode = ffxFsr2ContextCreate(_fsrContext, &contextDesc);
-        FFX_ASSERT(errorCode == FFX_OK);
-
-        // Queue deletors
+        _historyValid = false;
+        if (_settings->fsrSetttings.backend == UpscalerBackend::TEMPORAL)
+        {
+            _historyTargets = ResourceRing<RenderImage>::fromFunc(2, [&](uint32_t i) {
+                return RenderImage(engine, _settings->targetResolution.x, _settings->targetResolution.y, vk::Format::eR16G16B16A16Sfloat,
+                                   vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor, fmt::format("Upscaler History Target {}", i));
+            });
+        }
+
+#ifdef VOXELS_ENABLE_FSR2
+        if (_settings->fsrSetttings.backend == UpscalerBackend::FSR2)
+        {
+            _fsrInterface = static_cast<FfxFsr2Interface*>(malloc(sizeof(FfxFsr2Interface)));
+            _fsrContext = static_cast<FfxFsr2Context*>(malloc(sizeof(FfxFsr2Context)));
+
+            // Allocate scratch buffer
+            size_t memorySize = ffxFsr2GetScratchMemorySizeVK(engine->physicalDevice);
+            _fsrScratchBuffer = malloc(memorySize);
+
+            // Get Vulkan interface for FSR
+            FfxErrorCode errorCode = ffxFsr2GetInterfaceVK(_fsrInterface, _fsrScratchBuffer, memorySize, engine->physicalDevice, engine->getDeviceProcAddr);
+            FFX_ASSERT(errorCode == FFX_OK);
+
+            // Create FSR context
+            FfxFsr2ContextDescription contextDesc = {};
+            contextDesc.flags = 0;
+            contextDesc.maxRenderSize = { _settings->targetResolution.x, _settings->targetResolution.y };
+            contextDesc.displaySize = { _settings->targetResolution.x, _settings->targetResolution.y };
+            contextDesc.device = engine->device;
+            contextDesc.callbacks = *_fsrInterface;
+            contextDesc.flags = FFX_FSR2_ENABLE_DEPTH_INVERTED | FFX_FSR2_ENABLE_DEPTH_INFINITE;
+            errorCode = ffxFsr2ContextCreate(_fsrContext, &contextDesc);
+            FFX_ASSERT(errorCode == FFX_OK);
+        }
         FfxFsr2Interface* localFsrInterface = _fsrInterface;
         FfxFsr2Context* localFsrContext = _fsrContext;
         void* localScratchBuffer = _fsrScratchBuffer;
-        pushDeletor([=](const std::shared_ptr<Engine>&) {
-            ffxFsr2ContextDestroy(localFsrContext);
+#endif
+
+        return [=](const std::shared_ptr<Engine>&) {
+            _historyTargets.destroy([&](const RenderImage& image) {
+                _graph->forgetExternal(image);
+                image.destroy();
+            });
+
+#ifdef VOXELS_ENABLE_FSR2
+            if (localFsrContext != nullptr)
+                ffxFsr2ContextDestroy(localFsrContext);
             free(localScratchBuffer);
             free(localFsrContext);
             free(localFsrInterface);
-        });
-
-        return [=](const std::shared_ptr<Engine>&) {
-            this->resetDestroy();
-        };
-    });
-
-    engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE | RecreationEventFlags::TARGET_RESIZE, [&]() {
-        _target = std::make_unique<RenderImage>(engine, settings->targetResolution.x, settings->targetResolution.y, vk::Format::eR8G8B8A8Unorm,
-                                     vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor, "Upscaler Target");
-
-        return [=](const std::shared_ptr<Engine>&) {
-            _target->destroy();
+            _fsrInterface = nullptr;
+            _fsrContext = nullptr;
+            _fsrScratchBuffer = nullptr;
+#endif
         };
     });
 }
@@ -60,88 +114,117 @@ void UpscalerStage::update(float delta)
 {
     _deltaMsec = delta * 1000;
 
-    const int32_t jitterPhaseCount = ffxFsr2GetJitterPhaseCount(_settings->renderResolution().x, _settings->targetResolution.x);
+    // Enough phases for several samples to land in each target pixel, the same sequence FSR2 generates
+    float scale = static_cast<float>(_settings->targetResolution.x) / static_cast<float>(_settings->renderResolution().x);
+    const int32_t jitterPhaseCount = static_cast<int32_t>(std::ceil(8.0f * scale * scale));
 
-    ffxFsr2GetJitterOffset(&jitterX, &jitterY, frameCount % jitterPhaseCount, jitterPhaseCount);
+    int32_t phase = frameCount % jitterPhaseCount;
+    jitterX = halton(phase + 1, 2) - 0.5f;
+    jitterY = halton(phase + 1, 3) - 0.5f;
 
     frameCount++;
     if (frameCount > jitterPhaseCount)
         frameCount = 0;
 }
 
+void UpscalerStage::resetHistory()
+{
+    _historyValid = false;
+}
+
+const RenderImage& UpscalerStage::record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const ScreenQuadPush& screen,
+                                         const RenderImage& color, const GeometryBuffer& gBuffer)
+{
+    const RenderImage& target = _graph->image("Upscaled");
+
+#ifdef VOXELS_ENABLE_FSR2
+    if (_settings->fsrSetttings.backend == UpscalerBackend::FSR2)
+    {
+        recordFsr2(cmd, color, gBuffer, target);
+        return target;
+    }
+#endif
+
+    recordTemporal(cmd, flightFrame, screen, color, gBuffer, target);
+    return target;
+}
+
+void UpscalerStage::recordTemporal(const vk::CommandBuffer& cmd, uint32_t flightFrame, const ScreenQuadPush& screen,
+                                   const RenderImage& color, const GeometryBuffer& gBuffer, const RenderImage& target)
+{
+    uint32_t altFrame = (flightFrame + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT;
+    _graph->bindExternal("Upscaler History", _historyTargets[flightFrame]);
+    _graph->bindExternal("Previous Upscaler History", _historyTargets[altFrame]);
+
+    UpscalerPush push;
+    push.screen = screen;
+    push.targetSize = glm::ivec2(_settings->targetResolution);
+    push.reset = _historyValid && gBuffer.historyValid ? 0 : 1;
+    push.sharpness = _settings->fsrSetttings.sharpness;
+
+    const RenderImage& depth = gBuffer.depth;
+    const RenderImage& motion = gBuffer.motion;
+    const RenderImage& previousHistory = _historyTargets[altFrame];
+    DescriptorBindings bindings;
+    bindings.image(0, color.imageView, color.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(1, depth.imageView, depth.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(2, motion.imageView, motion.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(3, previousHistory.imageView, previousHistory.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .storageImage(4, _historyTargets[flightFrame].imageView)
+        .storageImage(5, target.imageView);
+
+    // Both kernels run once per target pixel
+    glm::uvec2 groups = (_settings->targetResolution + glm::uvec2(UPSCALER_TILE_SIZE - 1)) / glm::uvec2(UPSCALER_TILE_SIZE);
+
+    _graph->beginPass(cmd, "Upscaler");
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _accumulatePipeline->pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _accumulatePipeline->layout,
+        0, 1,
+        _descriptorSet->getSet(bindings),
+        0, nullptr);
+    cmd.pushConstants(_accumulatePipeline->layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(UpscalerPush), &push);
+    cmd.dispatch(groups.x, groups.y, 1);
+
+    // The kernels' layouts are identical, so the set and push constants stay bound
+    _graph->beginPass(cmd, "Upscaler Sharpen");
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, _sharpenPipeline->pipeline);
+    cmd.dispatch(groups.x, groups.y, 1);
+
+    _historyValid = true;
+}
+
+#ifdef VOXELS_ENABLE_FSR2
 FfxResource UpscalerStage::wrapRenderImage(const RenderImage& image)
 {
     return ffxGetTextureResourceVK(_fsrContext, static_cast<VkImage>(image.image), static_cast<VkImageView>(image.imageView),
         image.width, image.height, static_cast<VkFormat>(image.format));
 }
 
-const RenderImage& UpscalerStage::record(const vk::CommandBuffer& cmd,
-                                         const RenderImage& color, const RenderImage& depth, const RenderImage& motion, const RenderImage& mask)
+void UpscalerStage::recordFsr2(const vk::CommandBuffer& cmd, const RenderImage& color, const GeometryBuffer& gBuffer, const RenderImage& target)
 {
-    cmdutil::imageMemoryBarrier(
-        cmd,
-        depth.image,
-        vk::AccessFlagBits::eColorAttachmentWrite,
-        vk::AccessFlagBits::eShaderRead,
-        vk::ImageLayout::eColorAttachmentOptimal,
-        vk::ImageLayout::eShaderReadOnlyOptimal,
-        vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        vk::PipelineStageFlagBits::eFragmentShader,
-        vk::ImageAspectFlagBits::eColor);
-
-    cmdutil::imageMemoryBarrier(
-        cmd,
-        motion.image,
-        vk::AccessFlagBits::eColorAttachmentWrite,
-        vk::AccessFlagBits::eShaderRead,
-        vk::ImageLayout::eColorAttachmentOptimal,
-        vk::ImageLayout::eShaderReadOnlyOptimal,
-        vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        vk::PipelineStageFlagBits::eFragmentShader,
-        vk::ImageAspectFlagBits::eColor);
-
-    cmdutil::imageMemoryBarrier(
-        cmd,
-        mask.image,
-        vk::AccessFlagBits::eColorAttachmentWrite,
-        vk::AccessFlagBits::eShaderRead,
-        vk::ImageLayout::eColorAttachmentOptimal,
-        vk::ImageLayout::eShaderReadOnlyOptimal,
-        vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        vk::PipelineStageFlagBits::eFragmentShader,
-        vk::ImageAspectFlagBits::eColor);
-
-    cmdutil::imageMemoryBarrier(
-        cmd,
-        _target->image,
-        vk::AccessFlagBits::eShaderRead,
-        vk::AccessFlagBits::eShaderWrite,
-        vk::ImageLayout::eUndefined,
-        vk::ImageLayout::eGeneral,
-        vk::PipelineStageFlagBits::eFragmentShader,
-        vk::PipelineStageFlagBits::eComputeShader,
-        vk::ImageAspectFlagBits::eColor);
+    _graph->beginPass(cmd, "Upscaler");
 
     FfxFsr2DispatchDescription dispatchDescription = {};
 
     dispatchDescription.commandList = ffxGetCommandListVK(cmd);
 
     dispatchDescription.color = wrapRenderImage(color);
-    dispatchDescription.depth = wrapRenderImage(depth);
-    dispatchDescription.motionVectors = wrapRenderImage(motion);
-    dispatchDescription.reactive = wrapRenderImage(mask);
-    dispatchDescription.output = wrapRenderImage(*_target);
+    dispatchDescription.depth = wrapRenderImage(gBuffer.depth);
+    dispatchDescription.motionVectors = wrapRenderImage(gBuffer.motion);
+    dispatchDescription.reactive = wrapRenderImage(gBuffer.mask);
+    dispatchDescription.output = wrapRenderImage(target);
 
     dispatchDescription.jitterOffset.x = jitterX;
     dispatchDescription.jitterOffset.y = jitterY;
 
-    dispatchDescription.motionVectorScale.x = 1.0;
-    dispatchDescription.motionVectorScale.y = 1.0;
+    // Motion vectors are written in UV space, but FSR expects render-resolution pixels
+    dispatchDescription.motionVectorScale.x = static_cast<float>(_settings->renderResolution().x);
+    dispatchDescription.motionVectorScale.y = static_cast<float>(_settings->renderResolution().y);
 
     dispatchDescription.reset = false;
 
-    dispatchDescription.enableSharpening = true;
-    dispatchDescription.sharpness = 1.0f;
+    dispatchDescription.enableSharpening = _settings->fsrSetttings.sharpness > 0.0f;
+    dispatchDescription.sharpness = _settings->fsrSetttings.sharpness;
 
     dispatchDescription.frameTimeDelta = _deltaMsec;
 
@@ -152,21 +235,10 @@ const RenderImage& UpscalerStage::record(const vk::CommandBuffer& cmd,
 
     dispatchDescription.cameraFar = INFINITY;
     dispatchDescription.cameraNear = 0.0;
-    dispatchDescription.cameraFovAngleVertical = 0.2f; // TODO calculate
+    // The tracer spans up * (height / width) at unit distance along the view direction
+    dispatchDescription.cameraFovAngleVertical = 2.0f * std::atan(static_cast<float>(_settings->renderResolution().y) / static_cast<float>(_settings->renderResolution().x));
 
     FfxErrorCode errorCode = ffxFsr2ContextDispatch(_fsrContext, &dispatchDescription);
     FFX_ASSERT(errorCode == FFX_OK);
-
-    cmdutil::imageMemoryBarrier(
-        cmd,
-        _target->image,
-        vk::AccessFlagBits::eShaderWrite,
-        vk::AccessFlagBits::eShaderRead,
-        vk::ImageLayout::eGeneral,
-        vk::ImageLayout::eShaderReadOnlyOptimal,
-        vk::PipelineStageFlagBits::eComputeShader,
-        vk::PipelineStageFlagBits::eFragmentShader,
-        vk::ImageAspectFlagBits::eColor);
-
-    return *_target;
 }
+#endif
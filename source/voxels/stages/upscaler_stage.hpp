@@ -1,12 +1,27 @@
 #pragma once
 
+#include <memory>
+#include <optional>
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.hpp>
+#ifdef VOXELS_ENABLE_FSR2
 #include <ffx_fsr2.h>
+#endif
+#include "util/resource_ring.hpp"
+#include "engine/pipeline/descriptor_set.hpp"
 #include "voxels/voxel_render_stage.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
 
 class RenderImage;
+class TemporalUpscalerPipeline;
+struct GeometryBuffer;
 
+// Must match TILE_SIZE in temporal_upscaler.glsl
+#define UPSCALER_TILE_SIZE 8
+
+// Upscales the render resolution to the target resolution, from samples jittered across frames.
+// Upscales with FSR2 in builds which link it, or with the built-in temporal upscaler,
+// which reprojects its history along the motion vectors, clamps it to the current samples' neighbourhood, and sharpens the result.
 class UpscalerStage : public AVoxelRenderStage
 {
 public:
@@ -15,22 +30,39 @@ public:
     int frameCount;
 
 private:
-    std::unique_ptr<RenderImage> _target;
+#ifdef VOXELS_ENABLE_FSR2
+    FfxFsr2Interface* _fsrInterface = nullptr;
+    FfxFsr2Context* _fsrContext = nullptr;
+    void* _fsrScratchBuffer = nullptr;
+#endif
+
+    float _deltaMsec = 0.0f;
 
-    FfxFsr2Interface* _fsrInterface;
-    FfxFsr2Context* _fsrContext;
-    void* _fsrScratchBuffer;
+    // Accumulated color at target resolution for each frame, only allocated for the built-in upscaler
+    ResourceRing<RenderImage> _historyTargets;
+    bool _historyValid = false;
 
-    float _deltaMsec;
+    std::optional<DescriptorSet> _descriptorSet;
+    std::unique_ptr<TemporalUpscalerPipeline> _accumulatePipeline;
+    std::unique_ptr<TemporalUpscalerPipeline> _sharpenPipeline;
 
 public:
-    UpscalerStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings);
+    UpscalerStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph);
 
     void update(float delta);
-    const RenderImage& record(const vk::CommandBuffer& cmd,
-        const RenderImage& color, const RenderImage& depth,
-        const RenderImage& motion, const RenderImage& mask);
+
+    // Discards the built-in upscaler's history, e.g. while upscaling is disabled.
+    void resetHistory();
+
+    const RenderImage& record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const ScreenQuadPush& screen,
+        const RenderImage& color, const GeometryBuffer& gBuffer);
 
 private:
+    void recordTemporal(const vk::CommandBuffer& cmd, uint32_t flightFrame, const ScreenQuadPush& screen,
+        const RenderImage& color, const GeometryBuffer& gBuffer, const RenderImage& target);
+
+#ifdef VOXELS_ENABLE_FSR2
+    void recordFsr2(const vk::CommandBuffer& cmd, const RenderImage& color, const GeometryBuffer& gBuffer, const RenderImage& target);
     FfxResource wrapRenderImage(const RenderImage& image);
+#endif
 };
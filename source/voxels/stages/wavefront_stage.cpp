@@ -0,0 +1,228 @@
+#include "wavefront_stage.hpp"
+
+#include <cstddef>
+#include "engine/engine.hpp"
+#include "engine/resource/buffer.hpp"
+#include "engine/resource/render_image.hpp"
+#include "engine/resource/texture_2d.hpp"
+#include "engine/resource/texture_3d.hpp"
+#include "engine/commands/command_util.hpp"
+#include "voxels/pipeline/wavefront_pipeline.hpp"
+#include "voxels/resource/voxel_scene.hpp"
+#include "voxels/resource/parameters.hpp"
+#include "voxels/stages/geometry_stage.hpp"
+#include "engine/graph/render_graph.hpp"
+
+// Matches the local sizes of the wavefront kernels
+static const uint32_t TILE_SIZE = 8;
+
+// Queue entries are 32 bytes, matching HitItem and RayItem in wavefront_common.glsl
+static const vk::DeviceSize QUEUE_ITEM_SIZE = 32;
+
+WavefrontStage::WavefrontStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph,
+                               const std::shared_ptr<VoxelScene>& scene, const std::shared_ptr<Texture2D>& noise) : AVoxelRenderStage(engine, settings, graph), _scene(scene), _noise(noise)
+{
+    vk::ShaderStageFlags stage = vk::ShaderStageFlagBits::eCompute;
+    DescriptorSet localDescriptorSet = DescriptorSetBuilder(engine)
+        .image(0, stage)
+        .buffer(1, stage, vk::DescriptorType::eUniformBuffer)
+        .image(2, stage)
+        .image(3, stage)
+        .buffer(4, stage, vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(5, stage, vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(6, stage, vk::DescriptorType::eUniformBufferDynamic)
+        .storageImage(7, stage)
+        .storageImage(8, stage)
+        .storageImage(9, stage)
+        .storageImage(11, stage)
+        .storageImage(12, stage)
+        .storageImage(13, stage)
+        .storageImage(14, stage)
+        .buffer(15, stage, vk::DescriptorType::eStorageBuffer)
+        .buffer(16, stage, vk::DescriptorType::eStorageBuffer)
+        .buffer(17, stage, vk::DescriptorType::eStorageBuffer)
+        .buffer(18, stage, vk::DescriptorType::eStorageBuffer)
+        .image(19, stage)
+        .buffer(20, stage, vk::DescriptorType::eStorageBuffer)
+        .image(21, stage)
+        .image(22, stage)
+        .image(23, stage)
+        .buffer(24, stage, vk::DescriptorType::eStorageBuffer)
+        .build("Wavefront Descriptor Set");
+    _descriptorSet = localDescriptorSet;
+    pushDeletor([=](const std::shared_ptr<Engine>&) {
+        localDescriptorSet.destroy();
+    });
+
+    _queuesBuffer = std::make_unique<Buffer>(engine, sizeof(WavefrontQueues),
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        VMA_MEMORY_USAGE_GPU_ONLY, "Wavefront Queues Buffer");
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _queuesBuffer->destroy();
+    });
+
+    uint32_t recreatorId = engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE, [&]() {
+        glm::uvec2 renderRes = _settings->maxRenderResolution();
+
+        vk::DeviceSize queueSize = static_cast<vk::DeviceSize>(renderRes.x) * renderRes.y * QUEUE_ITEM_SIZE;
+        _hitQueue = std::make_unique<Buffer>(engine, queueSize, vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_GPU_ONLY, "Wavefront Hit Queue");
+        _rayQueue = std::make_unique<Buffer>(engine, queueSize, vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_GPU_ONLY, "Wavefront Ray Queue");
+        glm::uvec2 tiles = (renderRes + TILE_SIZE - 1u) / TILE_SIZE;
+        vk::DeviceSize tileQueueSize = static_cast<vk::DeviceSize>(tiles.x) * tiles.y * sizeof(uint32_t);
+        _tileQueue = std::make_unique<Buffer>(engine, tileQueueSize, vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_GPU_ONLY, "Wavefront Tile Queue");
+
+        return [=](const std::shared_ptr<Engine>&) {
+            _hitQueue->destroy();
+            _rayQueue->destroy();
+            _tileQueue->destroy();
+        };
+    });
+    pushDeletor([=](const std::shared_ptr<Engine>& delEngine) {
+        delEngine->recreationQueue->remove(recreatorId);
+    });
+
+    vk::DescriptorSetLayout setLayout = _descriptorSet->layout;
+    _classifyPipeline = std::make_unique<WavefrontPipeline>(WavefrontPipeline::build(engine, "../shader/wavefront_classify.comp.spv", setLayout));
+    _primaryPipeline = std::make_unique<WavefrontPipeline>(WavefrontPipeline::build(engine, "../shader/wavefront_primary.comp.spv", setLayout));
+    _reflectPipeline = std::make_unique<WavefrontPipeline>(WavefrontPipeline::build(engine, "../shader/wavefront_reflect.comp.spv", setLayout));
+    _shadowPipeline = std::make_unique<WavefrontPipeline>(WavefrontPipeline::build(engine, "../shader/wavefront_shadow.comp.spv", setLayout));
+    _ambientPipeline = std::make_unique<WavefrontPipeline>(WavefrontPipeline::build(engine, "../shader/wavefront_ambient.comp.spv", setLayout));
+    _argsPipeline = std::make_unique<WavefrontPipeline>(WavefrontPipeline::build(engine, "../shader/wavefront_args.comp.spv", setLayout));
+    _resolvePipeline = std::make_unique<WavefrontPipeline>(WavefrontPipeline::build(engine, "../shader/wavefront_resolve.comp.spv", setLayout));
+    pushDeletor([&](const std::shared_ptr<Engine>&) {
+        _classifyPipeline->destroy();
+        _primaryPipeline->destroy();
+        _reflectPipeline->destroy();
+        _shadowPipeline->destroy();
+        _ambientPipeline->destroy();
+        _argsPipeline->destroy();
+        _resolvePipeline->destroy();
+    });
+}
+
+void WavefrontStage::pushConstants(const vk::CommandBuffer& cmd, const WavefrontPipeline& pipeline, const ScreenQuadPush& screen, uint32_t depth)
+{
+    WavefrontPush push;
+    push.screen = screen;
+    push.depth = depth;
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline.pipeline);
+    cmd.pushConstants(pipeline.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(WavefrontPush), &push);
+}
+
+void WavefrontStage::dispatchIndirect(const vk::CommandBuffer& cmd, const WavefrontPipeline& pipeline, const ScreenQuadPush& screen, uint32_t depth, vk::DeviceSize argsOffset)
+{
+    pushConstants(cmd, pipeline, screen, depth);
+    cmd.dispatchIndirect(_queuesBuffer->buffer, argsOffset);
+}
+
+void WavefrontStage::computeBarrier(const vk::CommandBuffer& cmd)
+{
+    // Queue contents, counters and per-pixel state are all written by one kernel and consumed by the next
+    cmdutil::memoryBarrier(
+        cmd,
+        vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eIndirectCommandRead,
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eDrawIndirect);
+}
+
+void WavefrontStage::record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const GeometryBuffer& targets, const ScreenQuadPush& screen,
+                            const VolumeUniformOffsets& uniforms, const Buffer& laneStats, const Texture3D& sunVisibility, const Buffer& ambientCache, const RenderImage& sampleMap,
+                            const RenderImage& depthTiles)
+{
+    // Empty every queue
+    cmd.fillBuffer(_queuesBuffer->buffer, 0, sizeof(WavefrontQueues), 0);
+    cmdutil::memoryBarrier(
+        cmd,
+        vk::AccessFlagBits::eTransferWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eComputeShader);
+
+    const RenderImage& depth = targets.depth;
+    const RenderImage& motion = targets.motion;
+    const RenderImage& mask = targets.mask;
+    const RenderImage& normal = targets.normal;
+    const RenderImage& color = targets.color;
+    // Per-pixel path state, fully rewritten by the primary kernel
+    const RenderImage& radiance = _graph->image("Wavefront Radiance");
+    const RenderImage& throughput = _graph->image("Wavefront Throughput");
+    DescriptorBindings bindings;
+    bindings.image(0, _scene->sceneTexture->imageView, _scene->sceneTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(1, _scene->paletteBuffer->buffer, _scene->paletteBuffer->size, vk::DescriptorType::eUniformBuffer)
+        .image(2, _noise->imageView, _noise->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(3, _scene->skyboxTexture->imageView, _scene->skyboxTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(4, engine->uniforms->buffer, sizeof(VolumeParameters), vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(5, engine->uniforms->buffer, sizeof(Light), vk::DescriptorType::eUniformBufferDynamic)
+        .buffer(6, engine->uniforms->buffer, sizeof(CameraParameters), vk::DescriptorType::eUniformBufferDynamic)
+        .storageImage(7, depth.imageView)
+        .storageImage(8, motion.imageView)
+        .storageImage(9, mask.imageView)
+        .storageImage(11, normal.imageView)
+        .storageImage(12, color.imageView)
+        .storageImage(13, radiance.imageView)
+        .storageImage(14, throughput.imageView)
+        .buffer(15, _hitQueue->buffer, _hitQueue->size, vk::DescriptorType::eStorageBuffer)
+        .buffer(16, _rayQueue->buffer, _rayQueue->size, vk::DescriptorType::eStorageBuffer)
+        .buffer(17, _queuesBuffer->buffer, _queuesBuffer->size, vk::DescriptorType::eStorageBuffer)
+        .buffer(18, laneStats.buffer, laneStats.size, vk::DescriptorType::eStorageBuffer)
+        .image(19, sunVisibility.imageView, sunVisibility.sampler, vk::ImageLayout::eGeneral)
+        .buffer(20, ambientCache.buffer, ambientCache.size, vk::DescriptorType::eStorageBuffer)
+        .image(21, _scene->occupancyTexture->imageView, _scene->occupancyTexture->sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(22, sampleMap.imageView, sampleMap.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .image(23, depthTiles.imageView, depthTiles.sampler, vk::ImageLayout::eShaderReadOnlyOptimal)
+        .buffer(24, _tileQueue->buffer, _tileQueue->size, vk::DescriptorType::eStorageBuffer);
+
+    // Every kernel shares the same layout, so the set only needs binding once
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _primaryPipeline->layout,
+        0, 1,
+        _descriptorSet->getSet(bindings),
+        static_cast<uint32_t>(uniforms.size()), uniforms.data());
+
+    glm::uvec2 groups = (glm::uvec2(screen.screenSize) + TILE_SIZE - 1u) / TILE_SIZE;
+    // Under checkerboard rendering, primary rays are only dispatched for the half of each row traced this frame
+    glm::uvec2 primaryGroups = groups;
+    if (_settings->checkerboard.enable)
+        primaryGroups.x = ((static_cast<uint32_t>(screen.screenSize.x) + 1u) / 2u + TILE_SIZE - 1u) / TILE_SIZE;
+    if (_settings->tracerSettings.tileClassification)
+    {
+        pushConstants(cmd, *_classifyPipeline, screen, 0);
+        cmd.dispatch(primaryGroups.x, primaryGroups.y, 1);
+        computeBarrier(cmd);
+        dispatchIndirect(cmd, *_primaryPipeline, screen, 0, offsetof(WavefrontQueues, tileArgs));
+    }
+    else
+    {
+        pushConstants(cmd, *_primaryPipeline, screen, 0);
+        cmd.dispatch(primaryGroups.x, primaryGroups.y, 1);
+    }
+
+    for (uint32_t bounce = 0; bounce < WAVEFRONT_MAX_DEPTH; bounce++)
+    {
+        vk::DeviceSize hitArgs = offsetof(WavefrontQueues, hitArgs) + bounce * sizeof(glm::uvec4);
+        vk::DeviceSize rayArgs = offsetof(WavefrontQueues, rayArgs) + bounce * sizeof(glm::uvec4);
+
+        // Reflection rays queued by the previous bounce
+        if (bounce > 0)
+        {
+            computeBarrier(cmd);
+            pushConstants(cmd, *_argsPipeline, screen, bounce);
+            cmd.dispatch(1, 1, 1);
+            computeBarrier(cmd);
+            dispatchIndirect(cmd, *_reflectPipeline, screen, bounce, rayArgs);
+        }
+
+        computeBarrier(cmd);
+        pushConstants(cmd, *_argsPipeline, screen, bounce);
+        cmd.dispatch(1, 1, 1);
+        computeBarrier(cmd);
+        dispatchIndirect(cmd, *_shadowPipeline, screen, bounce, hitArgs);
+        computeBarrier(cmd);
+        dispatchIndirect(cmd, *_ambientPipeline, screen, bounce, hitArgs);
+    }
+
+    computeBarrier(cmd);
+    pushConstants(cmd, *_resolvePipeline, screen, 0);
+    cmd.dispatch(groups.x, groups.y, 1);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "voxels/voxel_render_stage.hpp"
+#include "voxels/resource/screen_quad_push.hpp"
+#include "voxels/resource/parameters.hpp"
+#include "engine/pipeline/descriptor_set.hpp"
+
+class RenderImage;
+class Buffer;
+class VoxelScene;
+class Texture2D;
+class Texture3D;
+class VoxelRenderSettings;
+class WavefrontPipeline;
+struct GeometryBuffer;
+
+// Compute-based tracer which fills the same G-buffer as the fragment tracer.
+// Primary rays are traced per pixel, then surface hits and reflection rays are compacted into queues,
+// so shadow, ambient and reflection kernels only launch lanes for pixels that need them.
+// Under tile classification, tiles whose rays can't reach the volume are filled with the sky up front,
+// and primary rays are only dispatched indirectly for the tiles left over.
+class WavefrontStage : public AVoxelRenderStage
+{
+private:
+    std::shared_ptr<VoxelScene> _scene;
+    std::shared_ptr<Texture2D> _noise;
+
+    std::optional<DescriptorSet> _descriptorSet;
+
+    std::unique_ptr<WavefrontPipeline> _classifyPipeline;
+    std::unique_ptr<WavefrontPipeline> _primaryPipeline;
+    std::unique_ptr<WavefrontPipeline> _reflectPipeline;
+    std::unique_ptr<WavefrontPipeline> _shadowPipeline;
+    std::unique_ptr<WavefrontPipeline> _ambientPipeline;
+    std::unique_ptr<WavefrontPipeline> _argsPipeline;
+    std::unique_ptr<WavefrontPipeline> _resolvePipeline;
+
+    // Queued work, with room for one entry per pixel
+    std::unique_ptr<Buffer> _hitQueue;
+    std::unique_ptr<Buffer> _rayQueue;
+    // Tiles left for primary rays, with room for every tile of the primary dispatch
+    std::unique_ptr<Buffer> _tileQueue;
+    std::unique_ptr<Buffer> _queuesBuffer;
+
+public:
+    WavefrontStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph,
+                   const std::shared_ptr<VoxelScene>& scene, const std::shared_ptr<Texture2D>& noise);
+
+    // Traces the scene into the given G-buffer targets, within the graph's geometry pass.
+    void record(const vk::CommandBuffer& cmd, uint32_t flightFrame, const GeometryBuffer& targets, const ScreenQuadPush& screen,
+                const VolumeUniformOffsets& uniforms, const Buffer& laneStats, const Texture3D& sunVisibility, const Buffer& ambientCache, const RenderImage& sampleMap,
+                const RenderImage& depthTiles);
+
+private:
+    void pushConstants(const vk::CommandBuffer& cmd, const WavefrontPipeline& pipeline, const ScreenQuadPush& screen, uint32_t depth);
+    void dispatchIndirect(const vk::CommandBuffer& cmd, const WavefrontPipeline& pipeline, const ScreenQuadPush& screen, uint32_t depth, vk::DeviceSize argsOffset);
+    void computeBarrier(const vk::CommandBuffer& cmd);
+};
@@ -4,7 +4,7 @@
 #include <fmt/format.h>
 #include <algorithm>
 
-void VoxelPerformanceGui::draw(float delta)
+void VoxelPerformanceGui::draw(float delta, const FrameStatistics& stats)
 {
     static float history[25];
     std::rotate(std::begin(history), std::next(std::begin(history)), std::end(history));
@@ -13,5 +13,31 @@ void VoxelPerformanceGui::draw(float delta)
     ImGui::Begin("Performance");
     ImGui::LabelText("Frame Time", "%s", fmt::format("{}", delta * 1000).c_str());
     ImGui::PlotHistogram("Frame Time History", history, 25, 0, nullptr, 0, 1.0f / 30.0f, ImVec2(0, 80));
+    ImGui::LabelText("GPU Time", "%s", fmt::format("{}", stats.gpuFrameMs).c_str());
+    ImGui::LabelText("Render Resolution", "%s", fmt::format("{}x{}", stats.renderResolution.x, stats.renderResolution.y).c_str());
+    ImGui::LabelText("Pipeline Cache", "%s", stats.pipelineCreation.warm ? "Warm" : "Cold");
+    ImGui::LabelText("Pipeline Creation", "%s", fmt::format("{:.1f} ms ({} pipelines)", stats.pipelineCreation.totalMs, stats.pipelineCreation.count).c_str());
+    float transientMb = static_cast<float>(stats.graphMemory.allocatedBytes) / (1024.0f * 1024.0f);
+    float aliasedMb = static_cast<float>(stats.graphMemory.requestedBytes - stats.graphMemory.allocatedBytes) / (1024.0f * 1024.0f);
+    ImGui::LabelText("Transient Memory", "%s", fmt::format("{:.1f} MB ({:.1f} MB saved by aliasing)", transientMb, aliasedMb).c_str());
+    if (stats.laneUtilization.has_value())
+    {
+        const std::array<const char*, 4> names = { "Primary Lanes", "Shadow Lanes", "Ambient Lanes", "Reflection Lanes" };
+        for (size_t i = 0; i < names.size(); i++)
+            ImGui::LabelText(names[i], "%s", fmt::format("{:.1f}%", (*stats.laneUtilization)[i] * 100.0f).c_str());
+    }
+    if (stats.primaryRays.has_value())
+    {
+        const PrimaryRayStatistics& primary = *stats.primaryRays;
+        ImGui::LabelText("Primary Steps", "%s", fmt::format("{:.1f}/ray ({:.1f} skipped)", primary.stepsPerRay, primary.skippedStepsPerRay).c_str());
+        ImGui::LabelText("Start Misses", "%s", fmt::format("{:.2f}%", primary.startMissRate * 100.0f).c_str());
+    }
+    if (stats.ambientSampling.has_value())
+    {
+        const SampleMapStatistics& sampling = *stats.ambientSampling;
+        ImGui::LabelText("Ambient Rays", "%s", fmt::format("{:.2f} M/frame ({:.2f} M uniform)",
+            sampling.raysPerFrame / 1e6f, sampling.uniformRaysPerFrame / 1e6f).c_str());
+        ImGui::LabelText("Ambient Noise", "%s", fmt::format("{:.3f} relative std. dev.", sampling.meanNoise).c_str());
+    }
     ImGui::End();
 }
@@ -1,6 +1,28 @@
 #pragma once
 
+#include <array>
+#include <optional>
+#include <glm/glm.hpp>
+#include "engine/pipeline_cache.hpp"
+#include "engine/graph/render_graph.hpp"
+#include "voxels/stages/sample_map_stage.hpp"
+#include "voxels/resource/lane_statistics.hpp"
+
+struct FrameStatistics
+{
+    float gpuFrameMs;
+    glm::uvec2 renderResolution;
+    // Fraction of lanes doing useful traversal for primary, shadow, ambient and reflection rays, when collected
+    std::optional<std::array<float, 4>> laneUtilization;
+    // Primary ray steps, and those saved by starting from the depth tiles, when collected
+    std::optional<PrimaryRayStatistics> primaryRays;
+    // Ambient rays cast against uniform sampling, and the noise left, when measured
+    std::optional<SampleMapStatistics> ambientSampling;
+    PipelineCreationStats pipelineCreation;
+    RenderGraphMemory graphMemory;
+};
+
 namespace VoxelPerformanceGui
 {
-    extern void draw(float delta);
+    extern void draw(float delta, const FrameStatistics& stats);
 }
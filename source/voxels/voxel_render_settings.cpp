@@ -6,8 +6,52 @@ static uint32_t scale(FsrScaling scaling, uint32_t dim)
 }
 
 glm::uvec2 VoxelRenderSettings::renderResolution() const
+{
+    glm::uvec2 maxRes = maxRenderResolution();
+    if (!dynamicResolutionActive())
+        return maxRes;
+
+    glm::uvec2 res = glm::uvec2(glm::vec2(maxRes) * resolutionScale);
+    return glm::clamp(res, glm::uvec2(1), maxRes);
+}
+
+glm::uvec2 VoxelRenderSettings::maxRenderResolution() const
 {
     if (fsrSetttings.enable)
         return glm::uvec2(scale(fsrSetttings.scaling, targetResolution.x), scale(fsrSetttings.scaling, targetResolution.y));
     return targetResolution;
 }
+
+bool VoxelRenderSettings::dynamicResolutionActive() const
+{
+    return dynamicResolution.enable && dynamicResolutionUnavailable() == nullptr;
+}
+
+const char* VoxelRenderSettings::dynamicResolutionUnavailable() const
+{
+    // Only the upscalers sample a sub-rectangle of the render targets
+    if (!fsrSetttings.enable)
+        return "Needs FSR, as the blit expects the render targets to be fully covered";
+    return nullptr;
+}
+
+bool VoxelRenderSettings::secondaryRaysReduced() const
+{
+    return occlusionSettings.resolution != SecondaryResolution::FULL || lightSettings.shadowResolution != SecondaryResolution::FULL;
+}
+
+const char* VoxelRenderSettings::adaptiveSamplesUnavailable() const
+{
+    // Per-pixel counts only steer rays each pixel traces for itself, at full resolution, with noise measured by accumulation
+    if (occlusionSettings.mode != AmbientOcclusionMode::RAYS)
+        return "Cone traced occlusion takes no samples";
+    if (occlusionSettings.cache)
+        return "Cached faces are shared between pixels, so take no per-pixel samples";
+    if (occlusionSettings.resolution != SecondaryResolution::FULL)
+        return "Reduced resolution occlusion is traced per block rather than per pixel";
+    if (occlusionSettings.numSamples <= 0)
+        return "No occlusion samples to redistribute";
+    if (!temporalSettings.enable)
+        return "Noise is only measured under temporal accumulation";
+    return nullptr;
+}
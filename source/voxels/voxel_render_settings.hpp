@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include "engine/recreation_queue.hpp"
 #include <glm/glm.hpp>
 
@@ -12,26 +13,115 @@ enum class FsrScaling : uint32_t
     ULTRA_PERFORMANCE = 30
 };
 
+enum class UpscalerBackend : uint32_t
+{
+    FSR2,
+    // Built-in temporal upscaler, for builds without FSR2
+    TEMPORAL
+};
+
 struct FsrSettings
 {
     bool enable = true;
     FsrScaling scaling = FsrScaling::BALANCED;
+#ifdef VOXELS_ENABLE_FSR2
+    UpscalerBackend backend = UpscalerBackend::FSR2;
+#else
+    UpscalerBackend backend = UpscalerBackend::TEMPORAL;
+#endif
+    // From 0 for none to 1 for the most sharpening
+    float sharpness = 1.0f;
+};
+
+// Scales the render resolution below the FSR quality mode to hold a GPU frame time budget
+struct DynamicResolutionSettings
+{
+    bool enable = false;
+    float targetFrameMs = 8.3f;
+    float minScale = 0.5f;
+};
+
+// Traces half the pixels each frame in an alternating checkerboard, reconstructing the rest from the previous frame
+struct CheckerboardSettings
+{
+    bool enable = false;
+    // Distance from the surface, relative to view distance, within which reprojected history is accepted
+    float positionThreshold = 0.02f;
+};
+
+struct TracerSettings
+{
+    // Trace with compute kernels and compacted ray queues instead of one fragment shader
+    bool wavefront = false;
+    bool collectLaneStats = false;
+    // Start primary rays near the previous frame's depth, reprojected into tiles, instead of where they enter the volume
+    bool reprojectedStart = false;
+    // Start primary rays where a beam covering their tile first meets the scene's coarse occupancy
+    bool beamPrepass = false;
+    // Fill screen regions whose rays can't reach the volume with the sky, so primary rays are only traced where they may hit
+    bool tileClassification = false;
+    // End reflection chains by Russian roulette on their throughput, and light bounces past the first reflection
+    // with cone traced ambient occlusion and baked shadows only
+    bool reflectionRoulette = false;
+    // Fragment tracer limits, compiled into its pipeline as specialization constants
+    int maxRaySteps = 512;
+    int maxReflections = 5;
 };
 
 struct DenoiserSettings
 {
     bool enable = true;
+    // Filter in compute with shared-memory tiles, instead of one fragment pass per iteration
+    bool compute = true;
+    // Scale luminance edge-stopping by the variance from temporal accumulation, instead of fixed color weights
+    bool varianceGuided = true;
     int iterations = 2;
     float phiColor0 = 20.4f;
     float phiNormal0 = 1E-2f;
     float phiPos0 = 1E-1f;
     float stepWidth = 2.0f;
+    // Standard deviations of luminance over which variance-guided weights fall off
+    float phiLuminance = 4.0f;
+};
+
+struct TemporalSettings
+{
+    bool enable = true;
+    float blendFactor = 0.1f;
+    float positionThreshold = 0.02f;
+    float normalThreshold = 0.9f;
+};
+
+enum class AmbientOcclusionMode : uint32_t
+{
+    // Stochastic rays, numSamples per pixel or cached voxel face
+    RAYS,
+    // Cones marched through the scene's occupancy mips, which cost a fixed number of fetches and need no denoising
+    CONES
+};
+
+// Resolution shadow or ambient rays are traced at, as pixels per ray along each axis
+enum class SecondaryResolution : uint32_t
+{
+    FULL = 1,
+    HALF = 2,
+    QUARTER = 4
 };
 
 struct AmbientOcclusionSettings
 {
-    int numSamples = 4;
+    AmbientOcclusionMode mode = AmbientOcclusionMode::RAYS;
+    // Occlusion is disabled entirely with no samples, in either mode
+    int numSamples = 1;
     float intensity = 1.0f;
+    // Shares samples between every pixel seeing a voxel face, adding numSamples per face each frame
+    bool cache = true;
+    // Moves samples from converged pixels to noisy ones, keeping numSamples per pixel on average.
+    // Needs temporal accumulation for its noise estimate, and only applies to uncached rays.
+    bool adaptive = false;
+    int maxAdaptiveSamples = 16;
+    // Traced for primary hits in a separate pass below full resolution, then upsampled along the G-buffer's edges
+    SecondaryResolution resolution = SecondaryResolution::FULL;
 };
 
 struct LightSettings
@@ -39,6 +129,12 @@ struct LightSettings
     glm::vec3 direction = glm::normalize(glm::vec3(1.0f, 1.0f, 1.0f));
     glm::vec4 color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
     float intensity = 1.0f;
+    // Look shadows up from a volume baked for every voxel face, instead of tracing them for every pixel
+    bool bakedVisibility = true;
+    // Slices of the volume baked each frame after the light moves
+    int bakeSlicesPerFrame = 8;
+    // Traced for primary hits in a separate pass below full resolution, then upsampled along the G-buffer's edges
+    SecondaryResolution shadowResolution = SecondaryResolution::FULL;
 };
 
 class VoxelRenderSettings
@@ -47,6 +143,12 @@ public:
     glm::uvec2 targetResolution = { 1920, 1080 };
 
     FsrSettings fsrSetttings = {};
+    DynamicResolutionSettings dynamicResolution = {};
+    // Current fraction of the maximum render resolution, updated each frame by the renderer
+    float resolutionScale = 1.0f;
+    CheckerboardSettings checkerboard = {};
+    TracerSettings tracerSettings = {};
+    TemporalSettings temporalSettings = {};
     DenoiserSettings denoiserSettings = {};
     AmbientOcclusionSettings occlusionSettings = {};
     LightSettings lightSettings = {};
@@ -55,6 +157,17 @@ public:
     std::string skyboxPath = "../resource/rustig_koppie.hdr";
 
 public:
+    // Resolution rendered to this frame, which may be smaller than the allocated targets
     glm::uvec2 renderResolution() const;
+    // Resolution render targets are allocated at
+    glm::uvec2 maxRenderResolution() const;
+    // Whether the render resolution can change without recreating targets
+    bool dynamicResolutionActive() const;
+    // Why dynamic resolution can't scale the render resolution with the other settings, or null if it can
+    const char* dynamicResolutionUnavailable() const;
+    // Whether shadows or ambient occlusion are traced below full resolution
+    bool secondaryRaysReduced() const;
+    // Why the adaptive sample map can't steer ambient occlusion with the other settings, or null if it can
+    const char* adaptiveSamplesUnavailable() const;
 };
 
@@ -3,12 +3,16 @@
 #include "engine/resource.hpp"
 #include "voxel_render_settings.hpp"
 
+class RenderGraph;
+
 class AVoxelRenderStage : public AResource
 {
 protected:
     std::shared_ptr<VoxelRenderSettings> _settings;
+    // Orders image accesses between stages, and owns the targets which only live within a frame
+    std::shared_ptr<RenderGraph> _graph;
 
 public:
-    AVoxelRenderStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings)
-        : AResource(engine), _settings(settings) {}
+    AVoxelRenderStage(const std::shared_ptr<Engine>& engine, const std::shared_ptr<VoxelRenderSettings>& settings, const std::shared_ptr<RenderGraph>& graph)
+        : AResource(engine), _settings(settings), _graph(graph) {}
 };
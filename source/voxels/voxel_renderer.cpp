@@ -1,10 +1,13 @@
 #include "voxel_renderer.hpp"
 
+#include <fmt/format.h>
 #include "engine/engine.hpp"
+#include "engine/gpu_timer.hpp"
 #include "voxels/voxel_settings_gui.hpp"
 #include "engine/gui/imgui_renderer.hpp"
 #include "engine/resource/texture_2d.hpp"
 #include "voxels/stages/geometry_stage.hpp"
+#include "voxels/stages/temporal_stage.hpp"
 #include "voxels/stages/denoiser_stage.hpp"
 #include "voxels/stages/upscaler_stage.hpp"
 #include "voxels/stages/blit_stage.hpp"
@@ -12,6 +15,10 @@
 #include "voxels/resource/screen_quad_push.hpp"
 #include "engine/resource/render_image.hpp"
 #include "voxels/voxel_performance_gui.hpp"
+#include "voxels/resource/lane_statistics.hpp"
+#include "voxels/stages/sample_map_stage.hpp"
+#include "voxels/stages/depth_tile_stage.hpp"
+#include "engine/graph/render_graph.hpp"
 
 VoxelRenderer::VoxelRenderer(const std::shared_ptr<Engine>& engine) : ARenderer(engine)
 {
@@ -22,12 +29,26 @@ VoxelRenderer::VoxelRenderer(const std::shared_ptr<Engine>& engine) : ARenderer(
     _noiseTexture = std::make_shared<Texture2D>(engine, "../resource/blue_noise_rgba.png", 4, vk::Format::eR8G8B8A8Unorm);
     _scene = std::make_shared<VoxelScene>(engine, _settings->voxPath, _settings->skyboxPath);
 
-    _geometryStage = std::make_unique<GeometryStage>(engine, _settings, _scene, _noiseTexture);
-    _denoiserStage = std::make_unique<DenoiserStage>(engine, _settings);
-    _upscalerStage = std::make_unique<UpscalerStage>(engine, _settings);
-    _blitStage = std::make_unique<BlitStage>(engine, _settings, *_windowRenderPass);
+    // Pushed before the stages, so their framebuffers are recreated after the graph's targets
+    _graph = std::make_shared<RenderGraph>(engine);
+    engine->recreationQueue->push(RecreationEventFlags::RENDER_RESIZE | RecreationEventFlags::RENDER_GRAPH, [&]() {
+        declareGraph();
+        _graph->compile();
+
+        return [=](const std::shared_ptr<Engine>&) {
+            _graph->release();
+        };
+    });
+
+    _geometryStage = std::make_unique<GeometryStage>(engine, _settings, _graph, _scene, _noiseTexture);
+    _temporalStage = std::make_unique<TemporalStage>(engine, _settings, _graph);
+    _denoiserStage = std::make_unique<DenoiserStage>(engine, _settings, _graph);
+    _upscalerStage = std::make_unique<UpscalerStage>(engine, _settings, _graph);
+    _blitStage = std::make_unique<BlitStage>(engine, _settings, _graph, *_windowRenderPass);
 
     _imguiRenderer = std::make_unique<ImguiRenderer>(engine, _windowRenderPass->renderPass);
+
+    _gpuTimer = std::make_unique<GpuTimer>(engine);
 }
 
 void VoxelRenderer::update(float delta)
@@ -40,7 +61,21 @@ void VoxelRenderer::update(float delta)
 
     _imguiRenderer->beginFrame();
     RecreationEventFlags flags = VoxelSettingsGui::draw(_settings);
-    VoxelPerformanceGui::draw(delta);
+    FrameStatistics stats = {};
+    stats.gpuFrameMs = _gpuTimer->lastFrameMs;
+    stats.renderResolution = _settings->renderResolution();
+    stats.pipelineCreation = engine->pipelineCache.stats();
+    stats.graphMemory = _graph->memory();
+    const LaneStatistics& lanes = _geometryStage->laneStatistics();
+    if (_settings->tracerSettings.collectLaneStats && lanes.valid)
+    {
+        stats.laneUtilization = lanes.utilization;
+        stats.primaryRays = lanes.primary;
+    }
+    const SampleMapStatistics& sampling = _geometryStage->sampleMapStatistics();
+    if (sampling.valid)
+        stats.ambientSampling = sampling;
+    VoxelPerformanceGui::draw(delta, stats);
     engine->recreationQueue->fire(flags);
     if (flags & RecreationEventFlags::SCENE_PATH)
     {
@@ -48,12 +83,221 @@ void VoxelRenderer::update(float delta)
         _scene = std::make_shared<VoxelScene>(engine, _settings->voxPath, _settings->skyboxPath);
 
         _geometryStage->destroy();
-        _geometryStage = std::make_unique<GeometryStage>(engine, _settings, _scene, _noiseTexture);
+        _geometryStage = std::make_unique<GeometryStage>(engine, _settings, _graph, _scene, _noiseTexture);
+    }
+}
+
+void VoxelRenderer::declareGraph()
+{
+    glm::uvec2 renderRes = _settings->maxRenderResolution();
+    glm::uvec2 targetRes = _settings->targetResolution;
+    vk::ImageUsageFlags gBufferUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage;
+    vk::ImageUsageFlags denoiserUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage;
+
+    // Every target is declared, so stage formats never change, but unused ones are free to alias anything
+    _graph->transient("Color", { renderRes, vk::Format::eR8G8B8A8Unorm, gBufferUsage });
+    // Half precision keeps UV-space motion within a fraction of a pixel at 4K
+    _graph->transient("Motion", { renderRes, vk::Format::eR16G16Sfloat, gBufferUsage });
+    _graph->transient("Mask", { renderRes, vk::Format::eR8Unorm, gBufferUsage });
+    // Ambient sample counts per pixel, as unorm so the graph's filtering samplers can read them
+    _graph->transient("Sample Map", { renderRes, vk::Format::eR8Unorm, vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled });
+    // Shadows and ambient occlusion traced below full resolution, of which quarter resolution uses the top left
+    glm::uvec2 reducedRes = (renderRes + 1u) / 2u;
+    // Where each tile's primary rays may start, and the atomic bounds it's resolved from
+    glm::uvec2 tileRes = (renderRes + glm::uvec2(DEPTH_TILE_SIZE - 1)) / glm::uvec2(DEPTH_TILE_SIZE);
+    _graph->transient("Depth Tile Bounds", { tileRes, vk::Format::eR32Uint, vk::ImageUsageFlagBits::eStorage });
+    _graph->transient("Depth Tiles", { tileRes, vk::Format::eR32Sfloat, vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled });
+    _graph->transient("Secondary Shadow", { reducedRes, vk::Format::eR8Unorm, vk::ImageUsageFlagBits::eStorage });
+    _graph->transient("Secondary Ambient", { reducedRes, vk::Format::eR8Unorm, vk::ImageUsageFlagBits::eStorage });
+    _graph->transient("Wavefront Radiance", { renderRes, vk::Format::eR32G32B32A32Sfloat, vk::ImageUsageFlagBits::eStorage });
+    _graph->transient("Wavefront Throughput", { renderRes, vk::Format::eR16G16B16A16Sfloat, vk::ImageUsageFlagBits::eStorage });
+    // Half precision, as the denoiser carries the filtered variance in alpha
+    _graph->transient("Denoiser Ping", { renderRes, vk::Format::eR16G16B16A16Sfloat, denoiserUsage });
+    _graph->transient("Denoiser Pong", { renderRes, vk::Format::eR16G16B16A16Sfloat, denoiserUsage });
+    _graph->transient("Upscaled", { targetRes, vk::Format::eR8G8B8A8Unorm, gBufferUsage });
+
+    // History is kept across frames by the stages which own it
+    _graph->external("Depth");
+    _graph->external("Normal");
+    _graph->external("Previous Depth");
+    _graph->external("Previous Normal");
+    _graph->external("Temporal History");
+    _graph->external("Previous Temporal History");
+    _graph->external("Temporal Moments");
+    _graph->external("Previous Temporal Moments");
+    _graph->external("Checkerboard History");
+    _graph->external("Previous Checkerboard History");
+    _graph->external("Upscaler History");
+    _graph->external("Previous Upscaler History");
+
+    // Noise is measured from the previous frame's moments whenever there are some, so the pass is skipped rather than undeclared
+    if (_settings->temporalSettings.enable)
+    {
+        _graph->pass("Sample Map")
+            .read("Previous Depth", ImageAccess::ComputeSampled)
+            .read("Previous Temporal Moments", ImageAccess::ComputeSampled)
+            .write("Sample Map", ImageAccess::ComputeStorage);
+    }
+
+    // Skipped while the previous depth isn't valid, in which case the tracers ignore the tiles
+    if (_settings->tracerSettings.reprojectedStart)
+    {
+        _graph->pass("Depth Tiles")
+            .read("Previous Depth", ImageAccess::ComputeSampled)
+            .write("Depth Tile Bounds", ImageAccess::ComputeStorage)
+            .write("Depth Tiles", ImageAccess::ComputeStorage);
+    }
+    if (_settings->tracerSettings.beamPrepass)
+    {
+        _graph->pass("Beam Prepass")
+            .write("Depth Tiles", ImageAccess::ComputeStorage);
+    }
+
+    const std::vector<std::string> gBuffer = { "Color", "Depth", "Motion", "Mask", "Normal" };
+    RenderGraphPass& geometry = _graph->pass("Geometry");
+    if (_settings->tracerSettings.wavefront)
+    {
+        for (const std::string& image : gBuffer)
+            geometry.write(image, ImageAccess::ComputeStorage);
+        geometry.read("Sample Map", ImageAccess::ComputeSampled)
+            .read("Depth Tiles", ImageAccess::ComputeSampled);
+        geometry.write("Wavefront Radiance", ImageAccess::ComputeStorage)
+            .write("Wavefront Throughput", ImageAccess::ComputeStorage);
+    }
+    else
+    {
+        for (const std::string& image : gBuffer)
+            geometry.write(image, ImageAccess::ColorAttachment);
+        geometry.read("Sample Map", ImageAccess::FragmentSampled)
+            .read("Depth Tiles", ImageAccess::FragmentSampled);
+    }
+
+    // Deferred effects are added to the color once the G-buffer is complete
+    if (_settings->secondaryRaysReduced())
+    {
+        _graph->pass("Secondary Rays")
+            .read("Depth", ImageAccess::ComputeSampled)
+            .read("Normal", ImageAccess::ComputeSampled)
+            .write("Secondary Shadow", ImageAccess::ComputeStorage)
+            .write("Secondary Ambient", ImageAccess::ComputeStorage);
+        _graph->pass("Secondary Upsample")
+            .read("Depth", ImageAccess::ComputeSampled)
+            .read("Normal", ImageAccess::ComputeSampled)
+            .read("Secondary Shadow", ImageAccess::ComputeStorage)
+            .read("Secondary Ambient", ImageAccess::ComputeStorage)
+            .write("Color", ImageAccess::ComputeStorage);
+    }
+
+    if (_settings->checkerboard.enable)
+    {
+        _graph->pass("Checkerboard")
+            .read("Previous Checkerboard History", ImageAccess::ComputeSampled)
+            .read("Previous Depth", ImageAccess::ComputeSampled)
+            .read("Previous Normal", ImageAccess::ComputeSampled)
+            .write("Color", ImageAccess::ComputeStorage)
+            .write("Depth", ImageAccess::ComputeStorage)
+            .write("Motion", ImageAccess::ComputeStorage)
+            .write("Mask", ImageAccess::ComputeStorage)
+            .write("Normal", ImageAccess::ComputeStorage)
+            .write("Checkerboard History", ImageAccess::ComputeStorage);
+    }
+
+    // Names of the images which may hold the current color, of which later passes read all
+    std::vector<std::string> color = { "Color" };
+    if (_settings->temporalSettings.enable)
+    {
+        _graph->pass("Temporal")
+            .read("Color", ImageAccess::FragmentSampled)
+            .read("Depth", ImageAccess::FragmentSampled)
+            .read("Normal", ImageAccess::FragmentSampled)
+            .read("Previous Temporal History", ImageAccess::FragmentSampled)
+            .read("Previous Depth", ImageAccess::FragmentSampled)
+            .read("Previous Normal", ImageAccess::FragmentSampled)
+            .read("Motion", ImageAccess::FragmentSampled)
+            .read("Previous Temporal Moments", ImageAccess::FragmentSampled)
+            .write("Temporal History", ImageAccess::ColorAttachment)
+            .write("Temporal Moments", ImageAccess::ColorAttachment);
+        color = { "Temporal History" };
+    }
+
+    // The iteration count changes without recompiling, so every iteration is declared, and either target may hold the result
+    if (_settings->denoiserSettings.enable)
+    {
+        const std::array<std::string, 2> pingPong = { "Denoiser Ping", "Denoiser Pong" };
+        bool compute = _settings->denoiserSettings.compute;
+        ImageAccess sampled = compute ? ImageAccess::ComputeSampled : ImageAccess::FragmentSampled;
+        for (uint32_t i = 0; i < MAX_DENOISER_PASSES; i++)
+        {
+            // The compute denoiser reads earlier iterations' results through the storage images it writes them with
+            RenderGraphPass& denoiser = _graph->pass(fmt::format("Denoiser {}", i));
+            if (i == 0 && _settings->temporalSettings.enable)
+                denoiser.read(color[0], sampled).read("Temporal Moments", sampled);
+            else if (i == 0)
+                denoiser.read(color[0], sampled);
+            else
+                denoiser.read(pingPong[(i - 1) % 2], compute ? ImageAccess::ComputeStorage : ImageAccess::FragmentSampled);
+            denoiser.read("Normal", sampled)
+                .read("Depth", sampled)
+                .write(pingPong[i % 2], compute ? ImageAccess::ComputeStorage : ImageAccess::ColorAttachment);
+        }
+        color = { pingPong.begin(), pingPong.end() };
+    }
+
+    if (_settings->fsrSetttings.enable)
+    {
+        RenderGraphPass& upscaler = _graph->pass("Upscaler");
+        for (const std::string& image : color)
+            upscaler.read(image, ImageAccess::ComputeSampled);
+        upscaler.read("Depth", ImageAccess::ComputeSampled)
+            .read("Motion", ImageAccess::ComputeSampled);
+        if (_settings->fsrSetttings.backend == UpscalerBackend::FSR2)
+        {
+            upscaler.read("Mask", ImageAccess::ComputeSampled)
+                .write("Upscaled", ImageAccess::ComputeStorage);
+        }
+        else
+        {
+            // The built-in upscaler sharpens from its history, which it keeps unsharpened
+            upscaler.read("Previous Upscaler History", ImageAccess::ComputeSampled)
+                .write("Upscaler History", ImageAccess::ComputeStorage);
+            _graph->pass("Upscaler Sharpen")
+                .read("Upscaler History", ImageAccess::ComputeStorage)
+                .write("Upscaled", ImageAccess::ComputeStorage);
+        }
+        color = { "Upscaled" };
     }
+
+    RenderGraphPass& blit = _graph->pass("Blit");
+    for (const std::string& image : color)
+        blit.read(image, ImageAccess::FragmentSampled);
+}
+
+void VoxelRenderer::updateResolutionScale()
+{
+    const DynamicResolutionSettings& drs = _settings->dynamicResolution;
+    if (!_settings->dynamicResolutionActive())
+    {
+        _settings->resolutionScale = 1.0f;
+        return;
+    }
+    if (!_gpuTimer->valid)
+        return;
+
+    // GPU time is roughly proportional to pixel count, so correct the scale by the square root of the error
+    float ratio = drs.targetFrameMs / glm::max(_gpuTimer->lastFrameMs, 0.01f);
+    float desiredScale = _settings->resolutionScale * glm::sqrt(ratio);
+
+    // Only move part of the way each frame, since timings are noisy and lag behind by a flight frame
+    float scale = glm::mix(_settings->resolutionScale, desiredScale, 0.1f);
+    _settings->resolutionScale = glm::clamp(scale, drs.minScale, 1.0f);
 }
 
 void VoxelRenderer::recordCommands(const vk::CommandBuffer& commandBuffer, uint32_t swapchainImage, uint32_t flightFrame)
 {
+    _gpuTimer->begin(commandBuffer, flightFrame);
+    updateResolutionScale();
+    _graph->beginFrame();
+
     vk::Viewport viewport;
     viewport.x = 0.0f;
     viewport.y = 0.0f;
@@ -76,19 +320,34 @@ void VoxelRenderer::recordCommands(const vk::CommandBuffer& commandBuffer, uint3
     constants.camDir = glm::vec4(_camera->direction, 0);
     constants.camUp = glm::vec4(_camera->up, 0);
     constants.camRight = glm::vec4(_camera->right, 0);
-    constants.frame = glm::uvec1(_upscalerStage->frameCount);
+    constants.frame = glm::uvec1(_frameIndex++);
     constants.cameraJitter.x = _upscalerStage->jitterX;
     constants.cameraJitter.y = _upscalerStage->jitterY;
 
     commandBuffer.pushConstants(_geometryStage->getPipelineLayout(), vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(ScreenQuadPush), &constants);
 
-    const GeometryBuffer& gBuffer = _geometryStage->record(commandBuffer, flightFrame);
+    // Camera matrices for reprojection
+    CameraParameters camera;
+    camera.viewProjection = _camera->viewProjection(_settings->renderResolution());
+    camera.prevViewProjection = _prevViewProjection.value_or(camera.viewProjection);
+    _prevViewProjection = camera.viewProjection;
 
-    const RenderImage& denoisedColor = _settings->denoiserSettings.enable ? _denoiserStage->record(commandBuffer, flightFrame,
-        gBuffer.color, gBuffer.normal, gBuffer.position) : gBuffer.color.get();
+    bool temporal = _settings->temporalSettings.enable;
+    const GeometryBuffer& gBuffer = _geometryStage->record(commandBuffer, flightFrame, camera, constants,
+        temporal ? &_temporalStage->previousMoments(flightFrame) : nullptr, temporal && _temporalStage->historyValid());
 
-    const RenderImage& upscaled = _settings->fsrSetttings.enable ? _upscalerStage->record(commandBuffer,
-        denoisedColor, gBuffer.depth, gBuffer.motion, gBuffer.mask) : denoisedColor;
+    if (!_settings->temporalSettings.enable)
+        _temporalStage->resetHistory();
+    const RenderImage& accumulatedColor = _settings->temporalSettings.enable ? _temporalStage->record(commandBuffer, flightFrame,
+        gBuffer, constants) : gBuffer.color.get();
+
+    const RenderImage& denoisedColor = _settings->denoiserSettings.enable ? _denoiserStage->record(commandBuffer, flightFrame, constants,
+        accumulatedColor, gBuffer.normal, gBuffer.depth, _settings->temporalSettings.enable ? &_temporalStage->moments(flightFrame) : nullptr) : accumulatedColor;
+
+    if (!_settings->fsrSetttings.enable)
+        _upscalerStage->resetHistory();
+    const RenderImage& upscaled = _settings->fsrSetttings.enable ? _upscalerStage->record(commandBuffer, flightFrame, constants,
+        denoisedColor, gBuffer) : denoisedColor;
 
     _blitStage->record(commandBuffer, flightFrame, upscaled, _windowFramebuffers[swapchainImage], *_windowRenderPass, [=](const vk::CommandBuffer& cmd) {_imguiRenderer->draw(cmd);});
 
@@ -102,4 +361,6 @@ void VoxelRenderer::recordCommands(const vk::CommandBuffer& commandBuffer, uint3
         vk::PipelineStageFlagBits::eColorAttachmentOutput,
         vk::PipelineStageFlagBits::eBottomOfPipe,
         vk::ImageAspectFlagBits::eColor);
+
+    _gpuTimer->end(commandBuffer, flightFrame);
 }
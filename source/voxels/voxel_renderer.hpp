@@ -6,11 +6,14 @@
 #include "voxel_render_settings.hpp"
 
 class GeometryStage;
+class TemporalStage;
 class BlitStage;
 class DenoiserStage;
 class UpscalerStage;
 class ImguiRenderer;
 class Texture2D;
+class GpuTimer;
+class RenderGraph;
 
 class VoxelRenderer : public ARenderer
 {
@@ -22,17 +25,31 @@ private:
     std::shared_ptr<VoxelScene> _scene;
     std::shared_ptr<Texture2D> _noiseTexture;
 
+    std::shared_ptr<RenderGraph> _graph;
+
     std::unique_ptr<GeometryStage> _geometryStage;
+    std::unique_ptr<TemporalStage> _temporalStage;
     std::unique_ptr<DenoiserStage> _denoiserStage;
     std::unique_ptr<UpscalerStage> _upscalerStage;
     std::unique_ptr<BlitStage> _blitStage;
 
     std::unique_ptr<ImguiRenderer> _imguiRenderer;
 
+    std::unique_ptr<GpuTimer> _gpuTimer;
+
     float _time = 0;
+    uint32_t _frameIndex = 0;
+
+    std::optional<glm::mat4> _prevViewProjection;
 
 public:
     VoxelRenderer(const std::shared_ptr<Engine>& engine);
     virtual void update(float delta) override;
     virtual void recordCommands(const vk::CommandBuffer& commandBuffer, uint32_t swapchainImage, uint32_t flightFrame) override;
+
+private:
+    // Declares the targets and passes of the enabled stages, in execution order
+    void declareGraph();
+    // Adjusts the render resolution towards the GPU frame time budget
+    void updateResolutionScale();
 };
@@ -35,6 +35,88 @@ static std::string scalingName(FsrScaling scaling)
     }
 }
 
+// FSR2 is only offered by builds which link it
+const std::vector<UpscalerBackend> backendOptions = {
+#ifdef VOXELS_ENABLE_FSR2
+    UpscalerBackend::FSR2,
+#endif
+    UpscalerBackend::TEMPORAL
+};
+
+static std::string backendName(UpscalerBackend backend)
+{
+    switch (backend)
+    {
+        case UpscalerBackend::FSR2:
+            return "FSR 2";
+        case UpscalerBackend::TEMPORAL:
+            return "Built-in Temporal";
+        default:
+            return "Invalid";
+    }
+}
+
+const std::vector<AmbientOcclusionMode> occlusionOptions = {
+    AmbientOcclusionMode::RAYS,
+    AmbientOcclusionMode::CONES
+};
+
+static std::string occlusionName(AmbientOcclusionMode mode)
+{
+    switch (mode)
+    {
+        case AmbientOcclusionMode::RAYS:
+            return "Rays";
+        case AmbientOcclusionMode::CONES:
+            return "Cones";
+        default:
+            return "Invalid";
+    }
+}
+
+const std::vector<SecondaryResolution> secondaryOptions = {
+    SecondaryResolution::FULL,
+    SecondaryResolution::HALF,
+    SecondaryResolution::QUARTER
+};
+
+static std::string secondaryName(SecondaryResolution resolution)
+{
+    switch (resolution)
+    {
+        case SecondaryResolution::FULL:
+            return "Full";
+        case SecondaryResolution::HALF:
+            return "Half";
+        case SecondaryResolution::QUARTER:
+            return "Quarter";
+        default:
+            return "Invalid";
+    }
+}
+
+// Secondary resolutions decide which passes the graph declares
+static bool secondaryCombo(const char* label, SecondaryResolution& resolution)
+{
+    bool changed = false;
+    if (ImGui::BeginCombo(label, secondaryName(resolution).c_str()))
+    {
+        for (const SecondaryResolution option : secondaryOptions)
+        {
+            if (ImGui::Selectable(secondaryName(option).c_str(), resolution == option) && resolution != option)
+            {
+                resolution = option;
+                changed = true;
+            }
+
+            if (resolution == option)
+                ImGui::SetItemDefaultFocus();
+        }
+        ImGui::EndCombo();
+    }
+    return changed;
+}
+
 const std::vector<glm::uvec2> resolutionOptions = {
     glm::uvec2(3840, 2160),
     glm::uvec2(2560, 1440),
@@ -74,6 +156,7 @@ RecreationEventFlags VoxelSettingsGui::draw(const std::shared_ptr<VoxelRenderSet
         if (ImGui::Checkbox("Enable FSR", &settings->fsrSetttings.enable))
         {
             flags |= RecreationEventFlags::RENDER_RESIZE;
+            flags |= RecreationEventFlags::RENDER_GRAPH;
         }
 
         if (ImGui::BeginCombo("FSR Quality", scalingName(settings->fsrSetttings.scaling).c_str()))
@@ -91,11 +174,80 @@ RecreationEventFlags VoxelSettingsGui::draw(const std::shared_ptr<VoxelRenderSet
             }
             ImGui::EndCombo();
         }
+
+        // Each backend keeps its own context or history at the target resolution
+        if (ImGui::BeginCombo("Upscaler", backendName(settings->fsrSetttings.backend).c_str()))
+        {
+            for (const UpscalerBackend backend: backendOptions)
+            {
+                if (ImGui::Selectable(backendName(backend).c_str(), settings->fsrSetttings.backend == backend))
+                {
+                    settings->fsrSetttings.backend = backend;
+                    flags |= RecreationEventFlags::TARGET_RESIZE;
+                    flags |= RecreationEventFlags::RENDER_GRAPH;
+                }
+
+                if (settings->fsrSetttings.backend == backend)
+                    ImGui::SetItemDefaultFocus();
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SliderFloat("Sharpness", &settings->fsrSetttings.sharpness, 0.0f, 1.0f);
+
+        // Render targets stay allocated at the FSR quality mode's resolution, so no recreation is needed
+        const char* dynamicUnavailable = settings->dynamicResolutionUnavailable();
+        ImGui::BeginDisabled(dynamicUnavailable != nullptr);
+        ImGui::Checkbox("Dynamic Resolution", &settings->dynamicResolution.enable);
+        if (dynamicUnavailable != nullptr && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+            ImGui::SetTooltip("%s", dynamicUnavailable);
+        ImGui::SliderFloat("Target GPU Time (ms)", &settings->dynamicResolution.targetFrameMs, 2.0f, 33.3f);
+        if (dynamicUnavailable != nullptr && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+            ImGui::SetTooltip("%s", dynamicUnavailable);
+        ImGui::SliderFloat("Minimum Scale", &settings->dynamicResolution.minScale, 0.25f, 1.0f);
+        if (dynamicUnavailable != nullptr && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+            ImGui::SetTooltip("%s", dynamicUnavailable);
+        ImGui::EndDisabled();
+
+        // Traces half the pixels each frame, reconstructing the rest from history
+        if (ImGui::Checkbox("Checkerboard Rendering", &settings->checkerboard.enable))
+            flags |= RecreationEventFlags::RENDER_GRAPH;
+        ImGui::SliderFloat("Checkerboard Threshold", &settings->checkerboard.positionThreshold, 0.0f, 0.1f, "%.4f");
+    }
+
+    if (ImGui::CollapsingHeader("Tracer", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        // Stages change which render graph passes run, so the graph is recompiled when they're toggled
+        if (ImGui::Checkbox("Wavefront Tracer", &settings->tracerSettings.wavefront))
+            flags |= RecreationEventFlags::RENDER_GRAPH;
+        if (ImGui::Checkbox("Reprojected Ray Start", &settings->tracerSettings.reprojectedStart))
+            flags |= RecreationEventFlags::RENDER_GRAPH;
+        if (ImGui::Checkbox("Beam Prepass", &settings->tracerSettings.beamPrepass))
+            flags |= RecreationEventFlags::RENDER_GRAPH;
+        ImGui::Checkbox("Tile Classification", &settings->tracerSettings.tileClassification);
+        ImGui::Checkbox("Reflection Roulette", &settings->tracerSettings.reflectionRoulette);
+        ImGui::Checkbox("Collect Lane Statistics", &settings->tracerSettings.collectLaneStats);
+        // Changing these builds a new fragment tracer pipeline in the background
+        ImGui::SliderInt("Max Ray Steps", &settings->tracerSettings.maxRaySteps, 64, 1024);
+        ImGui::SliderInt("Max Reflections", &settings->tracerSettings.maxReflections, 1, 8);
+    }
+
+    if (ImGui::CollapsingHeader("Temporal Accumulation", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        if (ImGui::Checkbox("Enable Accumulation", &settings->temporalSettings.enable))
+            flags |= RecreationEventFlags::RENDER_GRAPH;
+        ImGui::SliderFloat("Blend Factor", &settings->temporalSettings.blendFactor, 0.01f, 1.0f);
+        ImGui::SliderFloat("Position Threshold", &settings->temporalSettings.positionThreshold, 0.0f, 0.1f, "%.4f");
+        ImGui::SliderFloat("Normal Threshold", &settings->temporalSettings.normalThreshold, 0.0f, 1.0f);
     }
 
     if (ImGui::CollapsingHeader("Denoiser", ImGuiTreeNodeFlags_DefaultOpen))
     {
-        ImGui::Checkbox("Enable Denoiser", &settings->denoiserSettings.enable);
+        if (ImGui::Checkbox("Enable Denoiser", &settings->denoiserSettings.enable))
+            flags |= RecreationEventFlags::RENDER_GRAPH;
+        if (ImGui::Checkbox("Compute Denoiser", &settings->denoiserSettings.compute))
+            flags |= RecreationEventFlags::RENDER_GRAPH;
+        if (ImGui::Checkbox("Variance Guided", &settings->denoiserSettings.varianceGuided))
+            flags |= RecreationEventFlags::DENOISER_SETTINGS;
 
         ImGui::SliderInt("Denoiser Iterations", &settings->denoiserSettings.iterations, 1, 10);
 
@@ -104,6 +256,7 @@ RecreationEventFlags VoxelSettingsGui::draw(const std::shared_ptr<VoxelRenderSet
         denoiserParamsChanged |= ImGui::SliderFloat("Phi Normal", &settings->denoiserSettings.phiNormal0, 0.0f, 0.5f, "%.6f");
         denoiserParamsChanged |= ImGui::SliderFloat("Phi Position", &settings->denoiserSettings.phiPos0, 0.0f, 0.5f, "%.6f");
         denoiserParamsChanged |= ImGui::SliderFloat("Step Width", &settings->denoiserSettings.stepWidth, 0.0f, 5.0f, "%.6f");
+        denoiserParamsChanged |= ImGui::SliderFloat("Phi Luminance", &settings->denoiserSettings.phiLuminance, 0.0f, 16.0f, "%.6f");
         if (denoiserParamsChanged)
         {
             flags |= RecreationEventFlags::DENOISER_SETTINGS;
@@ -112,8 +265,34 @@ RecreationEventFlags VoxelSettingsGui::draw(const std::shared_ptr<VoxelRenderSet
 
     if (ImGui::CollapsingHeader("Ambient Occlusion", ImGuiTreeNodeFlags_DefaultOpen))
     {
+        if (ImGui::BeginCombo("Occlusion Mode", occlusionName(settings->occlusionSettings.mode).c_str()))
+        {
+            for (const AmbientOcclusionMode mode : occlusionOptions)
+            {
+                if (ImGui::Selectable(occlusionName(mode).c_str(), settings->occlusionSettings.mode == mode))
+                    settings->occlusionSettings.mode = mode;
+
+                if (settings->occlusionSettings.mode == mode)
+                    ImGui::SetItemDefaultFocus();
+            }
+            ImGui::EndCombo();
+        }
         ImGui::SliderInt("Occlusion Samples", &settings->occlusionSettings.numSamples, 0, 16);
         ImGui::SliderFloat("Ambient Intensity", &settings->occlusionSettings.intensity, 0.0f, 5.0f);
+        // Occlusion is only as detailed as a voxel face while cached, but converges over frames
+        ImGui::Checkbox("Cache Occlusion", &settings->occlusionSettings.cache);
+        // Disabled with the reason shown on hover whenever the other settings leave the sample map nothing to steer
+        const char* adaptiveUnavailable = settings->adaptiveSamplesUnavailable();
+        ImGui::BeginDisabled(adaptiveUnavailable != nullptr);
+        ImGui::Checkbox("Adaptive Samples", &settings->occlusionSettings.adaptive);
+        if (adaptiveUnavailable != nullptr && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+            ImGui::SetTooltip("%s", adaptiveUnavailable);
+        ImGui::SliderInt("Max Adaptive Samples", &settings->occlusionSettings.maxAdaptiveSamples, 1, 64);
+        if (adaptiveUnavailable != nullptr && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+            ImGui::SetTooltip("%s", adaptiveUnavailable);
+        ImGui::EndDisabled();
+        if (secondaryCombo("Occlusion Resolution", settings->occlusionSettings.resolution))
+            flags |= RecreationEventFlags::RENDER_GRAPH;
     }
 
     if (ImGui::CollapsingHeader("Directional Light"), ImGuiTreeNodeFlags_DefaultOpen)
@@ -121,6 +300,11 @@ RecreationEventFlags VoxelSettingsGui::draw(const std::shared_ptr<VoxelRenderSet
         ImGui::SliderFloat3("Light Direction", reinterpret_cast<float*>(&settings->lightSettings.direction), -1.0f, 1.0f);
         ImGui::ColorEdit4("Light Color", reinterpret_cast<float*>(&settings->lightSettings.color), ImGuiColorEditFlags_HDR);
         ImGui::SliderFloat("Light Intensity", &settings->lightSettings.intensity, 0.0f, 5.0f);
+        // Shadows are only as detailed as a voxel face while baked, but cost no rays
+        ImGui::Checkbox("Baked Shadows", &settings->lightSettings.bakedVisibility);
+        ImGui::SliderInt("Bake Slices per Frame", &settings->lightSettings.bakeSlicesPerFrame, 1, 64);
+        if (secondaryCombo("Shadow Resolution", settings->lightSettings.shadowResolution))
+            flags |= RecreationEventFlags::RENDER_GRAPH;
         settings->lightSettings.direction = glm::normalize(settings->lightSettings.direction);
     }
 
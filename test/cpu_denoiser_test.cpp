@@ -0,0 +1,266 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <fmt/format.h>
+#include "voxels/cpu/cpu_denoiser.hpp"
+#include "voxels/voxel_render_settings.hpp"
+
+// A camera facing a wall split into two faces down the middle, with noisy lighting
+static CpuDenoiserFrame makeFrame(glm::ivec2 size, float noise)
+{
+    CpuDenoiserFrame frame;
+    frame.size = size;
+    frame.screen.camPos = glm::vec4(0.0f, 0.0f, -10.0f, 0.0f);
+    frame.screen.camDir = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+    frame.screen.camRight = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+    frame.screen.camUp = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+    frame.screen.screenSize = size;
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> jitter(-noise, noise);
+    size_t pixels = static_cast<size_t>(size.x) * size.y;
+    frame.color.resize(pixels);
+    frame.normal.resize(pixels);
+    frame.depth.resize(pixels);
+    frame.variance.resize(pixels);
+    for (int32_t y = 0; y < size.y; y++)
+    {
+        for (int32_t x = 0; x < size.x; x++)
+        {
+            size_t i = static_cast<size_t>(y) * size.x + x;
+            bool left = x < size.x / 2;
+            float base = left ? 0.25f : 0.75f;
+            frame.color[i] = glm::vec4(base + jitter(random), base + jitter(random), base + jitter(random), 1.0f);
+            // -Z and +X faces
+            frame.normal[i] = left ? 5 : 2;
+            frame.depth[i] = 10.0f;
+            frame.variance[i] = noise * noise / 3.0f;
+        }
+    }
+    return frame;
+}
+
+static float maxDifference(const std::vector<glm::vec4>& a, const std::vector<glm::vec4>& b)
+{
+    float difference = 0.0f;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        glm::vec4 d = glm::abs(a[i] - b[i]);
+        difference = std::max({ difference, d.x, d.y, d.z, d.w });
+    }
+    return difference;
+}
+
+TEST_CASE("CPU denoiser keeps flat images unchanged", "[denoiser]")
+{
+    CpuDenoiserFrame frame = makeFrame({ 37, 23 }, 0.0f);
+    for (glm::vec4& color : frame.color)
+        color = glm::vec4(0.5f, 0.25f, 0.125f, 1.0f);
+    for (uint8_t& normal : frame.normal)
+        normal = 5;
+
+    DenoiserSettings settings;
+    settings.iterations = 3;
+    std::vector<glm::vec4> denoised = CpuDenoiser(CpuDenoiser::Backend::Scalar, 1).denoise(frame, settings);
+    for (const glm::vec4& color : denoised)
+    {
+        REQUIRE(color.r == Approx(0.5f));
+        REQUIRE(color.g == Approx(0.25f));
+        REQUIRE(color.b == Approx(0.125f));
+    }
+}
+
+TEST_CASE("CPU denoiser reduces noise without blurring across faces", "[denoiser]")
+{
+    CpuDenoiserFrame frame = makeFrame({ 64, 32 }, 0.1f);
+
+    for (bool varianceGuided : { false, true })
+    {
+        DenoiserSettings settings;
+        settings.iterations = 3;
+        settings.varianceGuided = varianceGuided;
+        std::vector<glm::vec4> denoised = CpuDenoiser(CpuDenoiser::Backend::Scalar, 1).denoise(frame, settings);
+
+        float inputError = 0.0f;
+        float outputError = 0.0f;
+        for (int32_t y = 0; y < frame.size.y; y++)
+        {
+            for (int32_t x = 0; x < frame.size.x; x++)
+            {
+                size_t i = static_cast<size_t>(y) * frame.size.x + x;
+                float expected = x < frame.size.x / 2 ? 0.25f : 0.75f;
+                inputError += std::abs(frame.color[i].r - expected);
+                outputError += std::abs(denoised[i].r - expected);
+                // Neighbours on the other face never contribute
+                REQUIRE(std::abs(denoised[i].r - expected) <= 0.1f);
+            }
+        }
+        REQUIRE(outputError < inputError * 0.5f);
+    }
+}
+
+// A 4x3 frame straddling a face edge, close enough to the camera that positions only partly stop the filter
+static CpuDenoiserFrame makeGoldenFrame()
+{
+    CpuDenoiserFrame frame = makeFrame({ 4, 3 }, 0.0f);
+    frame.color = {
+        glm::vec4(0.2f, 0.3f, 0.4f, 1.0f), glm::vec4(0.6f, 0.2f, 0.1f, 1.0f), glm::vec4(0.9f, 0.8f, 0.7f, 1.0f), glm::vec4(0.5f, 0.5f, 0.5f, 1.0f),
+        glm::vec4(0.1f, 0.1f, 0.1f, 1.0f), glm::vec4(0.4f, 0.5f, 0.6f, 1.0f), glm::vec4(0.3f, 0.9f, 0.2f, 1.0f), glm::vec4(0.8f, 0.6f, 0.9f, 1.0f),
+        glm::vec4(0.7f, 0.3f, 0.5f, 1.0f), glm::vec4(0.2f, 0.8f, 0.4f, 1.0f), glm::vec4(1.0f, 0.4f, 0.6f, 1.0f), glm::vec4(0.6f, 0.7f, 0.3f, 1.0f)
+    };
+    frame.depth = {
+        0.50f, 0.55f, 0.45f, 0.60f,
+        0.52f, 0.48f, 0.50f, 0.58f,
+        0.47f, 0.53f, 0.62f, 0.49f
+    };
+    frame.variance = {
+        0.01f, 0.04f, 0.02f, 0.09f,
+        0.03f, 0.05f, 0.01f, 0.02f,
+        0.06f, 0.02f, 0.04f, 0.03f
+    };
+    return frame;
+}
+
+TEST_CASE("Denoiser kernel and iteration parameters match what DenoiserStage uploads", "[denoiser]")
+{
+    // Gaussian with a standard deviation of 2 over a row-major 3x3 footprint
+    DenoiserKernel kernel = DenoiserKernel::build();
+    for (int32_t t = 0; t < DENOISER_KERNEL_SIZE; t++)
+    {
+        float x = static_cast<float>(t % 3 - 1);
+        float y = static_cast<float>(t / 3 - 1);
+        REQUIRE(kernel.offsets[t].x == x);
+        REQUIRE(kernel.offsets[t].y == y);
+        REQUIRE(kernel.weights[t].x == Approx(std::exp(-(x * x + y * y) / 8.0f)));
+    }
+
+    DenoiserSettings settings;
+    DenoiserParams first = denoiserIterationParams(settings, false, 0);
+    REQUIRE(first.phiColor == Approx(20.4f));
+    REQUIRE(first.phiNormal == Approx(1e-2f));
+    REQUIRE(first.phiPos == Approx(1e-1f));
+    REQUIRE(first.stepWidth == 1.0f);
+
+    DenoiserParams second = denoiserIterationParams(settings, true, 1);
+    REQUIRE(second.phiColor == Approx(10.2f));
+    REQUIRE(second.phiNormal == Approx(5e-3f));
+    REQUIRE(second.phiPos == Approx(5e-2f));
+    REQUIRE(second.stepWidth == 3.0f);
+    REQUIRE(second.phiLuminance == Approx(4.0f));
+    REQUIRE(second.varianceGuided == 1);
+}
+
+// Expected pixels were computed in double precision by following denoiser.frag and gbuffer.glsl tap by tap,
+// with the kernel and default iteration parameters checked above, over the two default iterations (step widths 1 and 3).
+// Taps past the frame edges clamp to it, as the fragment denoiser's clamp-to-edge sampler and texel clamping do.
+TEST_CASE("CPU denoiser matches the fragment denoiser on a golden frame", "[denoiser]")
+{
+    CpuDenoiserFrame frame = makeGoldenFrame();
+
+    const std::vector<glm::vec4> fixedWeights = {
+        glm::vec4(0.272731f, 0.261513f, 0.307522f, 0.000516f),
+        glm::vec4(0.375687f, 0.261366f, 0.268424f, 0.001729f),
+        glm::vec4(0.682207f, 0.693766f, 0.587657f, 0.002018f),
+        glm::vec4(0.605959f, 0.585995f, 0.583555f, 0.002262f),
+        glm::vec4(0.340579f, 0.290895f, 0.337930f, 0.000847f),
+        glm::vec4(0.363130f, 0.363183f, 0.357709f, 0.001714f),
+        glm::vec4(0.663100f, 0.674325f, 0.523178f, 0.001233f),
+        glm::vec4(0.653093f, 0.626915f, 0.564543f, 0.001031f),
+        glm::vec4(0.474980f, 0.363668f, 0.412734f, 0.001417f),
+        glm::vec4(0.399271f, 0.500700f, 0.426917f, 0.001767f),
+        glm::vec4(0.772622f, 0.572513f, 0.482848f, 0.002356f),
+        glm::vec4(0.676206f, 0.648112f, 0.445171f, 0.000886f),
+    };
+    const std::vector<glm::vec4> varianceGuided = {
+        glm::vec4(0.276509f, 0.263439f, 0.311169f, 0.000514f),
+        glm::vec4(0.384146f, 0.257611f, 0.261573f, 0.001855f),
+        glm::vec4(0.704956f, 0.717691f, 0.594309f, 0.002082f),
+        glm::vec4(0.589363f, 0.571568f, 0.573670f, 0.002634f),
+        glm::vec4(0.315772f, 0.263278f, 0.313483f, 0.000996f),
+        glm::vec4(0.375888f, 0.377798f, 0.376202f, 0.002664f),
+        glm::vec4(0.657902f, 0.687096f, 0.519063f, 0.001303f),
+        glm::vec4(0.653122f, 0.629574f, 0.564229f, 0.001024f),
+        glm::vec4(0.512084f, 0.358988f, 0.431094f, 0.001665f),
+        glm::vec4(0.383121f, 0.551184f, 0.435913f, 0.002049f),
+        glm::vec4(0.790684f, 0.558901f, 0.491652f, 0.002727f),
+        glm::vec4(0.671681f, 0.651864f, 0.442752f, 0.000907f),
+    };
+
+    std::vector<CpuDenoiser> denoisers = { CpuDenoiser(CpuDenoiser::Backend::Scalar, 1) };
+    if (CpuDenoiser::avx2Supported())
+        denoisers.emplace_back(CpuDenoiser::Backend::Avx2, 1);
+
+    for (const CpuDenoiser& denoiser : denoisers)
+    {
+        for (bool guided : { false, true })
+        {
+            DenoiserSettings settings;
+            settings.varianceGuided = guided;
+            std::vector<glm::vec4> denoised = denoiser.denoise(frame, settings);
+            const std::vector<glm::vec4>& expected = guided ? varianceGuided : fixedWeights;
+
+            REQUIRE(denoised.size() == expected.size());
+            for (size_t i = 0; i < expected.size(); i++)
+            {
+                INFO("pixel " << i << ", variance guided " << guided);
+                for (glm::length_t c = 0; c < 4; c++)
+                    REQUIRE(denoised[i][c] == Approx(expected[i][c]).margin(1e-5));
+            }
+        }
+    }
+}
+
+TEST_CASE("CPU denoiser backends match the scalar reference", "[denoiser]")
+{
+    if (!CpuDenoiser::avx2Supported())
+        WARN("AVX2 is not supported, so only threading is compared");
+
+    // Odd sizes leave partial spans at the end of each row
+    CpuDenoiserFrame frame = makeFrame({ 203, 61 }, 0.2f);
+
+    for (bool varianceGuided : { false, true })
+    {
+        DenoiserSettings settings;
+        settings.iterations = 4;
+        settings.varianceGuided = varianceGuided;
+        std::vector<glm::vec4> reference = CpuDenoiser(CpuDenoiser::Backend::Scalar, 1).denoise(frame, settings);
+
+        REQUIRE(maxDifference(CpuDenoiser(CpuDenoiser::Backend::Scalar, 7).denoise(frame, settings), reference) == 0.0f);
+        if (CpuDenoiser::avx2Supported())
+            REQUIRE(maxDifference(CpuDenoiser(CpuDenoiser::Backend::Avx2, 7).denoise(frame, settings), reference) < 1e-4f);
+    }
+}
+
+TEST_CASE("CPU denoiser throughput", "[.][benchmark][denoiser]")
+{
+    uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<std::pair<std::string, CpuDenoiser>> denoisers = {
+        { "scalar, 1 thread", CpuDenoiser(CpuDenoiser::Backend::Scalar, 1) },
+        { fmt::format("scalar, {} threads", threads), CpuDenoiser(CpuDenoiser::Backend::Scalar, threads) }
+    };
+    if (CpuDenoiser::avx2Supported())
+        denoisers.emplace_back(fmt::format("AVX2, {} threads", threads), CpuDenoiser(CpuDenoiser::Backend::Avx2, threads));
+
+    for (glm::ivec2 size : { glm::ivec2(1920, 1080), glm::ivec2(3840, 2160) })
+    {
+        CpuDenoiserFrame frame = makeFrame(size, 0.2f);
+        DenoiserSettings settings;
+
+        for (const auto& entry : denoisers)
+        {
+            // Includes converting the frame to planes and reconstructing positions, as any caller pays for both
+            auto start = std::chrono::steady_clock::now();
+            entry.second.denoise(frame, settings);
+            float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+            float mpixels = static_cast<float>(size.x) * size.y / 1e6f;
+            WARN(fmt::format("{}x{}, {} iterations, {}: {:.1f} Mpixels/s", size.x, size.y, settings.iterations, entry.first, mpixels / seconds));
+        }
+    }
+}